@@ -0,0 +1,76 @@
+////关联容器的通用测试：insert / lookup / erase 按三种分布各测一次，iterate / copy / destroy 与分布无关。
+////M 只需要提供 insert(value_type)、find、end、erase(iterator)、begin 与拷贝构造，
+////sjtu 的各个 map / hashmap 与 std::map、std::unordered_map 都满足。
+#ifndef SJTU_BENCH_ASSOC_SUITE_HPP
+#define SJTU_BENCH_ASSOC_SUITE_HPP
+
+#include "bench.hpp"
+
+namespace bench {
+
+    template<class M, class K>
+    void AssocSuite(Reporter &rep, const Options &opt, const char *container, const char *impl) {
+        const char *key = KeyGen<K>::name();
+        for(size_t n : opt.sizes()){
+            std::vector<K> keys = MakeKeys<K>(n);
+            size_t queries = n < 4096 ? 4096 : n;
+            M base;
+            for(size_t i = 0; i < n; ++i) base.insert(typename M::value_type(keys[i], i));
+            for(Dist d : AllDists){
+                std::vector<size_t> order = Order(n, d);
+                Run(rep, opt, Make(container, impl, "insert", key, DistName(d), n), n, [&]{
+                    M *m = new M;
+                    unsigned long long t0 = NowNs();
+                    for(size_t i = 0; i < n; ++i) m->insert(typename M::value_type(keys[order[i]], i));
+                    unsigned long long t1 = NowNs();
+                    delete m;
+                    return t1 - t0;
+                });
+                std::vector<size_t> idx = Indices(n, queries, d);
+                Run(rep, opt, Make(container, impl, "lookup", key, DistName(d), n), queries, [&]{
+                    size_t sum = 0;
+                    unsigned long long t0 = NowNs();
+                    for(size_t i = 0; i < queries; ++i){
+                        auto it = base.find(keys[idx[i]]);
+                        if(it != base.end()) sum += it->second;
+                    }
+                    unsigned long long t1 = NowNs();
+                    DoNotOptimize(sum);
+                    return t1 - t0;
+                });
+                Run(rep, opt, Make(container, impl, "erase", key, DistName(d), n), n, [&]{
+                    M *m = new M(base);
+                    unsigned long long t0 = NowNs();
+                    for(size_t i = 0; i < n; ++i) m->erase(m->find(keys[order[i]]));
+                    unsigned long long t1 = NowNs();
+                    delete m;
+                    return t1 - t0;
+                });
+            }
+            Run(rep, opt, Make(container, impl, "iterate", key, "sequential", n), n, [&]{
+                size_t sum = 0;
+                unsigned long long t0 = NowNs();
+                for(auto it = base.begin(); it != base.end(); ++it) sum += it->second;
+                unsigned long long t1 = NowNs();
+                DoNotOptimize(sum);
+                return t1 - t0;
+            });
+            Run(rep, opt, Make(container, impl, "copy", key, "sequential", n), n, [&]{
+                unsigned long long t0 = NowNs();
+                M *m = new M(base);
+                unsigned long long t1 = NowNs();
+                delete m;
+                return t1 - t0;
+            });
+            Run(rep, opt, Make(container, impl, "destroy", key, "sequential", n), n, [&]{
+                M *m = new M(base);
+                unsigned long long t0 = NowNs();
+                delete m;
+                return NowNs() - t0;
+            });
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,13 @@
+////linked_hashmap 的 find_batch 与逐个 find 对比
+#include <string>
+#include "bench.hpp"
+#include "batch_suite.hpp"
+#include "linked_hashmap.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::BatchSuite<sjtu::linked_hashmap<int, size_t>, int>(rep, opt, "batch_hashmap", "linked_hashmap");
+    bench::BatchSuite<sjtu::linked_hashmap<std::string, size_t>, std::string>(rep, opt, "batch_hashmap", "linked_hashmap");
+    return 0;
+}
@@ -0,0 +1,19 @@
+////有序 map 的 find_batch 与逐个 find 对比：sjtu::map、flat_map 与 topdown_map
+#include <string>
+#include "bench.hpp"
+#include "batch_suite.hpp"
+#include "map.hpp"
+#include "flat_map.hpp"
+#include "topdown_map.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::BatchSuite<sjtu::map<int, size_t>, int>(rep, opt, "batch_map", "map");
+    bench::BatchSuite<sjtu::flat_map<int, size_t>, int>(rep, opt, "batch_map", "flat_map");
+    bench::BatchSuite<sjtu::topdown_map<int, size_t>, int>(rep, opt, "batch_map", "topdown_map");
+    bench::BatchSuite<sjtu::map<std::string, size_t>, std::string>(rep, opt, "batch_map", "map");
+    bench::BatchSuite<sjtu::flat_map<std::string, size_t>, std::string>(rep, opt, "batch_map", "flat_map");
+    bench::BatchSuite<sjtu::topdown_map<std::string, size_t>, std::string>(rep, opt, "batch_map", "topdown_map");
+    return 0;
+}
@@ -0,0 +1,54 @@
+////批量查找 find_batch 与逐个 find 的对比：同一组查询键，find_loop 逐个调用 find，
+////find_batch 一次交给容器，由容器交错推进多个查找、提前预取下一步要访问的结点。
+////查询全部命中，按 uniform 与 zipf 两种分布抽取。find_batch 每次交给容器 Chunk 个键，结果写入一个小缓冲区，
+////与实际使用时分段处理查询的方式一致，也避免把 n 个迭代器写回内存的开销算进去。
+////M 需要提供 find_batch(const Key *, size_t, iterator *)
+#ifndef SJTU_BENCH_BATCH_SUITE_HPP
+#define SJTU_BENCH_BATCH_SUITE_HPP
+
+#include "bench.hpp"
+
+namespace bench {
+
+    const size_t Chunk = 256;
+
+    template<class M, class K>
+    void BatchSuite(Reporter &rep, const Options &opt, const char *container, const char *impl) {
+        const char *key = KeyGen<K>::name();
+        for(size_t n : opt.sizes()){
+            std::vector<K> keys = MakeKeys<K>(n);
+            size_t queries = n < 4096 ? 4096 : n;
+            M m;
+            for(size_t i = 0; i < n; ++i) m.insert(typename M::value_type(keys[i], i));
+            std::vector<typename M::iterator> out(Chunk);
+            for(Dist d : {UNIFORM, ZIPF}){
+                std::vector<size_t> idx = Indices(n, queries, d);
+                std::vector<K> query(queries);
+                for(size_t i = 0; i < queries; ++i) query[i] = keys[idx[i]];
+                Run(rep, opt, Make(container, impl, "find_loop", key, DistName(d), n), queries, [&]{
+                    size_t sum = 0;
+                    unsigned long long t0 = NowNs();
+                    for(size_t i = 0; i < queries; ++i) sum += m.find(query[i])->second;
+                    unsigned long long t1 = NowNs();
+                    DoNotOptimize(sum);
+                    return t1 - t0;
+                });
+                Run(rep, opt, Make(container, impl, "find_batch", key, DistName(d), n), queries, [&]{
+                    size_t sum = 0;
+                    unsigned long long t0 = NowNs();
+                    for(size_t base = 0; base < queries; base += Chunk){
+                        size_t cnt = queries - base < Chunk ? queries - base : Chunk;
+                        m.find_batch(query.data() + base, cnt, out.data());
+                        for(size_t i = 0; i < cnt; ++i) sum += out[i]->second;
+                    }
+                    unsigned long long t1 = NowNs();
+                    DoNotOptimize(sum);
+                    return t1 - t0;
+                });
+            }
+        }
+    }
+
+}
+
+#endif
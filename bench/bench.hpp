@@ -0,0 +1,361 @@
+////基准测试的公共部分：计时、键的生成与访问分布、命令行参数、JSON 输出
+////不依赖任何容器头文件，每个 *_bench.cpp 只和它所测容器的目录一起编译。
+////输出格式仿照 google benchmark 的 JSON：{"context": {...}, "benchmarks": [{...}, ...]}，
+////每条记录的 real_time 是单次操作的平均耗时（纳秒），另附容器、操作、键类型、分布、规模等字段。
+#ifndef SJTU_BENCH_HPP
+#define SJTU_BENCH_HPP
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace bench {
+
+    inline unsigned long long NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //阻止编译器把只为计时而算出的结果优化掉
+    template<class T>
+    inline void DoNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T *sink;
+        sink = &value;
+#endif
+    }
+    inline void ClobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+    //splitmix64，状态只有一个整数，足够生成测试数据
+    class Random {
+        unsigned long long state;
+    public:
+        explicit Random(unsigned long long seed = 20260301) : state(seed) {}
+        unsigned long long next() {
+            unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+        //[0, n) 上的均匀整数
+        size_t below(size_t n) {
+            return (size_t) ((unsigned __int128) next() * n >> 64);
+        }
+        double uniform() {
+            return (next() >> 11) * (1.0 / 9007199254740992.0);
+        }
+    };
+
+    /**
+     * [0, n) 上的 Zipf 分布（Gray 等人的生成方法，与 YCSB 相同），theta 默认 0.99。
+     * 构造时 O(n) 求一次 zeta(n)；排名再经过一个双射打散，热点不集中在最小的几个下标上
+     */
+    class Zipf {
+        size_t n;
+        double theta, alpha, zetan, eta;
+    public:
+        Zipf(size_t items, double t = 0.99) : n(items ? items : 1), theta(t) {
+            zetan = 0;
+            for(size_t i = 1; i <= n; ++i) zetan += 1.0 / std::pow((double) i, theta);
+            double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+            alpha = 1.0 / (1.0 - theta);
+            eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+        }
+        size_t next(Random &rng) const {
+            double u = rng.uniform(), uz = u * zetan;
+            size_t rank;
+            if(uz < 1.0) rank = 0;
+            else if(uz < 1.0 + std::pow(0.5, theta)) rank = 1;
+            else{
+                rank = (size_t) (n * std::pow(eta * u - eta + 1.0, alpha));
+                if(rank >= n) rank = n - 1;
+            }
+            //2654435761 是素数，n 不是它的倍数时乘法取模是 [0, n) 上的双射
+            return (size_t) ((unsigned __int128) rank * 2654435761ULL % n);
+        }
+    };
+
+    enum Dist { SEQUENTIAL, UNIFORM, ZIPF };
+    inline const char *DistName(Dist d) {
+        return d == SEQUENTIAL ? "sequential" : d == UNIFORM ? "uniform" : "zipf";
+    }
+    const Dist AllDists[] = {SEQUENTIAL, UNIFORM, ZIPF};
+
+    /**
+     * 按分布生成 m 个 [0, n) 内的下标：sequential 为 0, 1, 2, ...（循环），
+     * uniform 为均匀随机，zipf 为少数热点占大多数访问
+     */
+    inline std::vector<size_t> Indices(size_t n, size_t m, Dist d, unsigned long long seed = 1) {
+        std::vector<size_t> res(m);
+        Random rng(seed);
+        if(d == SEQUENTIAL){
+            for(size_t i = 0; i < m; ++i) res[i] = i % n;
+        }
+        else if(d == UNIFORM){
+            for(size_t i = 0; i < m; ++i) res[i] = rng.below(n);
+        }
+        else{
+            Zipf z(n);
+            for(size_t i = 0; i < m; ++i) res[i] = z.next(rng);
+        }
+        return res;
+    }
+    /**
+     * 0..n-1 的一个排列：sequential 为升序，uniform 为随机洗牌，
+     * zipf 先按 Zipf 抽样的顺序放入首次出现的下标，再把没抽到的按随机顺序补在后面
+     */
+    inline std::vector<size_t> Order(size_t n, Dist d, unsigned long long seed = 2) {
+        std::vector<size_t> res(n);
+        Random rng(seed);
+        for(size_t i = 0; i < n; ++i) res[i] = i;
+        if(d == SEQUENTIAL) return res;
+        for(size_t i = n; i > 1; --i){
+            size_t j = rng.below(i);
+            size_t t = res[i - 1]; res[i - 1] = res[j]; res[j] = t;
+        }
+        if(d == UNIFORM) return res;
+        std::vector<char> seen(n, 0);
+        std::vector<size_t> head;
+        Zipf z(n);
+        for(size_t i = 0; i < n; ++i){
+            size_t k = z.next(rng);
+            if(!seen[k]){
+                seen[k] = 1;
+                head.push_back(k);
+            }
+        }
+        for(size_t i = 0; i < n; ++i)
+            if(!seen[res[i]]) head.push_back(res[i]);
+        return head;
+    }
+
+    //键类型：KeyGen<K>::make(i) 把下标 i 变成互不相同的键，且 i 越大键越大，sequential 即按键升序；name 用于报告
+    template<class K> struct KeyGen;
+    template<> struct KeyGen<int> {
+        static const char *name() {return "int";}
+        static int make(size_t i) {return (int) i;}
+    };
+    template<> struct KeyGen<unsigned long long> {
+        static const char *name() {return "u64";}
+        static unsigned long long make(size_t i) {return i;}
+    };
+    //24 个字符：超过常见实现的短字符串优化，比较与哈希都要读内存；公共前缀让比较多走几个字节
+    template<> struct KeyGen<std::string> {
+        static const char *name() {return "string";}
+        static std::string make(size_t i) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "key-%020zu", i);
+            return buf;
+        }
+    };
+    template<class K>
+    std::vector<K> MakeKeys(size_t n) {
+        std::vector<K> res;
+        res.reserve(n);
+        for(size_t i = 0; i < n; ++i) res.push_back(KeyGen<K>::make(i));
+        return res;
+    }
+
+    /**
+     * 命令行参数：
+     *   --min-size=N / --max-size=N  规模范围，按 10 倍递增，默认 100 到 1000000，最大可到 1e8
+     *   --filter=S                   只运行名字中含有 S 的条目
+     *   --min-time=SEC               每个条目至少累计运行的时间，默认 0.1 秒
+     *   --threads=N                  多线程条目的最大线程数，默认 64
+     *   --out=FILE                   JSON 写入 FILE，默认写到标准输出
+     */
+    struct Options {
+        size_t minSize = 100, maxSize = 1000000;
+        std::string filter;
+        double minTime = 0.1;
+        unsigned maxThreads = 64;
+        std::string out;
+
+        Options(int argc, char **argv) {
+            for(int i = 1; i < argc; ++i){
+                const char *a = argv[i];
+                if(!strncmp(a, "--min-size=", 11)) minSize = (size_t) atof(a + 11);
+                else if(!strncmp(a, "--max-size=", 11)) maxSize = (size_t) atof(a + 11);
+                else if(!strncmp(a, "--filter=", 9)) filter = a + 9;
+                else if(!strncmp(a, "--min-time=", 11)) minTime = atof(a + 11);
+                else if(!strncmp(a, "--threads=", 10)) maxThreads = (unsigned) atoi(a + 10);
+                else if(!strncmp(a, "--out=", 6)) out = a + 6;
+                else{
+                    fprintf(stderr, "unknown option %s\n", a);
+                    exit(2);
+                }
+            }
+            if(minSize < 1) minSize = 1;
+        }
+        std::vector<size_t> sizes() const {
+            std::vector<size_t> res;
+            for(size_t n = 1; n <= maxSize; n *= 10)
+                if(n >= minSize) res.push_back(n);
+            return res;
+        }
+        //1, 2, 4, ... 直到 maxThreads
+        std::vector<unsigned> threads() const {
+            std::vector<unsigned> res;
+            for(unsigned t = 1; t <= maxThreads; t <<= 1) res.push_back(t);
+            return res;
+        }
+        bool selected(const std::string &name) const {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+    };
+
+    /**
+     * 一条结果。name 形如 "map/insert/int/uniform/1000"，便于过滤与对比；
+     * counters 放额外的数值，例如每个元素占用的字节数或延迟分位数
+     */
+    struct Record {
+        std::string name, container, impl, op, key, dist;
+        size_t n = 0;
+        unsigned threads = 1;
+        unsigned long long iterations = 0; //累计执行的操作次数
+        double nsPerOp = 0;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    class Reporter {
+        std::vector<Record> records;
+        const Options &opt;
+
+        static void Escape(FILE *f, const std::string &s) {
+            fputc('"', f);
+            for(char c : s){
+                if(c == '"' || c == '\\') fputc('\\', f);
+                fputc(c, f);
+            }
+            fputc('"', f);
+        }
+    public:
+        explicit Reporter(const Options &o) : opt(o) {}
+        void add(Record r) {
+            fprintf(stderr, "%-60s %12.2f ns/op\n", r.name.c_str(), r.nsPerOp);
+            records.push_back(std::move(r));
+        }
+        //给最近加入的一条结果补充计数器，用于 Run 结束后才能算出的量
+        void annotate(const std::string &name, double value) {
+            if(!records.empty()) records.back().counters.push_back({name, value});
+        }
+        ~Reporter() {
+            FILE *f = opt.out.empty() ? stdout : fopen(opt.out.c_str(), "w");
+            if(!f){
+                perror(opt.out.c_str());
+                return;
+            }
+            char host[256] = "unknown", date[64] = "";
+            gethostname(host, sizeof(host) - 1);
+            time_t now = time(nullptr);
+            strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+            fprintf(f, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"host_name\": ", date);
+            Escape(f, host);
+            fprintf(f, ",\n    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+            fprintf(f, "    \"library_build_type\": \"release\"\n  },\n");
+#else
+            fprintf(f, "    \"library_build_type\": \"debug\"\n  },\n");
+#endif
+            fprintf(f, "  \"benchmarks\": [");
+            for(size_t i = 0; i < records.size(); ++i){
+                const Record &r = records[i];
+                fprintf(f, "%s\n    {\"name\": ", i ? "," : "");
+                Escape(f, r.name);
+                fprintf(f, ", \"container\": "); Escape(f, r.container);
+                fprintf(f, ", \"impl\": "); Escape(f, r.impl);
+                fprintf(f, ", \"op\": "); Escape(f, r.op);
+                fprintf(f, ", \"key\": "); Escape(f, r.key);
+                fprintf(f, ", \"dist\": "); Escape(f, r.dist);
+                fprintf(f, ", \"n\": %zu, \"threads\": %u, \"iterations\": %llu, \"real_time\": %.3f, \"time_unit\": \"ns\"",
+                        r.n, r.threads, r.iterations, r.nsPerOp);
+                fprintf(f, ", \"items_per_second\": %.1f", r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0.0);
+                for(const auto &c : r.counters){
+                    fprintf(f, ", ");
+                    Escape(f, c.first);
+                    fprintf(f, ": %.3f", c.second);
+                }
+                fprintf(f, "}");
+            }
+            fprintf(f, "\n  ]\n}\n");
+            if(f != stdout) fclose(f);
+        }
+    };
+
+    /**
+     * 反复调用 once() 直到计入的时间达到 minTime（至少一次）。
+     * once() 自己计时并返回这一轮的纳秒数，这样建表、析构等准备工作可以不计入；
+     * 准备工作远比被测部分慢时，墙上时间达到 10 倍 minTime 也会停止。
+     * opsPerRound 是一轮里的操作次数，结果为每次操作的平均纳秒数
+     */
+    template<class F>
+    void Run(Reporter &rep, const Options &opt, Record r, size_t opsPerRound, F once) {
+        if(!opt.selected(r.name)) return;
+        unsigned long long total = 0, rounds = 0, start = NowNs();
+        const unsigned long long budget = (unsigned long long) (opt.minTime * 1e9);
+        do{
+            total += once();
+            rounds++;
+        }while(total < budget && NowNs() - start < budget * 10);
+        r.iterations = rounds * opsPerRound;
+        r.nsPerOp = r.iterations ? (double) total / r.iterations : 0;
+        rep.add(std::move(r));
+    }
+
+    inline Record Make(const std::string &container, const std::string &impl, const std::string &op,
+                       const std::string &key, const std::string &dist, size_t n, unsigned threads = 1) {
+        Record r;
+        r.container = container;
+        r.impl = impl;
+        r.op = op;
+        r.key = key;
+        r.dist = dist;
+        r.n = n;
+        r.threads = threads;
+        r.name = container + "/" + impl + "/" + op + "/" + key + "/" + dist + "/" + std::to_string(n);
+        if(threads != 1) r.name += "/threads:" + std::to_string(threads);
+        return r;
+    }
+
+    //当前进程的常驻内存（字节），读 /proc/self/statm；读不到返回 0
+    inline size_t ResidentBytes() {
+        FILE *f = fopen("/proc/self/statm", "r");
+        if(!f) return 0;
+        unsigned long long pages = 0, rss = 0;
+        if(fscanf(f, "%llu %llu", &pages, &rss) != 2) rss = 0;
+        fclose(f);
+        return (size_t) (rss * (unsigned long long) sysconf(_SC_PAGESIZE));
+    }
+
+    /**
+     * 堆上正在使用的字节数（含分配器的块头与直接 mmap 的大块），glibc 2.33 及以上读 mallinfo2，否则退回 ResidentBytes。
+     * 释放的内存不会还给系统，前后两次的差值比常驻内存更能反映一批对象实际占用的空间
+     */
+    inline size_t HeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 mi = mallinfo2();
+        return mi.uordblks + mi.hblkhd;
+#else
+        return ResidentBytes();
+#endif
+    }
+
+}
+
+#endif
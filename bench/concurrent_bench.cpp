@@ -0,0 +1,99 @@
+////concurrent_linked_hashmap 的多线程吞吐：线程数 1, 2, 4, ... 到 --threads，
+////以一把互斥锁保护整张 linked_hashmap 为参照。
+////键空间为 2n，预先放入其中 n 个；每轮固定总操作数平均分给各线程（强扩展），
+////read_heavy 为 90% find / 5% insert / 5% erase，mixed 为 50% find / 25% insert / 25% erase，
+////insert 与 erase 各占一半，表的大小大致保持在 n。结果为总耗时除以总操作数
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "bench.hpp"
+#include "linked_hashmap.hpp"
+#include "concurrent_linked_hashmap.hpp"
+
+using namespace bench;
+
+//整张表一把锁
+template<class Key, class T>
+class locked_linked_hashmap {
+    mutable std::mutex lock;
+    sjtu::linked_hashmap<Key, T> table;
+public:
+    bool insert(const Key &key, const T &value) {
+        std::lock_guard<std::mutex> guard(lock);
+        return table.try_emplace(key, value).second;
+    }
+    bool find(const Key &key, T &out) const {
+        std::lock_guard<std::mutex> guard(lock);
+        auto res = table.find(key);
+        if(res == table.cend()) return false;
+        out = res->second;
+        return true;
+    }
+    bool erase(const Key &key) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto res = table.find(key);
+        if(res == table.end()) return false;
+        table.erase(res);
+        return true;
+    }
+};
+
+enum Op : unsigned char { FIND, INSERT, ERASE };
+
+struct Workload {
+    const char *name;
+    unsigned findPercent; //其余平分给 insert 与 erase
+};
+const Workload Workloads[] = {{"read_heavy", 90}, {"mixed", 50}};
+
+template<class M>
+void ConcurrentSuite(Reporter &rep, const Options &opt, const char *impl) {
+    const size_t total = 1 << 18;
+    for(size_t n : opt.sizes()){
+        std::vector<int> keys = MakeKeys<int>(2 * n);
+        for(const Workload &w : Workloads)
+            for(Dist d : {UNIFORM, ZIPF}){
+                //操作序列与线程数无关，各线程取其中连续的一段
+                std::vector<size_t> idx = Indices(2 * n, total, d, 3);
+                std::vector<Op> ops(total);
+                Random rng(4);
+                for(size_t i = 0; i < total; ++i){
+                    size_t r = rng.below(200);
+                    ops[i] = r < w.findPercent * 2 ? FIND : (r & 1) ? INSERT : ERASE;
+                }
+                M *m = new M;
+                for(size_t i = 0; i < n; ++i) m->insert(keys[2 * i], i);
+                for(unsigned t : opt.threads())
+                    Run(rep, opt, Make("concurrent", impl, w.name, "int", DistName(d), n, t), total, [&]{
+                        std::atomic<bool> go{false};
+                        std::vector<std::thread> pool;
+                        for(unsigned k = 0; k < t; ++k)
+                            pool.emplace_back([&, k]{
+                                size_t lo = total * k / t, hi = total * (k + 1) / t, sum = 0, out;
+                                while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                                for(size_t i = lo; i < hi; ++i){
+                                    const int &key = keys[idx[i]];
+                                    if(ops[i] == FIND) sum += m->find(key, out);
+                                    else if(ops[i] == INSERT) sum += m->insert(key, i);
+                                    else sum += m->erase(key);
+                                }
+                                DoNotOptimize(sum);
+                            });
+                        //线程创建不计入
+                        unsigned long long t0 = NowNs();
+                        go.store(true, std::memory_order_release);
+                        for(std::thread &th : pool) th.join();
+                        return NowNs() - t0;
+                    });
+                delete m;
+            }
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    ConcurrentSuite<sjtu::concurrent_linked_hashmap<int, size_t>>(rep, opt, "sharded");
+    ConcurrentSuite<locked_linked_hashmap<int, size_t>>(rep, opt, "single_mutex");
+    return 0;
+}
@@ -0,0 +1,13 @@
+////sjtu::linked_hashmap 与 std::unordered_map 插入 256 字节大对象值：operator[]、try_emplace 与 insert(value_type) 对比
+#include <unordered_map>
+#include "bench.hpp"
+#include "emplace_suite.hpp"
+#include "linked_hashmap.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::EmplaceSuite<sjtu::linked_hashmap<int, bench::Big>, int>(rep, opt, "emplace_hashmap", "sjtu");
+    bench::EmplaceSuite<std::unordered_map<int, bench::Big>, int>(rep, opt, "emplace_hashmap", "std");
+    return 0;
+}
@@ -0,0 +1,13 @@
+////sjtu::map 与 std::map 插入 256 字节大对象值：operator[]、try_emplace 与 insert(value_type) 对比
+#include <map>
+#include "bench.hpp"
+#include "emplace_suite.hpp"
+#include "map.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::EmplaceSuite<sjtu::map<int, bench::Big>, int>(rep, opt, "emplace_map", "sjtu");
+    bench::EmplaceSuite<std::map<int, bench::Big>, int>(rep, opt, "emplace_map", "std");
+    return 0;
+}
@@ -0,0 +1,74 @@
+////大对象值（256 字节）的原位构造测试：operator[]、try_emplace 与先构造 value_type 再 insert 的对比。
+////Big 统计构造、拷贝与移动的次数，结果里以每次操作的平均次数作为计数器，
+////用来确认 try_emplace 命中时不构造值、未命中时只构造一次。
+////M 需要提供 operator[]、try_emplace(key, args...)、insert(value_type)，
+////sjtu::map、sjtu::linked_hashmap 与对应的 std 容器都满足
+#ifndef SJTU_BENCH_EMPLACE_SUITE_HPP
+#define SJTU_BENCH_EMPLACE_SUITE_HPP
+
+#include <cstring>
+#include "bench.hpp"
+
+namespace bench {
+
+    struct Big {
+        static inline size_t constructs = 0, copies = 0;
+        char data[256];
+        Big() {
+            memset(data, 0, sizeof(data));
+            constructs++;
+        }
+        explicit Big(size_t x) {
+            memset(data, (int) (x & 0xff), sizeof(data));
+            constructs++;
+        }
+        Big(const Big &other) {
+            memcpy(data, other.data, sizeof(data));
+            copies++;
+        }
+        Big &operator = (const Big &other) {
+            memcpy(data, other.data, sizeof(data));
+            copies++;
+            return *this;
+        }
+    };
+
+    template<class M, class K>
+    void EmplaceSuite(Reporter &rep, const Options &opt, const char *container, const char *impl) {
+        const char *key = KeyGen<K>::name();
+        for(size_t n : opt.sizes()){
+            std::vector<K> keys = MakeKeys<K>(n);
+            std::vector<size_t> order = Order(n, UNIFORM);
+            //每次操作平均的构造与拷贝次数，每个条目单独统计
+            auto measure = [&](const char *op, bool prefill, auto body){
+                Record r = Make(container, impl, op, key, "uniform", n);
+                if(!opt.selected(r.name)) return;
+                size_t rounds = 0, constructs = 0, copies = 0;
+                Run(rep, opt, r, n, [&]{
+                    M *m = new M;
+                    if(prefill)
+                        for(size_t i = 0; i < n; ++i) m->try_emplace(keys[i], i);
+                    Big::constructs = Big::copies = 0;
+                    unsigned long long t0 = NowNs();
+                    for(size_t i = 0; i < n; ++i) body(*m, keys[order[i]], i);
+                    unsigned long long t1 = NowNs();
+                    constructs += Big::constructs;
+                    copies += Big::copies;
+                    rounds++;
+                    delete m;
+                    return t1 - t0;
+                });
+                rep.annotate("constructs_per_op", (double) constructs / (rounds * n));
+                rep.annotate("copies_per_op", (double) copies / (rounds * n));
+            };
+            measure("operator_bracket_miss", false, [](M &m, const K &k, size_t i){ m[k].data[0] = (char) i; });
+            measure("try_emplace_miss", false, [](M &m, const K &k, size_t i){ m.try_emplace(k, i); });
+            measure("insert_value_type", false, [](M &m, const K &k, size_t i){ m.insert(typename M::value_type(k, Big(i))); });
+            measure("try_emplace_hit", true, [](M &m, const K &k, size_t i){ m.try_emplace(k, i); });
+            measure("operator_bracket_hit", true, [](M &m, const K &k, size_t i){ m[k].data[0] = (char) i; });
+        }
+    }
+
+}
+
+#endif
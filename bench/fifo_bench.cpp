@@ -0,0 +1,55 @@
+////把容器当先进先出队列用：sjtu::vector 的 push_back + erase(0)、sjtu::deque 与 std::deque 的 push_back + pop_front。
+////steady 为队列长度保持 n 时的一进一出，fill_drain 为从空队列连续入队 n 个再全部出队。
+////vector 每次出队都要搬动其余元素，steady 一轮只做 1024 次操作
+#include <deque>
+#include "bench.hpp"
+#include "vector.hpp"
+#include "deque.hpp"
+
+using namespace bench;
+
+template<class Q> struct Fifo {
+    static void pop(Q &q) {q.pop_front();}
+};
+template<class T> struct Fifo<sjtu::vector<T>> {
+    static void pop(sjtu::vector<T> &q) {q.erase(0);}
+};
+
+template<class Q>
+void FifoSuite(Reporter &rep, const Options &opt, const char *impl, size_t steadyOps) {
+    for(size_t n : opt.sizes()){
+        Q q;
+        for(size_t i = 0; i < n; ++i) q.push_back(i);
+        size_t ops = steadyOps ? steadyOps : n;
+        size_t next = n;
+        Run(rep, opt, Make("fifo", impl, "steady", "u64", "sequential", n), ops, [&]{
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < ops; ++i){
+                q.push_back(next++);
+                Fifo<Q>::pop(q);
+            }
+            unsigned long long t1 = NowNs();
+            DoNotOptimize(q.front());
+            return t1 - t0;
+        });
+        if(steadyOps && n > steadyOps * 16) continue; //vector 的 fill_drain 为 O(n^2)，只测较小规模
+        Run(rep, opt, Make("fifo", impl, "fill_drain", "u64", "sequential", n), n, [&]{
+            Q *p = new Q;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) p->push_back(i);
+            for(size_t i = 0; i < n; ++i) Fifo<Q>::pop(*p);
+            unsigned long long t1 = NowNs();
+            delete p;
+            return t1 - t0;
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    FifoSuite<sjtu::vector<unsigned long long>>(rep, opt, "vector", 1024);
+    FifoSuite<sjtu::deque<unsigned long long>>(rep, opt, "sjtu_deque", 0);
+    FifoSuite<std::deque<unsigned long long>>(rep, opt, "std_deque", 0);
+    return 0;
+}
@@ -0,0 +1,68 @@
+////vector 加固模式（SJTU_VECTOR_HARDENED）的开销。同一份源码编译两次：hardened_bench 为默认构建，
+////vector_hardened_bench 以 -DSJTU_VECTOR_HARDENED=1 编译，迭代器每次解引用与移动都比对代数并检查范围；
+////std::vector 只在前者中测。iterate 用迭代器顺序求和，index 用 operator[] 顺序求和，
+////offset 为 begin() + 随机下标后解引用，push_back 从空向量逐个追加
+#include <vector>
+#include "bench.hpp"
+#include "vector.hpp"
+
+using namespace bench;
+
+#if SJTU_VECTOR_HARDENED
+const char *SjtuImpl = "hardened";
+#else
+const char *SjtuImpl = "default";
+#endif
+
+template<class V>
+void HardenedSuite(Reporter &rep, const Options &opt, const char *impl) {
+    for(size_t n : opt.sizes()){
+        V v;
+        for(size_t i = 0; i < n; ++i) v.push_back((int) i);
+        size_t queries = n < 4096 ? 4096 : n;
+        std::vector<size_t> idx = Indices(n, queries, UNIFORM);
+        Run(rep, opt, Make("hardened", impl, "iterate", "int", "sequential", n), n, [&]{
+            long long sum = 0;
+            unsigned long long t0 = NowNs();
+            for(auto it = v.begin(); it != v.end(); ++it) sum += *it;
+            unsigned long long t1 = NowNs();
+            DoNotOptimize(sum);
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("hardened", impl, "index", "int", "sequential", n), n, [&]{
+            long long sum = 0;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) sum += v[i];
+            unsigned long long t1 = NowNs();
+            DoNotOptimize(sum);
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("hardened", impl, "offset", "int", "uniform", n), queries, [&]{
+            long long sum = 0;
+            auto begin = v.begin();
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < queries; ++i) sum += *(begin + (int) idx[i]);
+            unsigned long long t1 = NowNs();
+            DoNotOptimize(sum);
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("hardened", impl, "push_back", "int", "sequential", n), n, [&]{
+            V *w = new V;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) w->push_back((int) i);
+            unsigned long long t1 = NowNs();
+            delete w;
+            return t1 - t0;
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    HardenedSuite<sjtu::vector<int>>(rep, opt, SjtuImpl);
+#if !SJTU_VECTOR_HARDENED
+    HardenedSuite<std::vector<int>>(rep, opt, "std");
+#endif
+    return 0;
+}
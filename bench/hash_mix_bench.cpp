@@ -0,0 +1,71 @@
+////linked_hashmap 各哈希混合策略（hash_mix.hpp）的分布质量与速度。
+////键集合都是 std::hash 容易出问题的形状：连续整数、步长 64 的整数、堆上对象的地址（指针），
+////以及公共前缀很长的字符串作为对照。insert 按键集合原有顺序插入，lookup 为均匀随机的命中查找；
+////lookup 条目附带建好的表上的 longest_chain 与 average_probe_length
+#include <memory>
+#include <string>
+#include "bench.hpp"
+#include "linked_hashmap.hpp"
+
+using namespace bench;
+
+template<class Mix, class K>
+void MixSuite(Reporter &rep, const Options &opt, const char *impl, const char *key, const std::vector<K> &keys) {
+    typedef sjtu::linked_hashmap<K, size_t, std::hash<K>, std::equal_to<K>, Mix> map_type;
+    size_t n = keys.size(), queries = 1 << 16;
+    Run(rep, opt, Make("hash_mix", impl, "insert", key, "sequential", n), n, [&]{
+        map_type *m = new map_type;
+        unsigned long long t0 = NowNs();
+        for(size_t i = 0; i < n; ++i) m->insert(typename map_type::value_type(keys[i], i));
+        unsigned long long t1 = NowNs();
+        delete m;
+        return t1 - t0;
+    });
+    Record r = Make("hash_mix", impl, "lookup", key, "uniform", n);
+    if(!opt.selected(r.name)) return;
+    map_type m;
+    for(size_t i = 0; i < n; ++i) m.insert(typename map_type::value_type(keys[i], i));
+    std::vector<size_t> idx = Indices(n, queries, UNIFORM);
+    Run(rep, opt, r, queries, [&]{
+        size_t sum = 0;
+        unsigned long long t0 = NowNs();
+        for(size_t i = 0; i < queries; ++i) sum += m.find(keys[idx[i]])->second;
+        unsigned long long t1 = NowNs();
+        DoNotOptimize(sum);
+        return t1 - t0;
+    });
+    rep.annotate("longest_chain", (double) m.longest_chain());
+    rep.annotate("average_probe_length", m.average_probe_length());
+}
+
+template<class K>
+void AllMixes(Reporter &rep, const Options &opt, const char *key, const std::vector<K> &keys) {
+    MixSuite<sjtu::fast_hash_mix>(rep, opt, "fast", key, keys);
+    MixSuite<sjtu::murmur_hash_mix>(rep, opt, "murmur", key, keys);
+    MixSuite<sjtu::legacy_hash_mix>(rep, opt, "legacy", key, keys);
+    MixSuite<sjtu::identity_hash_mix>(rep, opt, "identity", key, keys);
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    for(size_t n : opt.sizes()){
+        std::vector<int> ints(n), strided(n);
+        for(size_t i = 0; i < n; ++i){
+            ints[i] = (int) i;
+            strided[i] = (int) (i * 64);
+        }
+        AllMixes(rep, opt, "int", ints);
+        AllMixes(rep, opt, "int_stride64", strided);
+        //依次分配的小对象地址大致等距，低几位恒为 0
+        std::vector<std::unique_ptr<char[]>> objects(n);
+        std::vector<const char *> pointers(n);
+        for(size_t i = 0; i < n; ++i){
+            objects[i].reset(new char[48]);
+            pointers[i] = objects[i].get();
+        }
+        AllMixes(rep, opt, "pointer", pointers);
+        AllMixes(rep, opt, "string", MakeKeys<std::string>(n));
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+////linked_hashmap 的两种存储引擎对比：链地址的 linked_hashmap 与开放寻址的 flat_linked_hashmap，
+////以 std::unordered_map 为参照，测 insert / lookup / erase / iterate / copy / destroy
+#include <string>
+#include <unordered_map>
+#include "bench.hpp"
+#include "assoc_suite.hpp"
+#include "linked_hashmap.hpp"
+#include "flat_linked_hashmap.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::AssocSuite<sjtu::linked_hashmap<int, size_t>, int>(rep, opt, "hashmap_layout", "chained");
+    bench::AssocSuite<sjtu::flat_linked_hashmap<int, size_t>, int>(rep, opt, "hashmap_layout", "flat");
+    bench::AssocSuite<std::unordered_map<int, size_t>, int>(rep, opt, "hashmap_layout", "std");
+    bench::AssocSuite<sjtu::linked_hashmap<std::string, size_t>, std::string>(rep, opt, "hashmap_layout", "chained");
+    bench::AssocSuite<sjtu::flat_linked_hashmap<std::string, size_t>, std::string>(rep, opt, "hashmap_layout", "flat");
+    bench::AssocSuite<std::unordered_map<std::string, size_t>, std::string>(rep, opt, "hashmap_layout", "std");
+    return 0;
+}
@@ -0,0 +1,17 @@
+////sjtu::linked_hashmap 与 std::unordered_map 的基础对比：insert / lookup / erase / iterate / copy / destroy
+////std::unordered_map 不保持插入顺序，只作为哈希表本身的参照
+#include <string>
+#include <unordered_map>
+#include "bench.hpp"
+#include "assoc_suite.hpp"
+#include "linked_hashmap.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::AssocSuite<sjtu::linked_hashmap<int, size_t>, int>(rep, opt, "linked_hashmap", "sjtu");
+    bench::AssocSuite<std::unordered_map<int, size_t>, int>(rep, opt, "linked_hashmap", "std");
+    bench::AssocSuite<sjtu::linked_hashmap<std::string, size_t>, std::string>(rep, opt, "linked_hashmap", "sjtu");
+    bench::AssocSuite<std::unordered_map<std::string, size_t>, std::string>(rep, opt, "linked_hashmap", "std");
+    return 0;
+}
@@ -0,0 +1,16 @@
+////sjtu::map 与 std::map 的基础对比：insert / lookup / erase / iterate / copy / destroy
+#include <map>
+#include <string>
+#include "bench.hpp"
+#include "assoc_suite.hpp"
+#include "map.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::AssocSuite<sjtu::map<int, size_t>, int>(rep, opt, "map", "sjtu");
+    bench::AssocSuite<std::map<int, size_t>, int>(rep, opt, "map", "std");
+    bench::AssocSuite<sjtu::map<std::string, size_t>, std::string>(rep, opt, "map", "sjtu");
+    bench::AssocSuite<std::map<std::string, size_t>, std::string>(rep, opt, "map", "std");
+    return 0;
+}
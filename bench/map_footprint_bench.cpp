@@ -0,0 +1,47 @@
+////map 两种结点布局的内存占用与速度。同一份源码编译两次：map_footprint_bench 为默认布局，
+////map_compact_bench 以 -DSJTU_MAP_COMPACT_NODES=1 编译（颜色放进父指针低位、元素内嵌在结点中）。
+////footprint 条目的耗时为建表时每次插入的平均纳秒数，计数器 bytes_per_entry 为建表前后
+////堆上在用字节数之差（含分配器块头）除以元素个数；其余条目与 map_bench 相同
+#include <string>
+#include "bench.hpp"
+#include "assoc_suite.hpp"
+#include "map.hpp"
+
+using namespace bench;
+
+#if SJTU_MAP_COMPACT_NODES
+const char *Layout = "compact";
+#else
+const char *Layout = "default";
+#endif
+
+template<class M, class K>
+void FootprintSuite(Reporter &rep, const Options &opt) {
+    const char *key = KeyGen<K>::name();
+    for(size_t n : opt.sizes()){
+        Record r = Make("map_nodes", Layout, "footprint", key, "sequential", n);
+        if(!opt.selected(r.name)) continue;
+        std::vector<K> keys = MakeKeys<K>(n);
+        size_t before = HeapBytes();
+        M *m = new M;
+        unsigned long long t0 = NowNs();
+        for(size_t i = 0; i < n; ++i) m->insert(typename M::value_type(keys[i], i));
+        unsigned long long t1 = NowNs();
+        size_t after = HeapBytes();
+        delete m;
+        r.iterations = n;
+        r.nsPerOp = (double) (t1 - t0) / n;
+        r.counters.push_back({"bytes_per_entry", (double) (after - before) / n});
+        rep.add(std::move(r));
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    FootprintSuite<sjtu::map<int, size_t>, int>(rep, opt);
+    FootprintSuite<sjtu::map<std::string, size_t>, std::string>(rep, opt);
+    AssocSuite<sjtu::map<int, size_t>, int>(rep, opt, "map_nodes", Layout);
+    AssocSuite<sjtu::map<std::string, size_t>, std::string>(rep, opt, "map_nodes", Layout);
+    return 0;
+}
@@ -0,0 +1,89 @@
+////map_parallel.hpp 基于 join 的批量算法的强扩展：规模固定，线程池大小取 1, 2, 4, ... 到 --threads，
+////以逐个 insert / find / erase 的串行写法为参照。
+////build 由有序数组建表；union / intersection / difference 的两个操作数各有 n 个元素，
+////a 为 2 的倍数、b 为 3 的倍数，约三分之一的键相同；每轮先拷贝操作数，拷贝不计入
+#include <memory>
+#include "bench.hpp"
+#include "map.hpp"
+#include "map_parallel.hpp"
+
+using namespace bench;
+
+typedef sjtu::map<int, size_t> map_type;
+
+void MapParallelSuite(Reporter &rep, const Options &opt, size_t n) {
+    std::vector<sjtu::pair<int, size_t>> sorted;
+    sorted.reserve(n);
+    for(size_t i = 0; i < n; ++i) sorted.emplace_back((int) i, i);
+    map_type a, b;
+    for(size_t i = 0; i < n; ++i){
+        a.insert(map_type::value_type((int) (2 * i), i));
+        b.insert(map_type::value_type((int) (3 * i), i));
+    }
+    //每轮在 a、b 的拷贝上运行 body(x, y)
+    auto binary = [&](const char *impl, const char *op, unsigned t, auto body){
+        Run(rep, opt, Make("map_parallel", impl, op, "int", "sequential", n, t), 2 * n, [&]{
+            map_type *x = new map_type(a), *y = new map_type(b);
+            unsigned long long t0 = NowNs();
+            body(*x, *y);
+            unsigned long long t1 = NowNs();
+            delete x;
+            delete y;
+            return t1 - t0;
+        });
+    };
+    for(unsigned t : opt.threads()){
+        std::unique_ptr<sjtu::thread_pool> pool(new sjtu::thread_pool(t));
+        sjtu::thread_pool &p = *pool;
+        Run(rep, opt, Make("map_parallel", "join", "build", "int", "sequential", n, t), n, [&]{
+            map_type *m = new map_type;
+            unsigned long long t0 = NowNs();
+            sjtu::parallel_build(p, *m, sorted.begin(), sorted.end());
+            unsigned long long t1 = NowNs();
+            delete m;
+            return t1 - t0;
+        });
+        binary("join", "union", t, [&](map_type &x, map_type &y){ sjtu::parallel_union(p, x, y); });
+        binary("join", "intersection", t, [&](map_type &x, map_type &y){ sjtu::parallel_intersection(p, x, y); });
+        binary("join", "difference", t, [&](map_type &x, map_type &y){ sjtu::parallel_difference(p, x, y); });
+        Run(rep, opt, Make("map_parallel", "join", "for_each", "int", "sequential", n, t), n, [&]{
+            unsigned long long t0 = NowNs();
+            sjtu::parallel_for_each(p, a, [](map_type::value_type &v){ v.second++; });
+            return NowNs() - t0;
+        });
+    }
+    Run(rep, opt, Make("map_parallel", "sequential", "build", "int", "sequential", n), n, [&]{
+        map_type *m = new map_type;
+        unsigned long long t0 = NowNs();
+        for(size_t i = 0; i < n; ++i) m->insert(map_type::value_type(sorted[i].first, sorted[i].second));
+        unsigned long long t1 = NowNs();
+        delete m;
+        return t1 - t0;
+    });
+    binary("sequential", "union", 1, [&](map_type &x, map_type &y){
+        for(auto it = y.begin(); it != y.end(); ++it) x.insert(*it);
+        y.clear();
+    });
+    //intersection 与 difference 先收集要删的键，再逐个删除
+    auto keep = [&](map_type &x, map_type &y, bool inY){
+        std::vector<int> drop;
+        for(auto it = x.begin(); it != x.end(); ++it)
+            if((y.find(it->first) != y.end()) != inY) drop.push_back(it->first);
+        for(int k : drop) x.erase(x.find(k));
+    };
+    binary("sequential", "intersection", 1, [&](map_type &x, map_type &y){ keep(x, y, true); });
+    binary("sequential", "difference", 1, [&](map_type &x, map_type &y){ keep(x, y, false); });
+    Run(rep, opt, Make("map_parallel", "sequential", "for_each", "int", "sequential", n), n, [&]{
+        unsigned long long t0 = NowNs();
+        for(auto it = a.begin(); it != a.end(); ++it) it->second++;
+        return NowNs() - t0;
+    });
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    for(size_t n : opt.sizes())
+        MapParallelSuite(rep, opt, n);
+    return 0;
+}
@@ -0,0 +1,86 @@
+////parallel.hpp 各算法的强扩展：规模固定，线程池大小取 1, 2, 4, ... 到 --threads，
+////以单线程的串行写法（循环或 std 算法，作用在同一个 sjtu::vector 上）为参照。
+////sort 与 partition 每轮先把输入恢复成同一份随机数据，恢复不计入
+#include <algorithm>
+#include <memory>
+#include "bench.hpp"
+#include "vector.hpp"
+#include "parallel.hpp"
+
+using namespace bench;
+
+typedef unsigned long long u64;
+
+//把 v 恢复成 src 的内容，长度相同
+inline void Restore(sjtu::vector<u64> &v, const sjtu::vector<u64> &src) {
+    for(size_t i = 0; i < src.size(); ++i) v[i] = src[i];
+}
+
+void ParallelSuite(Reporter &rep, const Options &opt, size_t n) {
+    sjtu::vector<u64> src, v, out;
+    Random rng(5);
+    for(size_t i = 0; i < n; ++i){
+        src.push_back(rng.next());
+        v.push_back(0);
+        out.push_back(0);
+    }
+    auto f = [](u64 x){ return x * 3 + 1; };
+    auto plus = [](u64 a, u64 b){ return a + b; };
+    auto square = [](u64 acc, u64 x){ return acc + x * x; };
+    auto even = [](u64 x){ return !(x & 1); };
+    for(unsigned t : opt.threads()){
+        std::unique_ptr<sjtu::thread_pool> pool(new sjtu::thread_pool(t));
+        auto timed = [&](const char *op, bool restore, auto body){
+            Run(rep, opt, Make("parallel", "sjtu", op, "u64", "uniform", n, t), n, [&]{
+                if(restore) Restore(v, src);
+                unsigned long long t0 = NowNs();
+                body(*pool);
+                return NowNs() - t0;
+            });
+        };
+        Restore(v, src);
+        timed("for_each", false, [&](sjtu::thread_pool &p){ sjtu::parallel_for_each(p, v, [&](u64 &x){ x = f(x); }); });
+        timed("transform", false, [&](sjtu::thread_pool &p){ sjtu::parallel_transform(p, src, out, f); });
+        timed("reduce", false, [&](sjtu::thread_pool &p){ DoNotOptimize(sjtu::parallel_reduce(p, src, (u64) 0, plus)); });
+        timed("reduce_fold", false, [&](sjtu::thread_pool &p){
+            DoNotOptimize(sjtu::parallel_reduce(p, src, (u64) 0, square, plus));
+        });
+        timed("inclusive_scan", true, [&](sjtu::thread_pool &p){ sjtu::parallel_inclusive_scan(p, v, plus); });
+        timed("partition", true, [&](sjtu::thread_pool &p){ DoNotOptimize(sjtu::parallel_partition(p, v, even)); });
+        timed("sort", true, [&](sjtu::thread_pool &p){ sjtu::parallel_sort(p, v); });
+    }
+    auto serial = [&](const char *op, bool restore, auto body){
+        Run(rep, opt, Make("parallel", "sequential", op, "u64", "uniform", n), n, [&]{
+            if(restore) Restore(v, src);
+            unsigned long long t0 = NowNs();
+            body();
+            return NowNs() - t0;
+        });
+    };
+    u64 *a = v.data(), *b = out.data();
+    const u64 *s = src.data();
+    Restore(v, src);
+    serial("for_each", false, [&]{ for(size_t i = 0; i < n; ++i) a[i] = f(a[i]); ClobberMemory(); });
+    serial("transform", false, [&]{ for(size_t i = 0; i < n; ++i) b[i] = f(s[i]); ClobberMemory(); });
+    serial("reduce", false, [&]{
+        u64 acc = 0;
+        for(size_t i = 0; i < n; ++i) acc += s[i];
+        DoNotOptimize(acc);
+    });
+    serial("reduce_fold", false, [&]{
+        u64 acc = 0;
+        for(size_t i = 0; i < n; ++i) acc += s[i] * s[i];
+        DoNotOptimize(acc);
+    });
+    serial("inclusive_scan", true, [&]{ for(size_t i = 1; i < n; ++i) a[i] += a[i - 1]; ClobberMemory(); });
+    serial("partition", true, [&]{ DoNotOptimize(std::stable_partition(a, a + n, even)); });
+    serial("sort", true, [&]{ std::stable_sort(a, a + n); });
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    for(size_t n : opt.sizes())
+        ParallelSuite(rep, opt, n);
+    return 0;
+}
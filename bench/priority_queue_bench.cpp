@@ -0,0 +1,104 @@
+////sjtu::priority_queue 与 std::priority_queue 的基础对比：
+////insert 为按分布顺序 push，lookup 为 top，erase 为 pop 到空，另测 merge / copy / destroy。
+////堆没有有序遍历，iterate 一项用 top + pop 的完整出堆代替；std 没有 merge，用逐个 push 代替
+#include <queue>
+#include <string>
+#include "bench.hpp"
+#include "priority_queue.hpp"
+
+using namespace bench;
+
+template<class Q> struct Merger {
+    static void merge(Q &a, Q &b) {a.merge(b);}
+};
+template<class T> struct Merger<std::priority_queue<T>> {
+    static void merge(std::priority_queue<T> &a, std::priority_queue<T> &b) {
+        for(; !b.empty(); b.pop()) a.push(b.top());
+    }
+};
+
+template<class Q, class K>
+void QueueSuite(Reporter &rep, const Options &opt, const char *impl) {
+    const char *key = KeyGen<K>::name();
+    for(size_t n : opt.sizes()){
+        std::vector<K> keys = MakeKeys<K>(n);
+        for(Dist d : AllDists){
+            std::vector<size_t> order = Order(n, d);
+            Q base;
+            for(size_t i = 0; i < n; ++i) base.push(keys[order[i]]);
+            Run(rep, opt, Make("priority_queue", impl, "insert", key, DistName(d), n), n, [&]{
+                Q *q = new Q;
+                unsigned long long t0 = NowNs();
+                for(size_t i = 0; i < n; ++i) q->push(keys[order[i]]);
+                unsigned long long t1 = NowNs();
+                delete q;
+                return t1 - t0;
+            });
+            Run(rep, opt, Make("priority_queue", impl, "lookup", key, DistName(d), n), n, [&]{
+                size_t sum = 0;
+                unsigned long long t0 = NowNs();
+                for(size_t i = 0; i < n; ++i){
+                    sum += base.top() == keys[0];
+                    ClobberMemory();
+                }
+                unsigned long long t1 = NowNs();
+                DoNotOptimize(sum);
+                return t1 - t0;
+            });
+            Run(rep, opt, Make("priority_queue", impl, "erase", key, DistName(d), n), n, [&]{
+                Q *q = new Q(base);
+                unsigned long long t0 = NowNs();
+                for(size_t i = 0; i < n; ++i) q->pop();
+                unsigned long long t1 = NowNs();
+                delete q;
+                return t1 - t0;
+            });
+            Run(rep, opt, Make("priority_queue", impl, "merge", key, DistName(d), n), n, [&]{
+                Q *a = new Q(base), *b = new Q(base);
+                unsigned long long t0 = NowNs();
+                Merger<Q>::merge(*a, *b);
+                unsigned long long t1 = NowNs();
+                delete a;
+                delete b;
+                return t1 - t0;
+            });
+            if(d != SEQUENTIAL) continue;
+            Run(rep, opt, Make("priority_queue", impl, "iterate", key, DistName(d), n), n, [&]{
+                Q *q = new Q(base);
+                size_t sum = 0;
+                unsigned long long t0 = NowNs();
+                for(size_t i = 0; i < n; ++i){
+                    sum += q->top() == keys[0];
+                    q->pop();
+                }
+                unsigned long long t1 = NowNs();
+                DoNotOptimize(sum);
+                delete q;
+                return t1 - t0;
+            });
+            Run(rep, opt, Make("priority_queue", impl, "copy", key, DistName(d), n), n, [&]{
+                unsigned long long t0 = NowNs();
+                Q *q = new Q(base);
+                unsigned long long t1 = NowNs();
+                delete q;
+                return t1 - t0;
+            });
+            Run(rep, opt, Make("priority_queue", impl, "destroy", key, DistName(d), n), n, [&]{
+                Q *q = new Q(base);
+                unsigned long long t0 = NowNs();
+                delete q;
+                return NowNs() - t0;
+            });
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    QueueSuite<sjtu::priority_queue<int>, int>(rep, opt, "sjtu");
+    QueueSuite<std::priority_queue<int>, int>(rep, opt, "std");
+    QueueSuite<sjtu::priority_queue<std::string>, std::string>(rep, opt, "sjtu");
+    QueueSuite<std::priority_queue<std::string>, std::string>(rep, opt, "std");
+    return 0;
+}
@@ -0,0 +1,70 @@
+////linked_hashmap 扩容时的单次插入延迟：一次性重哈希与渐进式重哈希（incremental_rehash）对比，
+////以 std::unordered_map 为参照。逐个计时每次插入，报告平均值、分位数、最大值，
+////以及按 2 的幂划分的延迟直方图（计数器 hist_le_<上界>ns 为落在 (上界/2, 上界] 内的插入次数）
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include "bench.hpp"
+#include "linked_hashmap.hpp"
+
+using namespace bench;
+
+//渐进式扩容的 linked_hashmap 用一个派生类型区分
+template<class Key, class T>
+struct incremental_linked_hashmap : sjtu::linked_hashmap<Key, T> {
+    incremental_linked_hashmap() {this->incremental_rehash(true);}
+};
+
+template<class M, class K>
+void LatencySuite(Reporter &rep, const Options &opt, const char *impl) {
+    const char *key = KeyGen<K>::name();
+    for(size_t n : opt.sizes()){
+        std::vector<K> keys = MakeKeys<K>(n);
+        std::vector<size_t> order = Order(n, UNIFORM);
+        Record r = Make("rehash_latency", impl, "insert", key, "uniform", n);
+        if(!opt.selected(r.name)) continue;
+        std::vector<unsigned long long> lat;
+        lat.reserve(n);
+        unsigned long long total = 0, start = NowNs();
+        const unsigned long long budget = (unsigned long long) (opt.minTime * 1e9);
+        //每轮新建一张表，从 16 个桶开始插入，经历全部扩容
+        do{
+            M *m = new M;
+            for(size_t i = 0; i < n; ++i){
+                unsigned long long t0 = NowNs();
+                m->insert(typename M::value_type(keys[order[i]], i));
+                unsigned long long t = NowNs() - t0;
+                lat.push_back(t);
+                total += t;
+            }
+            delete m;
+        }while(total < budget && NowNs() - start < budget * 10 && lat.size() < 50000000);
+        r.iterations = lat.size();
+        r.nsPerOp = (double) total / lat.size();
+        std::sort(lat.begin(), lat.end());
+        const double qs[] = {0.5, 0.9, 0.99, 0.999, 0.9999};
+        const char *qn[] = {"p50_ns", "p90_ns", "p99_ns", "p999_ns", "p9999_ns"};
+        for(int i = 0; i < 5; ++i)
+            r.counters.push_back({qn[i], (double) lat[(size_t) (qs[i] * (lat.size() - 1))]});
+        r.counters.push_back({"max_ns", (double) lat.back()});
+        size_t pos = 0;
+        for(unsigned long long bound = 32; pos < lat.size(); bound <<= 1){
+            size_t cnt = 0;
+            while(pos < lat.size() && lat[pos] <= bound) ++pos, ++cnt;
+            if(cnt) r.counters.push_back({"hist_le_" + std::to_string(bound) + "ns", (double) cnt});
+        }
+        rep.add(std::move(r));
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    LatencySuite<sjtu::linked_hashmap<int, size_t>, int>(rep, opt, "stop_the_world");
+    LatencySuite<incremental_linked_hashmap<int, size_t>, int>(rep, opt, "incremental");
+    LatencySuite<std::unordered_map<int, size_t>, int>(rep, opt, "std");
+    LatencySuite<sjtu::linked_hashmap<std::string, size_t>, std::string>(rep, opt, "stop_the_world");
+    LatencySuite<incremental_linked_hashmap<std::string, size_t>, std::string>(rep, opt, "incremental");
+    LatencySuite<std::unordered_map<std::string, size_t>, std::string>(rep, opt, "std");
+    return 0;
+}
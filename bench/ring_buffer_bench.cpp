@@ -0,0 +1,120 @@
+////ring_buffer.hpp 的吞吐与延迟，以互斥锁保护的定长 sjtu::vector 环形队列为参照，容量均为 1024。
+////throughput：p 个生产者与 p 个消费者传递固定总数的消息，p 取 1, 2, 4, ...（线程数 2p 不超过 --threads），
+////spsc 只测 p = 1；结果为每条消息的平均纳秒数。
+////latency：两个线程经一对队列来回传一条消息，结果为一次往返的纳秒数。
+////这两项与规模无关，不受 --min-size / --max-size 影响，记录中的 n 为队列容量
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "bench.hpp"
+#include "vector.hpp"
+#include "ring_buffer.hpp"
+
+using namespace bench;
+
+typedef unsigned long long u64;
+
+//整个队列一把锁
+template<class T>
+class locked_queue {
+    std::mutex lock;
+    sjtu::vector<T> array;
+    size_t head = 0, num = 0;
+public:
+    explicit locked_queue(size_t capacity) {
+        for(size_t i = 0; i < capacity; ++i) array.push_back(T());
+    }
+    bool try_push(const T &value) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(num == array.size()) return false;
+        array[(head + num++) % array.size()] = value;
+        return true;
+    }
+    bool try_pop(T &out) {
+        std::lock_guard<std::mutex> guard(lock);
+        if(!num) return false;
+        out = array[head];
+        head = (head + 1) % array.size();
+        num--;
+        return true;
+    }
+    void push(const T &value) {
+        while(!try_push(value)) std::this_thread::yield();
+    }
+    void pop(T &out) {
+        while(!try_pop(out)) std::this_thread::yield();
+    }
+};
+
+const size_t Capacity = 1024, Messages = 1 << 18, RoundTrips = 1 << 14;
+
+template<class Q>
+void Throughput(Reporter &rep, const Options &opt, const char *impl, unsigned p) {
+    Run(rep, opt, Make("ring_buffer", impl, "throughput", "u64", "sequential", Capacity, 2 * p), Messages, [&]{
+        Q q(Capacity);
+        std::atomic<bool> go{false};
+        std::vector<std::thread> pool;
+        for(unsigned k = 0; k < p; ++k){
+            size_t lo = Messages * k / p, hi = Messages * (k + 1) / p;
+            pool.emplace_back([&, lo, hi]{
+                while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                for(size_t i = lo; i < hi; ++i) q.push(i);
+            });
+            pool.emplace_back([&, lo, hi]{
+                u64 sum = 0, x;
+                while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                for(size_t i = lo; i < hi; ++i){
+                    q.pop(x);
+                    sum += x;
+                }
+                DoNotOptimize(sum);
+            });
+        }
+        unsigned long long t0 = NowNs();
+        go.store(true, std::memory_order_release);
+        for(std::thread &th : pool) th.join();
+        return NowNs() - t0;
+    });
+}
+
+template<class Q>
+void Latency(Reporter &rep, const Options &opt, const char *impl) {
+    Run(rep, opt, Make("ring_buffer", impl, "latency", "u64", "sequential", Capacity, 2), RoundTrips, [&]{
+        Q ping(Capacity), pong(Capacity);
+        std::atomic<bool> go{false};
+        std::thread echo([&]{
+            u64 x;
+            while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for(size_t i = 0; i < RoundTrips; ++i){
+                ping.pop(x);
+                pong.push(x + 1);
+            }
+        });
+        u64 x = 0;
+        unsigned long long t0 = NowNs();
+        go.store(true, std::memory_order_release);
+        for(size_t i = 0; i < RoundTrips; ++i){
+            ping.push(x);
+            pong.pop(x);
+        }
+        unsigned long long t1 = NowNs();
+        echo.join();
+        DoNotOptimize(x);
+        return t1 - t0;
+    });
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    Throughput<sjtu::spsc_ring_buffer<u64>>(rep, opt, "spsc", 1);
+    for(unsigned t : opt.threads())
+        if(t >= 2){
+            Throughput<sjtu::mpmc_ring_buffer<u64>>(rep, opt, "mpmc", t / 2);
+            Throughput<locked_queue<u64>>(rep, opt, "mutex", t / 2);
+        }
+    Latency<sjtu::spsc_ring_buffer<u64>>(rep, opt, "spsc");
+    Latency<sjtu::mpmc_ring_buffer<u64>>(rep, opt, "mpmc");
+    Latency<locked_queue<u64>>(rep, opt, "mutex");
+    return 0;
+}
@@ -0,0 +1,113 @@
+////行存储（AoS，sjtu::vector<Trade>）与列存储（SoA，soa_vector）的对比。每行 64 字节、8 个字段：
+////scan_one 只读 price 一列求和，scan_filter 读 flags、price、qty 三列做带条件的求和，
+////row 逐行读全部字段，push_back 逐行追加。列扫描越窄，列存储读的内存越少
+#include "bench.hpp"
+#include "vector.hpp"
+#include "soa_vector.hpp"
+
+using namespace bench;
+
+typedef unsigned long long u64;
+
+struct Trade {
+    u64 id;
+    double price;
+    unsigned qty, flags;
+    double bid, ask, fee, tax;
+};
+
+typedef sjtu::soa_vector<u64, double, unsigned, unsigned, double, double, double, double> trade_columns;
+enum { Id, Price, Qty, Flags, Bid, Ask, Fee, Tax };
+
+inline Trade MakeTrade(size_t i) {
+    double p = (double) (i % 1000) + 0.5;
+    return Trade{i, p, (unsigned) (i % 7 + 1), (unsigned) (i * 2654435761u), p - 0.1, p + 0.1, 0.01, 0.02};
+}
+
+void SoaSuite(Reporter &rep, const Options &opt) {
+    for(size_t n : opt.sizes()){
+        sjtu::vector<Trade> aos;
+        trade_columns soa;
+        for(size_t i = 0; i < n; ++i){
+            Trade o = MakeTrade(i);
+            aos.push_back(o);
+            soa.push_back(o.id, o.price, o.qty, o.flags, o.bid, o.ask, o.fee, o.tax);
+        }
+        const Trade *rows = aos.data();
+        auto timed = [&](const char *impl, const char *op, auto body){
+            Run(rep, opt, Make("soa", impl, op, "trade", "sequential", n), n, [&]{
+                unsigned long long t0 = NowNs();
+                DoNotOptimize(body());
+                return NowNs() - t0;
+            });
+        };
+        timed("aos", "scan_one", [&]{
+            double sum = 0;
+            for(size_t i = 0; i < n; ++i) sum += rows[i].price;
+            return sum;
+        });
+        timed("soa", "scan_one", [&]{
+            const double *price = soa.column_data<Price>();
+            double sum = 0;
+            for(size_t i = 0; i < n; ++i) sum += price[i];
+            return sum;
+        });
+        timed("aos", "scan_filter", [&]{
+            double sum = 0;
+            for(size_t i = 0; i < n; ++i)
+                if(rows[i].flags & 1) sum += rows[i].price * rows[i].qty;
+            return sum;
+        });
+        timed("soa", "scan_filter", [&]{
+            const double *price = soa.column_data<Price>();
+            const unsigned *qty = soa.column_data<Qty>(), *flags = soa.column_data<Flags>();
+            double sum = 0;
+            for(size_t i = 0; i < n; ++i)
+                if(flags[i] & 1) sum += price[i] * qty[i];
+            return sum;
+        });
+        timed("aos", "row", [&]{
+            double sum = 0;
+            for(size_t i = 0; i < n; ++i){
+                const Trade &o = rows[i];
+                sum += o.id + o.price * o.qty + o.flags + o.bid + o.ask + o.fee + o.tax;
+            }
+            return sum;
+        });
+        timed("soa", "row", [&]{
+            double sum = 0;
+            for(auto it = soa.cbegin(); it != soa.cend(); ++it){
+                const auto &o = *it;
+                sum += std::get<Id>(o) + std::get<Price>(o) * std::get<Qty>(o) + std::get<Flags>(o)
+                       + std::get<Bid>(o) + std::get<Ask>(o) + std::get<Fee>(o) + std::get<Tax>(o);
+            }
+            return sum;
+        });
+        Run(rep, opt, Make("soa", "aos", "push_back", "trade", "sequential", n), n, [&]{
+            sjtu::vector<Trade> *v = new sjtu::vector<Trade>;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) v->push_back(MakeTrade(i));
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("soa", "soa", "push_back", "trade", "sequential", n), n, [&]{
+            trade_columns *v = new trade_columns;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i){
+                Trade o = MakeTrade(i);
+                v->push_back(o.id, o.price, o.qty, o.flags, o.bid, o.ask, o.fee, o.tax);
+            }
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    SoaSuite(rep, opt);
+    return 0;
+}
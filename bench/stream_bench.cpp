@@ -0,0 +1,80 @@
+////大数组上的带宽与增长：STREAM triad（a[i] = b[i] + 3 * c[i]）、逐个 push_back 增长、
+////reserve 后填充（首次写入触发缺页）与 parallel_reserve 后填充。
+////同一份源码编译两次：stream_bench 使用默认的 SJTU_VECTOR_MMAP_THRESHOLD（32MB 起走 mmap + 透明大页，
+////用 mremap 增长），stream_malloc_bench 定义其为 0，全部走 malloc 并逐个拷贝；std::vector 只在前者中测。
+////阈值按字节计，double 元素要 4M 个以上才会走 mmap，需要 --max-size=1e7 或更大才能看到差别
+#include <vector>
+#include "bench.hpp"
+#include "vector.hpp"
+#include "parallel.hpp"
+
+using namespace bench;
+
+#if SJTU_VECTOR_MMAP_THRESHOLD
+const char *SjtuImpl = "mmap";
+#else
+const char *SjtuImpl = "malloc";
+#endif
+
+template<class V>
+void StreamSuite(Reporter &rep, const Options &opt, const char *impl, bool parallelReserve) {
+    for(size_t n : opt.sizes()){
+        V a, b, c;
+        for(size_t i = 0; i < n; ++i){
+            a.push_back(0);
+            b.push_back((double) i);
+            c.push_back((double) (n - i));
+        }
+        unsigned long long total = 0, rounds = 0;
+        Run(rep, opt, Make("stream", impl, "triad", "double", "sequential", n), n, [&]{
+            double *pa = &a[0];
+            const double *pb = &b[0], *pc = &c[0];
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) pa[i] = pb[i] + 3.0 * pc[i];
+            ClobberMemory();
+            unsigned long long t = NowNs() - t0;
+            total += t;
+            rounds++;
+            return t;
+        });
+        //每个元素读两个 double、写一个 double
+        if(rounds) rep.annotate("bytes_per_second", 24.0 * n * rounds / total * 1e9);
+        Run(rep, opt, Make("stream", impl, "push_back", "double", "sequential", n), n, [&]{
+            V *v = new V;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) v->push_back((double) i);
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("stream", impl, "reserve_fill", "double", "sequential", n), n, [&]{
+            V *v = new V;
+            unsigned long long t0 = NowNs();
+            v->reserve(n);
+            for(size_t i = 0; i < n; ++i) v->push_back((double) i);
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+        if(parallelReserve)
+            Run(rep, opt, Make("stream", impl, "parallel_reserve_fill", "double", "sequential", n), n, [&]{
+                sjtu::vector<double> *v = new sjtu::vector<double>;
+                unsigned long long t0 = NowNs();
+                sjtu::parallel_reserve(*v, n);
+                for(size_t i = 0; i < n; ++i) v->push_back((double) i);
+                unsigned long long t1 = NowNs();
+                delete v;
+                return t1 - t0;
+            });
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    StreamSuite<sjtu::vector<double>>(rep, opt, SjtuImpl, true);
+#if SJTU_VECTOR_MMAP_THRESHOLD
+    StreamSuite<std::vector<double>>(rep, opt, "std", false);
+#endif
+    return 0;
+}
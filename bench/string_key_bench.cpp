@@ -0,0 +1,72 @@
+////长字符串键的查找：键长 256 字节，前 240 字节完全相同，全键比较代价最高的情形。
+////对比按缓存哈希值预过滤的 linked_hashmap、按标签字节做 SIMD 组探测的 flat_linked_hashmap 与 std::unordered_map，
+////分别测命中与未命中，计数器 equal_calls_per_lookup 为每次查找调用键比较的平均次数
+#include <string>
+#include <unordered_map>
+#include "bench.hpp"
+#include "linked_hashmap.hpp"
+#include "flat_linked_hashmap.hpp"
+
+using namespace bench;
+
+static unsigned long long equalCalls = 0;
+
+struct CountingEqual {
+    bool operator()(const std::string &a, const std::string &b) const {
+        ++equalCalls;
+        return a == b;
+    }
+};
+
+static std::string LongKey(size_t i) {
+    char tail[32];
+    snprintf(tail, sizeof(tail), "%016zu", i);
+    return std::string(240, 'p') + tail;
+}
+
+template<class M>
+void StringKeySuite(Reporter &rep, const Options &opt, const char *impl) {
+    for(size_t n : opt.sizes()){
+        std::vector<std::string> keys, missing;
+        keys.reserve(n);
+        missing.reserve(n);
+        for(size_t i = 0; i < n; ++i){
+            keys.push_back(LongKey(2 * i));
+            missing.push_back(LongKey(2 * i + 1));
+        }
+        M m;
+        for(size_t i = 0; i < n; ++i) m.insert(typename M::value_type(keys[i], i));
+        size_t queries = n < 4096 ? 4096 : n;
+        std::vector<size_t> idx = Indices(n, queries, UNIFORM);
+        for(int hit = 1; hit >= 0; --hit){
+            const std::vector<std::string> &q = hit ? keys : missing;
+            Record r = Make("string_key", impl, hit ? "lookup_hit" : "lookup_miss", "string256", "uniform", n);
+            unsigned long long calls = 0, lookups = 0;
+            Run(rep, opt, r, queries, [&]{
+                size_t sum = 0;
+                unsigned long long before = equalCalls;
+                unsigned long long t0 = NowNs();
+                for(size_t i = 0; i < queries; ++i){
+                    auto it = m.find(q[idx[i]]);
+                    if(it != m.end()) sum += it->second;
+                }
+                unsigned long long t1 = NowNs();
+                calls += equalCalls - before;
+                lookups += queries;
+                DoNotOptimize(sum);
+                return t1 - t0;
+            });
+            if(opt.selected(r.name))
+                rep.annotate("equal_calls_per_lookup", (double) calls / lookups);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    StringKeySuite<sjtu::linked_hashmap<std::string, size_t, std::hash<std::string>, CountingEqual>>(rep, opt, "chained");
+    StringKeySuite<sjtu::flat_linked_hashmap<std::string, size_t, std::hash<std::string>, CountingEqual>>(rep, opt, "flat");
+    StringKeySuite<std::unordered_map<std::string, size_t, std::hash<std::string>, CountingEqual>>(rep, opt, "std");
+    return 0;
+}
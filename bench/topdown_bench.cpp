@@ -0,0 +1,20 @@
+////自顶向下红黑树 topdown_map（结点无父指针）与 sjtu::map（带父指针）的对比：
+////insert / lookup / erase / iterate / copy / destroy，以 std::map 为参照
+#include <map>
+#include <string>
+#include "bench.hpp"
+#include "assoc_suite.hpp"
+#include "map.hpp"
+#include "topdown_map.hpp"
+
+int main(int argc, char **argv) {
+    bench::Options opt(argc, argv);
+    bench::Reporter rep(opt);
+    bench::AssocSuite<sjtu::map<int, size_t>, int>(rep, opt, "tree", "parent_pointer");
+    bench::AssocSuite<sjtu::topdown_map<int, size_t>, int>(rep, opt, "tree", "topdown");
+    bench::AssocSuite<std::map<int, size_t>, int>(rep, opt, "tree", "std");
+    bench::AssocSuite<sjtu::map<std::string, size_t>, std::string>(rep, opt, "tree", "parent_pointer");
+    bench::AssocSuite<sjtu::topdown_map<std::string, size_t>, std::string>(rep, opt, "tree", "topdown");
+    bench::AssocSuite<std::map<std::string, size_t>, std::string>(rep, opt, "tree", "std");
+    return 0;
+}
@@ -0,0 +1,77 @@
+////sjtu::vector 与 std::vector 的基础对比：
+////insert 为 push_back，lookup 为按分布的下标读，erase 为 pop_back 到空，另测 iterate / copy / destroy
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "vector.hpp"
+
+using namespace bench;
+
+template<class V, class K>
+void VectorSuite(Reporter &rep, const Options &opt, const char *impl) {
+    const char *key = KeyGen<K>::name();
+    for(size_t n : opt.sizes()){
+        std::vector<K> keys = MakeKeys<K>(n);
+        size_t queries = n < 4096 ? 4096 : n;
+        V base;
+        for(size_t i = 0; i < n; ++i) base.push_back(keys[i]);
+        Run(rep, opt, Make("vector", impl, "insert", key, "sequential", n), n, [&]{
+            V *v = new V;
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) v->push_back(keys[i]);
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+        for(Dist d : AllDists){
+            std::vector<size_t> idx = Indices(n, queries, d);
+            Run(rep, opt, Make("vector", impl, "lookup", key, DistName(d), n), queries, [&]{
+                size_t hit = 0;
+                unsigned long long t0 = NowNs();
+                for(size_t i = 0; i < queries; ++i) hit += base[idx[i]] == keys[idx[i]];
+                unsigned long long t1 = NowNs();
+                DoNotOptimize(hit);
+                return t1 - t0;
+            });
+        }
+        Run(rep, opt, Make("vector", impl, "erase", key, "sequential", n), n, [&]{
+            V *v = new V(base);
+            unsigned long long t0 = NowNs();
+            for(size_t i = 0; i < n; ++i) v->pop_back();
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("vector", impl, "iterate", key, "sequential", n), n, [&]{
+            size_t sum = 0;
+            unsigned long long t0 = NowNs();
+            for(auto it = base.begin(); it != base.end(); ++it) sum += *it == keys[0];
+            unsigned long long t1 = NowNs();
+            DoNotOptimize(sum);
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("vector", impl, "copy", key, "sequential", n), n, [&]{
+            unsigned long long t0 = NowNs();
+            V *v = new V(base);
+            unsigned long long t1 = NowNs();
+            delete v;
+            return t1 - t0;
+        });
+        Run(rep, opt, Make("vector", impl, "destroy", key, "sequential", n), n, [&]{
+            V *v = new V(base);
+            unsigned long long t0 = NowNs();
+            delete v;
+            return NowNs() - t0;
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    Options opt(argc, argv);
+    Reporter rep(opt);
+    VectorSuite<sjtu::vector<int>, int>(rep, opt, "sjtu");
+    VectorSuite<std::vector<int>, int>(rep, opt, "std");
+    VectorSuite<sjtu::vector<std::string>, std::string>(rep, opt, "sjtu");
+    VectorSuite<std::vector<std::string>, std::string>(rep, opt, "std");
+    return 0;
+}
@@ -0,0 +1,204 @@
+////分片加锁的并发 linked_hashmap
+////按哈希值把键分到 ShardNum 个分片，每个分片是一个带读写锁的 linked_hashmap，
+////不同分片上的操作互不阻塞，同一分片上的查询可以并发进行。
+////每个分片各自维护插入顺序；每个元素还记录一个全局递增的序号，
+////for_each_ordered 按序号归并各分片，得到全局插入顺序。
+#ifndef SJTU_CONCURRENT_LINKED_HASHMAP_HPP
+#define SJTU_CONCURRENT_LINKED_HASHMAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+
+    template<
+            class Key,
+            class T,
+            class Hash = std::hash<Key>,
+            class Equal = std::equal_to<Key>,
+            size_t ShardNum = 64,
+            class Mix = fast_hash_mix
+    > class concurrent_linked_hashmap {
+        static_assert(ShardNum && !(ShardNum & (ShardNum - 1)), "ShardNum must be a power of two");
+        struct Slot{
+            unsigned long long seq; //全局插入序号
+            T value;
+            Slot(unsigned long long s, const T &v) : seq(s), value(v) {}
+        };
+        typedef linked_hashmap<Key, Slot, Hash, Equal, Mix> shard_map;
+        //每个分片独占缓存行，避免相邻分片的锁互相干扰
+        struct alignas(64) Shard{
+            mutable std::shared_mutex lock;
+            shard_map table;
+        };
+        Shard shards[ShardNum];
+        std::atomic<unsigned long long> seqCounter{0};
+
+        Shard &ShardOf(const Key &key) {
+            return shards[Index(key)];
+        }
+        const Shard &ShardOf(const Key &key) const {
+            return shards[Index(key)];
+        }
+        static size_t Index(const Key &key) {
+            //分片内部还会用低位选桶，这里取高位选分片
+            size_t h = Hash()(key) * (size_t)0x9e3779b97f4a7c15ULL;
+            return (h >> (sizeof(size_t) * 8 - 16)) & (ShardNum - 1);
+        }
+    public:
+        concurrent_linked_hashmap() {}
+        /**
+         * 预计总元素个数，平均分配到各分片
+         */
+        explicit concurrent_linked_hashmap(size_t expected) {
+            for(size_t i = 0; i < ShardNum; ++i)
+                shards[i].table.reserve(expected / ShardNum + 1);
+        }
+        concurrent_linked_hashmap(const concurrent_linked_hashmap &) = delete;
+        concurrent_linked_hashmap &operator = (const concurrent_linked_hashmap &) = delete;
+
+        /**
+         * 插入成功返回 true；键已存在时不修改并返回 false
+         */
+        bool insert(const Key &key, const T &value) {
+            Shard &s = ShardOf(key);
+            std::unique_lock<std::shared_mutex> guard(s.lock);
+            //序号只用于排序，键已存在时白白消耗一个序号也无妨
+            return s.table.try_emplace(key, seqCounter.fetch_add(1, std::memory_order_relaxed), value).second;
+        }
+        /**
+         * 插入或覆盖；覆盖不改变元素的插入序号
+         */
+        void assign(const Key &key, const T &value) {
+            Shard &s = ShardOf(key);
+            std::unique_lock<std::shared_mutex> guard(s.lock);
+            pair<typename shard_map::iterator, bool> res =
+                s.table.try_emplace(key, seqCounter.fetch_add(1, std::memory_order_relaxed), value);
+            if(!res.second)
+                res.first->second.value = value;
+        }
+        /**
+         * 查到时把值拷贝到 out 并返回 true。不返回引用：解锁之后引用随时可能失效
+         */
+        bool find(const Key &key, T &out) const {
+            const Shard &s = ShardOf(key);
+            std::shared_lock<std::shared_mutex> guard(s.lock);
+            typename shard_map::const_iterator res = s.table.find(key);
+            if(res == s.table.cend())
+                return false;
+            out = res->second.value;
+            return true;
+        }
+        size_t count(const Key &key) const {
+            const Shard &s = ShardOf(key);
+            std::shared_lock<std::shared_mutex> guard(s.lock);
+            return s.table.count(key);
+        }
+        /**
+         * 在持有分片写锁的情况下对 key 对应的值调用 f(T &)，键不存在返回 false
+         */
+        template<class F>
+        bool update(const Key &key, F f) {
+            Shard &s = ShardOf(key);
+            std::unique_lock<std::shared_mutex> guard(s.lock);
+            typename shard_map::iterator res = s.table.find(key);
+            if(res == s.table.end())
+                return false;
+            f(res->second.value);
+            return true;
+        }
+        bool erase(const Key &key) {
+            Shard &s = ShardOf(key);
+            std::unique_lock<std::shared_mutex> guard(s.lock);
+            typename shard_map::iterator res = s.table.find(key);
+            if(res == s.table.end())
+                return false;
+            s.table.erase(res);
+            return true;
+        }
+        /**
+         * 各分片大小之和；并发修改时只是一个近似值
+         */
+        size_t size() const {
+            size_t res = 0;
+            for(size_t i = 0; i < ShardNum; ++i){
+                std::shared_lock<std::shared_mutex> guard(shards[i].lock);
+                res += shards[i].table.size();
+            }
+            return res;
+        }
+        bool empty() const {
+            return !size();
+        }
+        void clear() {
+            for(size_t i = 0; i < ShardNum; ++i){
+                std::unique_lock<std::shared_mutex> guard(shards[i].lock);
+                shards[i].table.clear();
+            }
+        }
+        /**
+         * 逐个分片遍历，分片内按插入顺序调用 f(const Key &, const T &)。
+         * 每次只锁一个分片，因此看到的不是整张表的同一时刻快照。
+         */
+        template<class F>
+        void for_each(F f) const {
+            for(size_t i = 0; i < ShardNum; ++i){
+                std::shared_lock<std::shared_mutex> guard(shards[i].lock);
+                for(typename shard_map::const_iterator it = shards[i].table.cbegin(); it != shards[i].table.cend(); ++it)
+                    f(it->first, it->second.value);
+            }
+        }
+        /**
+         * 按全局插入顺序调用 f(const Key &, const T &)。
+         * 遍历期间持有所有分片的读锁，得到一致的快照；按分片下标加锁，不会死锁。
+         */
+        template<class F>
+        void for_each_ordered(F f) const {
+            for(size_t i = 0; i < ShardNum; ++i)
+                shards[i].lock.lock_shared();
+            try{
+                //各分片内部序号递增，用小根堆做 ShardNum 路归并
+                typename shard_map::const_iterator cur[ShardNum];
+                size_t heap[ShardNum], heapSize = 0;
+                auto less = [&](size_t a, size_t b){ return cur[a]->second.seq < cur[b]->second.seq; };
+                auto siftDown = [&](size_t x){
+                    while(true){
+                        size_t l = x * 2 + 1, r = l + 1, m = x;
+                        if(l < heapSize && less(heap[l], heap[m])) m = l;
+                        if(r < heapSize && less(heap[r], heap[m])) m = r;
+                        if(m == x) return;
+                        size_t tmp = heap[x]; heap[x] = heap[m]; heap[m] = tmp;
+                        x = m;
+                    }
+                };
+                for(size_t i = 0; i < ShardNum; ++i){
+                    cur[i] = shards[i].table.cbegin();
+                    if(cur[i] != shards[i].table.cend())
+                        heap[heapSize++] = i;
+                }
+                for(size_t i = heapSize; i-- > 0; )
+                    siftDown(i);
+                while(heapSize){
+                    size_t best = heap[0];
+                    f(cur[best]->first, cur[best]->second.value);
+                    if(++cur[best] == shards[best].table.cend())
+                        heap[0] = heap[--heapSize];
+                    siftDown(0);
+                }
+            }catch(...){
+                for(size_t i = 0; i < ShardNum; ++i)
+                    shards[i].lock.unlock_shared();
+                throw;
+            }
+            for(size_t i = 0; i < ShardNum; ++i)
+                shards[i].lock.unlock_shared();
+        }
+    };
+
+}
+
+#endif
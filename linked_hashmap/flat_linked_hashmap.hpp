@@ -0,0 +1,494 @@
+////实现方法：开放寻址（Swiss table 风格的控制字节）+ 稠密的插入顺序数组
+////槽位只存放 entries 下标，元素按插入顺序连续存放在 entries 中，遍历即顺序扫描。
+////注意：与链式的 linked_hashmap 不同，插入可能搬移 entries，扩容会压缩 entries，
+////因此插入/扩容之后原有的迭代器、指针与引用都会失效。
+////查找以 16 个控制字节为一组探查，支持 SSE2 时一条比较指令即可筛出组内所有候选槽位。
+#ifndef SJTU_FLAT_LINKED_HASHMAP_HPP
+#define SJTU_FLAT_LINKED_HASHMAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "hash_mix.hpp"
+#include "instrument.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sjtu {
+
+    template<
+            class Key,
+            class T,
+            class Hash = std::hash<Key>,
+            class Equal = std::equal_to<Key>,
+            class Mix = fast_hash_mix
+    > class flat_linked_hashmap {
+    public:
+        typedef pair<const Key, T> value_type;
+        struct Entry{
+            size_t hash_value;
+            bool alive; //被删除的元素留下空洞，扩容时压缩
+            alignas(value_type) unsigned char buf[sizeof(value_type)];
+            value_type *data() { return reinterpret_cast<value_type *>(buf); }
+            const value_type *data() const { return reinterpret_cast<const value_type *>(buf); }
+        };
+        //控制字节：最高位为 1 表示空或墓碑，否则低 7 位为哈希值的 h2 部分
+        static const signed char EMPTY = -128;
+        static const signed char DELETED = -2;
+        static const size_t npos = (size_t)-1;
+        static const size_t GroupWidth = 16;
+
+        size_t capacity = 16; //槽位数，始终为 2 的幂且不小于 GroupWidth
+        size_t used = 0; //非 EMPTY 的槽位数（含墓碑），用于控制探查长度
+        signed char *ctrl = nullptr;
+        size_t *slot = nullptr; //槽位 -> entries 下标
+        Entry *entries = nullptr;
+        size_t entryCap = 0, entryNum = 0; //entryNum 包含已删除的空洞
+        size_t num = 0, first = 0; //first 为第一个存活元素的下标
+
+        class const_iterator;
+        class iterator {
+            friend class flat_linked_hashmap;
+            friend class const_iterator;
+        private:
+            size_t pos = 0;
+            const flat_linked_hashmap *from = nullptr;
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+            using iterator_category = std::output_iterator_tag;
+
+            iterator() {}
+            iterator(size_t p, const flat_linked_hashmap *f){
+                pos = p;
+                from = f;
+            }
+            iterator(const iterator &other) {
+                pos = other.pos;
+                from = other.from;
+            }
+            iterator operator++(int) {
+                iterator res = *this;
+                ++*this;
+                return res;
+            }
+            iterator & operator++() {
+                if(from == nullptr || pos >= from->entryNum)
+                    throw invalid_iterator();
+                pos = from->nextAlive(pos + 1);
+                return *this;
+            }
+            iterator operator--(int) {
+                iterator res = *this;
+                --*this;
+                return res;
+            }
+            iterator & operator--() {
+                if(from == nullptr || pos <= from->first)
+                    throw invalid_iterator();
+                pos = from->prevAlive(pos - 1);
+                return *this;
+            }
+            flat_linked_hashmap::value_type & operator*() const {
+                if(from == nullptr || pos >= from->entryNum || !from->entries[pos].alive)
+                    throw invalid_iterator();
+                return *(from->entries[pos].data());
+            }
+            flat_linked_hashmap::value_type* operator->() const {
+                if(from == nullptr || pos >= from->entryNum || !from->entries[pos].alive)
+                    throw invalid_iterator();
+                return from->entries[pos].data();
+            }
+            bool operator==(const iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator==(const const_iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator!=(const iterator &rhs) const {
+                return pos != rhs.pos || from != rhs.from;
+            }
+            bool operator!=(const const_iterator &rhs) const {
+                return pos != rhs.pos || from != rhs.from;
+            }
+        };
+
+        class const_iterator {
+            friend class flat_linked_hashmap;
+            friend class iterator;
+        private:
+            size_t pos = 0;
+            const flat_linked_hashmap *from = nullptr;
+        public:
+            const_iterator() {}
+            const_iterator(size_t p, const flat_linked_hashmap *f){
+                pos = p;
+                from = f;
+            }
+            const_iterator(const const_iterator &other) {
+                pos = other.pos;
+                from = other.from;
+            }
+            const_iterator(const iterator &other) {
+                pos = other.pos;
+                from = other.from;
+            }
+            const_iterator operator++(int){
+                const_iterator res = *this;
+                ++*this;
+                return res;
+            }
+            const_iterator &operator++(){
+                if(from == nullptr || pos >= from->entryNum)
+                    throw invalid_iterator();
+                pos = from->nextAlive(pos + 1);
+                return *this;
+            }
+            const_iterator operator--(int){
+                const_iterator res = *this;
+                --*this;
+                return res;
+            }
+            const_iterator &operator--(){
+                if(from == nullptr || pos <= from->first)
+                    throw invalid_iterator();
+                pos = from->prevAlive(pos - 1);
+                return *this;
+            }
+            const flat_linked_hashmap::value_type & operator*() const {
+                if(from == nullptr || pos >= from->entryNum || !from->entries[pos].alive)
+                    throw invalid_iterator();
+                return *(from->entries[pos].data());
+            }
+            const flat_linked_hashmap::value_type* operator->() const {
+                if(from == nullptr || pos >= from->entryNum || !from->entries[pos].alive)
+                    throw invalid_iterator();
+                return from->entries[pos].data();
+            }
+            bool operator==(const iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator==(const const_iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator!=(const iterator &rhs) const {
+                return pos != rhs.pos || from != rhs.from;
+            }
+            bool operator!=(const const_iterator &rhs) const {
+                return pos != rhs.pos || from != rhs.from;
+            }
+        };
+
+        flat_linked_hashmap() {
+            AllocSlots(capacity);
+        }
+        flat_linked_hashmap(const flat_linked_hashmap &other) {
+            capacity = other.capacity;
+            AllocSlots(capacity);
+            try{
+                Reserve(other.num);
+                for(size_t i = other.first; i < other.entryNum; ++i)
+                    if(other.entries[i].alive)
+                        insert(*(other.entries[i].data()));
+            }catch(...){
+                //构造函数抛出时不会调用析构函数，这里自己释放
+                clear();
+                free(ctrl);
+                free(slot);
+                free(entries);
+                throw;
+            }
+        }
+
+        flat_linked_hashmap & operator=(const flat_linked_hashmap &other) {
+            if(this == &other) return *this;
+            clear();
+            Reserve(other.num);
+            for(size_t i = other.first; i < other.entryNum; ++i)
+                if(other.entries[i].alive)
+                    insert(*(other.entries[i].data()));
+            return *this;
+        }
+
+        ~flat_linked_hashmap() {
+            clear();
+            free(ctrl);
+            free(slot);
+            free(entries);
+        }
+        T & at(const Key &key) {
+            size_t s = FindSlot(key, MyHash(key));
+            if(s == npos)
+                throw index_out_of_bound();
+            return entries[slot[s]].data()->second;
+        }
+        const T & at(const Key &key) const {
+            size_t s = FindSlot(key, MyHash(key));
+            if(s == npos)
+                throw index_out_of_bound();
+            return entries[slot[s]].data()->second;
+        }
+        T & operator[](const Key &key) {
+            size_t s = FindSlot(key, MyHash(key));
+            if(s == npos)
+                return insert(value_type(key, T())).first->second;
+            return entries[slot[s]].data()->second;
+        }
+        const T & operator[](const Key &key) const {
+            return at(key);
+        }
+        iterator begin() {
+            return iterator(first, this);
+        }
+        const_iterator cbegin() const {
+            return const_iterator(first, this);
+        }
+        iterator end() {
+            return iterator(entryNum, this);
+        }
+        const_iterator cend() const {
+            return const_iterator(entryNum, this);
+        }
+        bool empty() const {
+            return !num;
+        }
+        size_t size() const {
+            return num;
+        }
+        void clear() {
+            for(size_t i = first; i < entryNum; ++i)
+                if(entries[i].alive)
+                    entries[i].data()->~value_type();
+            for(size_t i = 0; i < capacity; ++i)
+                ctrl[i] = EMPTY;
+            num = used = entryNum = first = 0;
+        }
+        pair<iterator, bool> insert(const value_type &value) {
+            size_t h = MyHash(value.first);
+            size_t s = FindSlot(value.first, h);
+            if(s != npos)
+                return {iterator(slot[s], this), false};
+            if((used + 1) * 8 > capacity * 7)
+                Rehash(num + 1 > capacity / 2 ? capacity << 1 : capacity);
+            if(entryNum == entryCap)
+                GrowEntries();
+            //先构造元素，拷贝抛出异常时表中还没有任何槽位指向它
+            Entry &e = entries[entryNum];
+            new (e.buf) value_type(value);
+            e.hash_value = h;
+            e.alive = true;
+            s = FindInsertSlot(h);
+            if(ctrl[s] == EMPTY)
+                used++;
+            ctrl[s] = H2(h);
+            slot[s] = entryNum;
+            if(num == 0)
+                first = entryNum;
+            num++;
+            return {iterator(entryNum++, this), true};
+        }
+        void erase(iterator pos) {
+            if(pos.from != this || pos.pos >= entryNum || !entries[pos.pos].alive)
+                throw invalid_iterator();
+            Entry &e = entries[pos.pos];
+            size_t s = FindSlot(e.data()->first, e.hash_value);
+            //组内还有空槽说明没有探查越过这一组，可以直接置空而不留墓碑
+            if(MatchByte(ctrl + (s & ~(GroupWidth - 1)), EMPTY)){
+                ctrl[s] = EMPTY;
+                used--;
+            }
+            else
+                ctrl[s] = DELETED;
+            e.data()->~value_type();
+            e.alive = false;
+            num--;
+            if(num == 0){
+                //全部删空时直接回收空洞与墓碑
+                for(size_t i = 0; i < capacity; ++i)
+                    ctrl[i] = EMPTY;
+                used = entryNum = first = 0;
+                return;
+            }
+            if(pos.pos == first)
+                first = nextAlive(first + 1);
+            while(!entries[entryNum - 1].alive)
+                entryNum--;
+        }
+        size_t count(const Key &key) const {
+            return FindSlot(key, MyHash(key)) == npos ? 0 : 1;
+        }
+        iterator find(const Key &key) {
+            size_t s = FindSlot(key, MyHash(key));
+            if(s == npos)
+                return end();
+            return iterator(slot[s], this);
+        }
+        const_iterator find(const Key &key) const {
+            size_t s = FindSlot(key, MyHash(key));
+            if(s == npos)
+                return cend();
+            return const_iterator(slot[s], this);
+        }
+
+    private:
+        size_t MyHash(const Key &o) const {
+            return Mix()(Hash()(o));
+        }
+        static signed char H2(size_t h) {
+            return (signed char)(h & 0x7F);
+        }
+        size_t nextAlive(size_t p) const {
+            while(p < entryNum && !entries[p].alive) ++p;
+            return p;
+        }
+        size_t prevAlive(size_t p) const {
+            while(!entries[p].alive) --p;
+            return p;
+        }
+        //返回组内等于 b 的控制字节的位掩码
+        static unsigned MatchByte(const signed char *g, signed char b) {
+#if defined(__SSE2__)
+            __m128i ctrlv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g));
+            return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(b), ctrlv));
+#else
+            unsigned res = 0;
+            for(size_t i = 0; i < GroupWidth; ++i)
+                if(g[i] == b) res |= 1u << i;
+            return res;
+#endif
+        }
+        //返回组内空槽或墓碑（最高位为 1）的位掩码
+        static unsigned MatchFree(const signed char *g) {
+#if defined(__SSE2__)
+            return (unsigned) _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(g)));
+#else
+            unsigned res = 0;
+            for(size_t i = 0; i < GroupWidth; ++i)
+                if(g[i] < 0) res |= 1u << i;
+            return res;
+#endif
+        }
+        static size_t LowBit(unsigned mask) {
+#if defined(__GNUC__)
+            return __builtin_ctz(mask);
+#else
+            size_t res = 0;
+            while(!(mask & 1)) mask >>= 1, ++res;
+            return res;
+#endif
+        }
+        //按组线性探查：遇到含空槽的组即可停止，因为插入时不会越过它
+        size_t FindSlot(const Key &key, size_t h) const {
+            size_t mask = capacity - 1, g = ((h >> 7) * GroupWidth) & mask;
+            signed char tag = H2(h);
+            while(true){
+                for(unsigned m = MatchByte(ctrl + g, tag); m; m &= m - 1){
+                    size_t s = g + LowBit(m);
+                    const Entry &e = entries[slot[s]];
+                    if(e.hash_value == h && Equal()(e.data()->first, key))
+                        return s;
+                }
+                if(MatchByte(ctrl + g, EMPTY))
+                    return npos;
+                g = (g + GroupWidth) & mask;
+            }
+        }
+        size_t FindInsertSlot(size_t h) const {
+            size_t mask = capacity - 1, g = ((h >> 7) * GroupWidth) & mask;
+            while(true){
+                unsigned m = MatchFree(ctrl + g);
+                if(m)
+                    return g + LowBit(m);
+                g = (g + GroupWidth) & mask;
+            }
+        }
+        //换成 cap 个全空的槽位；申请失败时抛 std::bad_alloc，原有槽位保持不变
+        void AllocSlots(size_t cap){
+            signed char *c = (signed char *) malloc(cap * sizeof(signed char));
+            size_t *s = (size_t *) malloc(cap * sizeof(size_t));
+            if(!c || !s){
+                free(c);
+                free(s);
+                throw std::bad_alloc();
+            }
+            for(size_t i = 0; i < cap; ++i)
+                c[i] = EMPTY;
+            free(ctrl);
+            free(slot);
+            ctrl = c;
+            slot = s;
+        }
+        void Reserve(size_t n){
+            if(n <= entryCap) return;
+            Entry *tmp = (Entry *) malloc(n * sizeof(Entry));
+            if(!tmp)
+                throw std::bad_alloc();
+            size_t cnt = 0;
+            for(size_t i = first; i < entryNum; ++i)
+                if(entries[i].alive){
+                    new (tmp[cnt].buf) value_type(static_cast<value_type &&>(*(entries[i].data())));
+                    entries[i].data()->~value_type();
+                    tmp[cnt].hash_value = entries[i].hash_value;
+                    tmp[cnt].alive = true;
+                    cnt++;
+                }
+            free(entries);
+            entries = tmp;
+            entryCap = n;
+            entryNum = cnt;
+            first = 0;
+        }
+        void GrowEntries(){
+            //空洞过多时原地压缩，否则按两倍扩张；两种情况都需要重建槽位
+            if(entryNum - num > num)
+                Rehash(capacity);
+            else{
+                Reserve(entryCap ? entryCap << 1 : 8);
+                Rehash(capacity);
+            }
+        }
+        void Rehash(size_t newCap){
+            SJTU_INSTRUMENT_ADD(hashmap_rehashes, 1);
+            //先申请新槽位，失败时 entries 与槽位都还没有改动
+            if(newCap != capacity){
+                AllocSlots(newCap);
+                capacity = newCap;
+            }
+            else
+                for(size_t i = 0; i < capacity; ++i)
+                    ctrl[i] = EMPTY;
+            if(entryNum != num){
+                //压缩 entries，保持插入顺序
+                size_t cnt = 0;
+                for(size_t i = first; i < entryNum; ++i)
+                    if(entries[i].alive){
+                        if(i != cnt){
+                            new (entries[cnt].buf) value_type(static_cast<value_type &&>(*(entries[i].data())));
+                            entries[i].data()->~value_type();
+                            entries[cnt].hash_value = entries[i].hash_value;
+                            entries[cnt].alive = true;
+                            entries[i].alive = false;
+                        }
+                        cnt++;
+                    }
+                entryNum = cnt;
+                first = 0;
+            }
+            for(size_t i = 0; i < entryNum; ++i){
+                size_t s = FindInsertSlot(entries[i].hash_value);
+                ctrl[s] = H2(entries[i].hash_value);
+                slot[s] = i;
+            }
+            used = entryNum;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+////哈希值的二次混合策略，作为 linked_hashmap / flat_linked_hashmap 的模板参数 Mix。
+////std::hash 对整数和指针往往是恒等映射，直接取低位选桶会在连续键上严重聚集，
+////因此在取模之前要把高位的信息混合到低位。所有策略都输出完整的 size_t。
+#ifndef SJTU_HASH_MIX_HPP
+#define SJTU_HASH_MIX_HPP
+
+#include <cstddef>
+
+namespace sjtu {
+
+    /**
+     * 默认策略：wyhash 风格的乘法折叠，一次 64x64->128 位乘法后高低位异或。
+     * 没有 128 位整数时退化为 xorshift-multiply-xorshift。
+     */
+    struct fast_hash_mix {
+        size_t operator()(size_t h) const {
+#if defined(__SIZEOF_INT128__)
+            unsigned __int128 r = (unsigned __int128)(unsigned long long) h * 0x9e3779b97f4a7c15ULL;
+            return (size_t)((unsigned long long)(r >> 64) ^ (unsigned long long) r);
+#else
+            unsigned long long x = h;
+            x ^= x >> 32;
+            x *= 0xd6e8feb86659fd93ULL;
+            x ^= x >> 32;
+            return (size_t) x;
+#endif
+        }
+    };
+
+    /**
+     * MurmurHash3 的 fmix64，雪崩效果更好，代价是两次乘法
+     */
+    struct murmur_hash_mix {
+        size_t operator()(size_t h) const {
+            unsigned long long x = h;
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return (size_t) x;
+        }
+    };
+
+    /**
+     * 原先 linked_hashmap 使用的 Java HashMap 式移位异或（仅作对比用）
+     */
+    struct legacy_hash_mix {
+        size_t operator()(size_t h) const {
+            h ^= (h >> 20) ^ (h >> 12);
+            return h ^ (h >> 7) ^ (h >> 4);
+        }
+    };
+
+    /**
+     * 不做混合，适用于 Hash 本身已经足够均匀的情况
+     */
+    struct identity_hash_mix {
+        size_t operator()(size_t h) const {
+            return h;
+        }
+    };
+
+}
+
+#endif
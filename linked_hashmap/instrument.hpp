@@ -0,0 +1,103 @@
+////容器内部事件计数，编译期开关：定义 SJTU_STLITE_INSTRUMENT 后生效。
+////关闭时各埋点展开为空语句，参数不会被求值，没有任何运行期开销；
+////开启时计数器是全局的 relaxed 原子量，可在任意线程读取快照。
+////四个目录各有一份相同的拷贝，同时包含多个容器时只会生效一份。
+#ifndef SJTU_INSTRUMENT_HPP
+#define SJTU_INSTRUMENT_HPP
+
+#ifdef SJTU_STLITE_INSTRUMENT
+#include <atomic>
+#endif
+
+namespace sjtu {
+
+    /**
+     * 计数器快照。未开启埋点时所有字段恒为 0
+     */
+    struct instrument_counters {
+        unsigned long long vector_reallocations = 0; //vector 扩容次数
+        unsigned long long vector_element_moves = 0; //扩容、插入、删除时搬动的元素个数
+        unsigned long long priority_queue_merges = 0; //斜堆合并的递归步数
+        unsigned long long priority_queue_node_allocations = 0;
+        unsigned long long map_rotations = 0; //LL / RR / LR / RL 各计一次
+        unsigned long long map_descents = 0; //查找、插入、删除时向下走的层数
+        unsigned long long map_comparisons = 0; //Compare 的调用次数
+        unsigned long long hashmap_rehashes = 0; //桶数组的重建次数
+        unsigned long long hashmap_lookups = 0;
+        unsigned long long hashmap_chain_steps = 0; //查找时在链上比较过的结点数之和
+        unsigned long long hashmap_longest_chain = 0; //单次查找比较过的最多结点数
+    };
+
+#ifdef SJTU_STLITE_INSTRUMENT
+    namespace instrument_detail {
+        struct Counters {
+            std::atomic<unsigned long long> vector_reallocations{0};
+            std::atomic<unsigned long long> vector_element_moves{0};
+            std::atomic<unsigned long long> priority_queue_merges{0};
+            std::atomic<unsigned long long> priority_queue_node_allocations{0};
+            std::atomic<unsigned long long> map_rotations{0};
+            std::atomic<unsigned long long> map_descents{0};
+            std::atomic<unsigned long long> map_comparisons{0};
+            std::atomic<unsigned long long> hashmap_rehashes{0};
+            std::atomic<unsigned long long> hashmap_lookups{0};
+            std::atomic<unsigned long long> hashmap_chain_steps{0};
+            std::atomic<unsigned long long> hashmap_longest_chain{0};
+        };
+        inline Counters &Global() {
+            static Counters c;
+            return c;
+        }
+        inline void UpdateMax(std::atomic<unsigned long long> &a, unsigned long long v) {
+            unsigned long long old = a.load(std::memory_order_relaxed);
+            while(old < v && !a.compare_exchange_weak(old, v, std::memory_order_relaxed));
+        }
+    }
+
+#define SJTU_INSTRUMENT_ADD(counter, n) \
+    (::sjtu::instrument_detail::Global().counter.fetch_add((n), std::memory_order_relaxed))
+#define SJTU_INSTRUMENT_MAX(counter, v) \
+    (::sjtu::instrument_detail::UpdateMax(::sjtu::instrument_detail::Global().counter, (v)))
+
+    inline instrument_counters instrument_snapshot() {
+        instrument_detail::Counters &c = instrument_detail::Global();
+        instrument_counters res;
+        res.vector_reallocations = c.vector_reallocations.load(std::memory_order_relaxed);
+        res.vector_element_moves = c.vector_element_moves.load(std::memory_order_relaxed);
+        res.priority_queue_merges = c.priority_queue_merges.load(std::memory_order_relaxed);
+        res.priority_queue_node_allocations = c.priority_queue_node_allocations.load(std::memory_order_relaxed);
+        res.map_rotations = c.map_rotations.load(std::memory_order_relaxed);
+        res.map_descents = c.map_descents.load(std::memory_order_relaxed);
+        res.map_comparisons = c.map_comparisons.load(std::memory_order_relaxed);
+        res.hashmap_rehashes = c.hashmap_rehashes.load(std::memory_order_relaxed);
+        res.hashmap_lookups = c.hashmap_lookups.load(std::memory_order_relaxed);
+        res.hashmap_chain_steps = c.hashmap_chain_steps.load(std::memory_order_relaxed);
+        res.hashmap_longest_chain = c.hashmap_longest_chain.load(std::memory_order_relaxed);
+        return res;
+    }
+    inline void instrument_reset() {
+        instrument_detail::Counters &c = instrument_detail::Global();
+        c.vector_reallocations.store(0, std::memory_order_relaxed);
+        c.vector_element_moves.store(0, std::memory_order_relaxed);
+        c.priority_queue_merges.store(0, std::memory_order_relaxed);
+        c.priority_queue_node_allocations.store(0, std::memory_order_relaxed);
+        c.map_rotations.store(0, std::memory_order_relaxed);
+        c.map_descents.store(0, std::memory_order_relaxed);
+        c.map_comparisons.store(0, std::memory_order_relaxed);
+        c.hashmap_rehashes.store(0, std::memory_order_relaxed);
+        c.hashmap_lookups.store(0, std::memory_order_relaxed);
+        c.hashmap_chain_steps.store(0, std::memory_order_relaxed);
+        c.hashmap_longest_chain.store(0, std::memory_order_relaxed);
+    }
+#else
+#define SJTU_INSTRUMENT_ADD(counter, n) ((void) 0)
+#define SJTU_INSTRUMENT_MAX(counter, v) ((void) 0)
+
+    inline instrument_counters instrument_snapshot() {
+        return instrument_counters();
+    }
+    inline void instrument_reset() {}
+#endif
+
+}
+
+#endif
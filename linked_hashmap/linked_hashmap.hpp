@@ -1,10 +1,25 @@
-#ifndef SJTU_MAP_HPP
-#define SJTU_MAP_HPP
+#ifndef SJTU_LINKED_HASHMAP_HPP
+#define SJTU_LINKED_HASHMAP_HPP
 
 #include <functional>
 #include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "hash_mix.hpp"
+#include "instrument.hpp"
+
+//迭代器检查策略：开启时迭代器额外记录容器的代数，每次移动、解引用都检查越界与失效；
+//关闭时迭代器只做指针操作。默认随 NDEBUG 关闭，也可以在包含头文件前显式定义为 0 / 1。
+#ifndef SJTU_CHECKED_ITERATORS
+#ifdef NDEBUG
+#define SJTU_CHECKED_ITERATORS 0
+#else
+#define SJTU_CHECKED_ITERATORS 1
+#endif
+#endif
 
 namespace sjtu {
 
@@ -12,39 +27,132 @@ namespace sjtu {
             class Key,
             class T,
             class Hash = std::hash<Key>,
-            class Equal = std::equal_to<Key>
+            class Equal = std::equal_to<Key>,
+            class Mix = fast_hash_mix
     > class linked_hashmap {
     public:
         typedef pair<const Key, T> value_type;
+        class NodePool;
         struct Node{
-            value_type *data = nullptr;
-            int hash_value = -1; //hash_code + rehash 运算后的值;
+            alignas(value_type) unsigned char buf[sizeof(value_type)]; //元素直接存放在结点内
+            size_t hash_value = 0; //Hash 再经 Mix 混合后的完整哈希值
             Node *nxtData = nullptr; //单链表存储
             Node *preIns = nullptr, *nxtIns = nullptr; //提供双链表的遍历循序
-            Node(){}
-            Node(const Node &other){
-                data = new value_type (*(other.data));
-                hash_value = other.hash_value;
+            value_type *data() { return reinterpret_cast<value_type *>(buf); }
+            const value_type *data() const { return reinterpret_cast<const value_type *>(buf); }
+        };
+        //结点池：按块批量申请结点，删除的结点挂到空闲链表（复用 nxtData）上，clear 时整体回收。
+        //结点经句柄或 merge 进入其他容器后就归那个容器的池管理，但内存仍在原池的块里，
+        //所以交换过结点的池合并成一组、共用一个引用计数（每个容器持有 1，每个未插回的句柄持有 1），
+        //计数归零时整组一起释放。结点本身不记录所属的池。
+        class NodePool{
+        private:
+            struct Block{
+                Block *nxt;
+                size_t cap;
+                Node *nodes;
+            };
+            Block *head = nullptr, *cur = nullptr;
+            size_t used = 0, nextCap = 16;
+            Node *freeList = nullptr;
+            NodePool *root = this; //所在组的根，引用计数记在根上
+            NodePool *nextMember = nullptr; //组内成员链表，从根开始
+            size_t refs = 1;
+        public:
+            size_t lent = 0; //借给结点句柄、尚未插回的结点个数
+            bool donated = false; //曾有结点转入其他池，块中的结点不再全归本池管理
+            NodePool() {}
+            NodePool(const NodePool &) = delete;
+            NodePool &operator = (const NodePool &) = delete;
+            ~NodePool(){
+                while(head){
+                    Block *tmp = head->nxt;
+                    free(head->nodes);
+                    delete head;
+                    head = tmp;
+                }
+            }
+            Node *allocate(){
+                Node *p;
+                if(freeList){
+                    p = freeList;
+                    freeList = freeList->nxtData;
+                }
+                else{
+                    if(cur == nullptr || used == cur->cap){
+                        if(cur && cur->nxt) cur = cur->nxt; //reset 之后复用已有的块
+                        else if(cur == nullptr && head) cur = head;
+                        else{
+                            Block *b = new Block;
+                            b->nxt = nullptr;
+                            b->cap = nextCap;
+                            b->nodes = (Node *) malloc(nextCap * sizeof(Node));
+                            if(!b->nodes){
+                                delete b;
+                                throw std::bad_alloc();
+                            }
+                            if(nextCap < 4096) nextCap <<= 1;
+                            if(cur) cur->nxt = b;
+                            else head = b;
+                            cur = b;
+                        }
+                        used = 0;
+                    }
+                    p = cur->nodes + used++;
+                }
+                return new (p) Node;
             }
-            Node(const value_type &val, const int &hash){
-                data = new value_type (val);
-                hash_value = hash;
+            void deallocate(Node *p){
+                p->nxtData = freeList;
+                freeList = p;
             }
-            Node &operator = (const Node &other){
-                if(this == &other)
-                    return *this;
-                delete data;
-                data = new value_type (*(other.data));
-                hash_value = other.hash_value;
+            void Retain(){
+                root->refs++;
             }
-            ~Node(){
-                delete data;
+            void Release(){
+                NodePool *p = root;
+                if(--p->refs == 0)
+                    while(p){
+                        NodePool *tmp = p->nextMember;
+                        delete p;
+                        p = tmp;
+                    }
+            }
+            //把 other 所在的组并入本组
+            void Join(NodePool *other){
+                NodePool *a = root, *b = other->root;
+                if(a == b) return;
+                a->refs += b->refs;
+                NodePool *las = a;
+                while(las->nextMember) las = las->nextMember;
+                las->nextMember = b;
+                for(; b; b = b->nextMember) b->root = a;
+            }
+            //没有借出或转出的结点时，容器里的结点之外块中都是空闲的，可以整体回收
+            bool Exclusive() const {
+                return lent == 0 && !donated;
+            }
+            void reset(){
+                freeList = nullptr;
+                cur = nullptr;
+                used = 0;
             }
         };
         size_t capacity = 16, num = 0;
         double LoadFactor = 0.75;
         Node **array = nullptr;
+        //渐进式扩容：oldArray 中下标 >= migratePos 的桶尚未迁移到 array
+        Node **oldArray = nullptr;
+        size_t oldCapacity = 0, migratePos = 0;
+        bool incremental = false;
+        static const size_t MigrateStep = 4; //每次插入/删除迁移的旧桶数
+        static const size_t MaxBuckets = (size_t)1 << (sizeof(size_t) * 8 - 4); //桶数上限，保证字节数与下标计算不溢出
+        static constexpr double MinLoadFactor = 0.01; //过小的负载因子只会让桶数失控
         Node *head = nullptr, *tail = nullptr;
+        NodePool *pool = new NodePool;
+#if SJTU_CHECKED_ITERATORS
+        size_t generation = 0; //clear 时加一：结点池整体回收后旧结点的地址会被复用
+#endif
         class const_iterator;
         class iterator {
             friend class linked_hashmap;
@@ -52,6 +160,16 @@ namespace sjtu {
         private:
             Node *ptr = nullptr;
             const linked_hashmap *from = nullptr;
+#if SJTU_CHECKED_ITERATORS
+            size_t gen = 0; //创建时容器的代数
+#endif
+            bool Stale() const {
+#if SJTU_CHECKED_ITERATORS
+                return from && gen != from->generation;
+#else
+                return false;
+#endif
+            }
         public:
             // The following code is written for the C++ type_traits library.
             // Type traits is a C++ feature for describing certain properties of a type.
@@ -74,46 +192,44 @@ namespace sjtu {
             iterator(Node *p, const linked_hashmap *f){
                 ptr = p;
                 from = f;
+#if SJTU_CHECKED_ITERATORS
+                if(from) gen = from->generation;
+#endif
             }
-            iterator(const iterator &other) {
-                ptr = other.ptr;
-                from = other.from;
-            }
+            iterator(const iterator &other) = default;
             iterator operator++(int) {
-                if(ptr == from->tail || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr == from->tail || Stale()))
                     throw invalid_iterator();
                 iterator res = *this;
                 ptr = ptr->nxtIns;
                 return res;
             }
             iterator & operator++() {
-                if(ptr == from->tail || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr == from->tail || Stale()))
                     throw invalid_iterator();
                 ptr = ptr->nxtIns;
                 return *this;
             }
             iterator operator--(int) {
-                if(ptr == from->head->nxtIns || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr->preIns == from->head || Stale()))
                     throw invalid_iterator();
                 iterator res = *this;
                 ptr = ptr->preIns;
                 return res;
             }
             iterator & operator--() {
-                if(ptr == from->head->nxtIns || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr->preIns == from->head || Stale()))
                     throw invalid_iterator();
                 ptr = ptr->preIns;
                 return *this;
             }
             linked_hashmap::value_type & operator*() const {
-                if(ptr == nullptr || ptr == from->tail || ptr == from->head)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr == from->tail || ptr == from->head || Stale()))
                     throw invalid_iterator();
-                return *(ptr->data);
+                return *(ptr->data());
             }
-            linked_hashmap::value_type* operator->() const noexcept {
-                if(ptr == nullptr || ptr == from->tail || ptr == from->head)
-                    throw invalid_iterator();
-                return ptr->data;
+            linked_hashmap::value_type* operator->() const {
+                return &**this;
             }
             bool operator==(const iterator &rhs) const {
                 return from == rhs.from && ptr == rhs.ptr;
@@ -135,55 +251,66 @@ namespace sjtu {
         private:
             Node *ptr = nullptr;
             const linked_hashmap *from = nullptr;
+#if SJTU_CHECKED_ITERATORS
+            size_t gen = 0;
+#endif
+            bool Stale() const {
+#if SJTU_CHECKED_ITERATORS
+                return from && gen != from->generation;
+#else
+                return false;
+#endif
+            }
         public:
             const_iterator() {}
             const_iterator(Node *p, const linked_hashmap *f){
                 ptr = p;
                 from = f;
+#if SJTU_CHECKED_ITERATORS
+                if(from) gen = from->generation;
+#endif
             }
-            const_iterator(const const_iterator &other) {
-                ptr = other.ptr;
-                from = other.from;
-            }
+            const_iterator(const const_iterator &other) = default;
             const_iterator(const iterator &other) {
                 ptr = other.ptr;
                 from = other.from;
+#if SJTU_CHECKED_ITERATORS
+                gen = other.gen;
+#endif
             }
             const_iterator operator++(int){
-                if(ptr == from->tail || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr == from->tail || Stale()))
                     throw invalid_iterator();
                 const_iterator res = *this;
                 ptr = ptr->nxtIns;
                 return res;
             }
             const_iterator &operator++(){
-                if(ptr == from->tail || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr == from->tail || Stale()))
                     throw invalid_iterator();
                 ptr = ptr->nxtIns;
                 return *this;
             };
             const_iterator operator--(int){
-                if(ptr == from->head->nxtIns || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr->preIns == from->head || Stale()))
                     throw invalid_iterator();
                 const_iterator res = *this;
                 ptr = ptr->preIns;
                 return res;
             }
             const_iterator &operator--(){
-                if(ptr == from->head->nxtIns || ptr == nullptr)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr->preIns == from->head || Stale()))
                     throw invalid_iterator();
                 ptr = ptr->preIns;
                 return *this;
             }
             const linked_hashmap::value_type & operator*() const {
-                if(ptr == nullptr || ptr == from->tail || ptr == from->head)
+                if(SJTU_CHECKED_ITERATORS && (ptr == nullptr || ptr == from->tail || ptr == from->head || Stale()))
                     throw invalid_iterator();
-                return *(ptr->data);
+                return *(ptr->data());
             }
-            const linked_hashmap::value_type* operator->() const noexcept{
-                if(ptr == nullptr || ptr == from->tail || ptr == from->head)
-                    throw invalid_iterator();
-                return ptr->data;
+            const linked_hashmap::value_type* operator->() const {
+                return &**this;
             }
             bool operator==(const iterator &rhs) const {
                 return from == rhs.from && ptr == rhs.ptr;
@@ -200,82 +327,77 @@ namespace sjtu {
         };
 
         linked_hashmap() {
-            array = new Node *[capacity];
+            array = NewArray(capacity);
+            head = new Node;
+            tail = new Node;
+            head->nxtIns = tail;
+            tail->preIns = head;
+        }
+        /**
+         * 按预计元素个数预先分配桶，装入 expected 个元素的过程中不会扩容
+         */
+        explicit linked_hashmap(size_t expected) {
+            capacity = BucketsFor(expected);
+            array = NewArray(capacity);
             head = new Node;
             tail = new Node;
             head->nxtIns = tail;
             tail->preIns = head;
-            for(int i = 0; i < capacity; ++i)
-                array[i] = nullptr;
         }
         linked_hashmap(const linked_hashmap &other) {
             capacity = other.capacity;
-            array = new Node *[capacity];
+            LoadFactor = other.LoadFactor;
+            incremental = other.incremental;
+            array = NewArray(capacity);
             head = new Node;
             tail = new Node;
             head->nxtIns = tail;
             tail->preIns = head;
-            for(int i = 0; i < capacity; ++i)
-                array[i] = nullptr;
             for(Node *p = other.head->nxtIns; p != other.tail; p = p->nxtIns)
-                insert(*(p->data));
+                insert(*(p->data()));
         }
 
         linked_hashmap & operator=(const linked_hashmap &other) {
             if(this == &other) return *this;
             clear();
+            LoadFactor = other.LoadFactor;
+            incremental = other.incremental;
             for(Node *p = other.head->nxtIns; p != other.tail; p = p->nxtIns)
-                insert(*(p->data));
+                insert(*(p->data()));
             return *this;
         }
 
         ~linked_hashmap() {
             clear();
-            delete []array;
+            free(array);
+            free(oldArray);
             delete head;
             delete tail;
+            pool->Release();
         }
         T & at(const Key &key) {
-            int pos = GetIndex(MyHash(key));
-            Node *p = array[pos];
-            bool flag = 0;
-            while(p){
-                if(Equal()(p->data->first, key)){
-                    flag = 1;
-                    break;
-                }
-                p = p->nxtData;
-            }
-            if(!flag)
+            Node *p = FindNode(key, MyHash(key));
+            if(p == nullptr)
                 throw index_out_of_bound();
-            return p->data->second;
+            return p->data()->second;
         }
         const T & at(const Key &key) const {
-            int pos = GetIndex(MyHash(key));
-            Node *p = array[pos];
-            bool flag = 0;
-            while(p){
-                if(Equal()(p->data->first, key)){
-                    flag = 1;
-                    break;
-                }
-                p = p->nxtData;
-            }
-            if(!flag)
+            Node *p = FindNode(key, MyHash(key));
+            if(p == nullptr)
                 throw index_out_of_bound();
-            return p->data->second;
+            return p->data()->second;
         }
         T & operator[](const Key &key) {
-            const_iterator res = find(key);
-            if(res == cend())
-                return insert(value_type(key, T())).first.ptr->data->second;
-            return res.ptr->data->second;
+            return try_emplace(key).first.ptr->data()->second;
+        }
+        T & operator[](Key &&key) {
+            return try_emplace(static_cast<Key &&>(key)).first.ptr->data()->second;
         }
         const T & operator[](const Key &key) const {
             const_iterator res = find(key);
             if(res == cend())
                 throw index_out_of_bound();
-            return res.ptr->data->second;
+            return res.ptr->data()->second;
         }
         iterator begin() {
             return iterator(head->nxtIns, this);
@@ -296,118 +418,544 @@ namespace sjtu {
             return num;
         }
         void clear() {
-            for(int i = 0; i < capacity; ++i)
-                if(array[i] != nullptr){
-                    Node *p = array[i], *tmp;
-                    while(p){
-                        tmp = p->nxtData;
-                        delete p;
-                        p = tmp;
-                    }
-                    array[i] = nullptr;
+            if(pool->Exclusive()){
+                //本池的结点都在本容器中，整体回收；来自其他池的结点随所在组释放
+                if(!std::is_trivially_destructible<value_type>::value)
+                    for(Node *p = head->nxtIns; p != tail; p = p->nxtIns)
+                        p->data()->~value_type();
+                pool->reset();
+            }
+            else
+                for(Node *p = head->nxtIns, *tmp; p != tail; p = tmp){
+                    tmp = p->nxtIns;
+                    DelNode(p);
                 }
+            for(size_t i = 0; i < capacity; ++i)
+                array[i] = nullptr;
+            free(oldArray);
+            oldArray = nullptr;
+            oldCapacity = migratePos = 0;
             num = 0;
             head->nxtIns = tail;
             tail->preIns = head;
+#if SJTU_CHECKED_ITERATORS
+            ++generation;
+#endif
+        }
+        //在新结点中直接用 args 构造 value_type
+        template<class... Args>
+        Node *NewNode(const size_t &h, Args &&...args){
+            Node *p = pool->allocate();
+            try{
+                new (p->buf) value_type(std::forward<Args>(args)...);
+            }catch(...){
+                pool->deallocate(p);
+                throw;
+            }
+            p->hash_value = h;
+            return p;
+        }
+        //键由 key 构造，值直接在结点里用 args 构造，不经过 T 的临时对象
+        template<class K, class... Args>
+        Node *NewNodeFor(const size_t &h, K &&key, Args &&...args){
+            return NewNode(h, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        void DelNode(Node *p){
+            p->data()->~value_type();
+            pool->deallocate(p);
+        }
+        //结点从 from 池转入本容器的池
+        void Adopt(NodePool *from){
+            if(from == pool) return;
+            from->donated = true;
+            pool->Join(from);
+        }
+        /**
+         * 开启后，超过负载因子时只申请新桶数组，之后每次插入/删除迁移 MigrateStep 个旧桶，
+         * 迁移期间查询同时检查新旧两张表，从而避免一次性重哈希造成的长时间停顿。
+         */
+        void incremental_rehash(bool on) {
+            if(!on && oldArray)
+                Migrate(oldCapacity);
+            incremental = on;
         }
-        int MyHash(const Key &o) const {
-            int res = Hash()(o);
-            res ^= (res >> 20) ^ (res >> 12);
-            return res ^ (res >> 7) ^ (res >> 4);
+        bool incremental_rehash() const {
+            return incremental;
         }
-        int GetIndex(const int &h) const {
+        size_t MyHash(const Key &o) const {
+            return Mix()(Hash()(o));
+        }
+        size_t GetIndex(const size_t &h) const {
             return h & (capacity - 1);
         }
-        void DoubleSpace(){
-            delete[] array;
-            capacity <<= 1;
-            array = new Node *[capacity];
-            std::fill(array, array + capacity, nullptr);
-            for(Node *cur = head->nxtIns; cur != tail; cur = cur->nxtIns){
-                cur->nxtData = nullptr;
-                int pos = GetIndex(cur->hash_value);
-                Node *p = array[pos], *las = nullptr;
-                if(p == nullptr){
-                    array[pos] = cur;
+        static Node **NewArray(size_t n){
+            Node **res = (Node **) calloc(n, sizeof(Node *)); //大数组由系统按需清零，避免扩容时逐个赋值
+            if(res == nullptr)
+                throw runtime_error();
+            return res;
+        }
+        Node *&Bucket(const size_t &h) {
+            if(oldArray){
+                size_t pos = h & (oldCapacity - 1);
+                if(pos >= migratePos)
+                    return oldArray[pos];
+            }
+            return array[GetIndex(h)];
+        }
+        Node *Bucket(const size_t &h) const {
+            return const_cast<linked_hashmap *>(this)->Bucket(h);
+        }
+        Node *FindNode(const Key &key, const size_t &h) const {
+            return FindInChain(Bucket(h), key, h);
+        }
+        Node *FindInChain(Node *p, const Key &key, const size_t &h) const {
+            size_t steps = 0; //未开启埋点时只是死代码
+            for(; p; p = p->nxtData){
+                ++steps;
+                if(p->hash_value == h && Equal()(p->data()->first, key)) //先比较缓存的哈希值，避免无谓的键比较
+                    break;
+            }
+            SJTU_INSTRUMENT_ADD(hashmap_lookups, 1);
+            SJTU_INSTRUMENT_ADD(hashmap_chain_steps, steps);
+            SJTU_INSTRUMENT_MAX(hashmap_longest_chain, steps);
+            return p;
+        }
+        static void Prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#else
+            (void) p;
+#endif
+        }
+        static const size_t BatchGroup = 16; //find_batch 每组同时在途的查找数
+        //分三轮处理一组键：算哈希并预取桶 → 读桶、预取链首结点 → 逐个沿链比较
+        void FindBatchNodes(const Key *keys, size_t n, Node **res) const {
+            size_t h[BatchGroup];
+            for(size_t base = 0; base < n; base += BatchGroup){
+                size_t m = n - base < BatchGroup ? n - base : BatchGroup;
+                for(size_t i = 0; i < m; ++i){
+                    h[i] = MyHash(keys[base + i]);
+                    Prefetch(&const_cast<linked_hashmap *>(this)->Bucket(h[i]));
                 }
-                else{
-                    while(p->nxtData)
-                        p = p->nxtData;
-                    p->nxtData = cur;
+                for(size_t i = 0; i < m; ++i){
+                    res[base + i] = Bucket(h[i]);
+                    if(res[base + i]) Prefetch(res[base + i]);
                 }
+                for(size_t i = 0; i < m; ++i)
+                    res[base + i] = FindInChain(res[base + i], keys[base + i], h[i]);
             }
         }
-        pair<iterator, bool> insert(const value_type &value) {
-            iterator res = find(value.first);
-            if(res.ptr != tail)
-                return {res, false};
+        void Migrate(size_t steps){
+            while(steps-- && migratePos < oldCapacity){
+                Node *p = oldArray[migratePos], *tmp;
+                oldArray[migratePos++] = nullptr;
+                while(p){
+                    tmp = p->nxtData;
+                    size_t pos = GetIndex(p->hash_value);
+                    p->nxtData = array[pos];
+                    array[pos] = p;
+                    p = tmp;
+                }
+            }
+            if(migratePos == oldCapacity){
+                free(oldArray);
+                oldArray = nullptr;
+                oldCapacity = migratePos = 0;
+            }
+        }
+        //把桶数组换成 newCap 个桶；lazy 为真时只换表，旧桶留给后续操作逐步迁移
+        void Resize(size_t newCap, bool lazy){
+            if(oldArray)
+                Migrate(oldCapacity); //上一轮迁移尚未完成，先收尾
+            Node **fresh = NewArray(newCap); //先申请，失败时表保持原状
+            SJTU_INSTRUMENT_ADD(hashmap_rehashes, 1);
+            Node **tmp = array;
+            size_t tmpCapacity = capacity;
+            capacity = newCap;
+            array = fresh;
+            oldArray = tmp;
+            oldCapacity = tmpCapacity;
+            migratePos = 0;
+            if(!lazy)
+                Migrate(oldCapacity);
+        }
+        void DoubleSpace(){
+            if(capacity >= MaxBuckets)
+                throw runtime_error();
+            Resize(capacity << 1, incremental);
+        }
+        //装下 n 个元素而不触发扩容所需的最小桶数（2 的幂，至少 16），超过 MaxBuckets 抛 runtime_error
+        size_t BucketsFor(size_t n) const {
+            size_t res = 16;
+            while(n > res * LoadFactor){
+                if(res >= MaxBuckets)
+                    throw runtime_error();
+                res <<= 1;
+            }
+            return res;
+        }
+        //把新结点接入桶与插入顺序链表，调用前须确认键不存在
+        void Link(Node *tmp){
+            if(oldArray)
+                Migrate(MigrateStep);
             if(num >= capacity * LoadFactor)
                 DoubleSpace();
-            int h = MyHash(value.first), pos;
-            pos = GetIndex(h);
-            Node *tmp, *las;
-            if(array[pos] == nullptr){
-                array[pos] = new Node(value, h);
-                tmp = array[pos];
-            }
-            else{
-                Node *p = array[pos];
-                while(p->nxtData)
-                    p = p->nxtData;
-                p->nxtData = new Node(value, h);
-                tmp = p->nxtData;
-            }
+            Node *&bucket = Bucket(tmp->hash_value), *las;
+            tmp->nxtData = bucket;
+            bucket = tmp;
             num++;
             las = tail->preIns;
             tail->preIns = las->nxtIns = tmp;
             tmp->preIns = las;
             tmp->nxtIns = tail;
+        }
+        //把结点从桶与插入顺序链表中摘下，不释放
+        void Unlink(Node *tmp){
+            if(oldArray)
+                Migrate(MigrateStep);
+            Node *&bucket = Bucket(tmp->hash_value);
+            Node *p = bucket, *las = nullptr;
+            while(p != tmp){
+                las = p;
+                p = p->nxtData;
+            }
+            p->preIns->nxtIns = p->nxtIns;
+            p->nxtIns->preIns = p->preIns;
+            if(las == nullptr)
+                bucket = p->nxtData;
+            else
+                las->nxtData = p->nxtData;
+            num--;
+        }
+        pair<iterator, bool> insert(const value_type &value) {
+            size_t h = MyHash(value.first);
+            Node *tmp = FindNode(value.first, h);
+            if(tmp)
+                return {iterator(tmp, this), false};
+            tmp = NewNode(h, value);
+            Link(tmp);
+            return {iterator(tmp, this), true};
+        }
+        pair<iterator, bool> insert(value_type &&value) {
+            size_t h = MyHash(value.first);
+            Node *tmp = FindNode(value.first, h);
+            if(tmp)
+                return {iterator(tmp, this), false};
+            tmp = NewNode(h, std::move(value));
+            Link(tmp);
+            return {iterator(tmp, this), true};
+        }
+        /**
+         * 用 args 原地构造元素；需要先构造出键才能查找，键已存在时新结点被丢弃
+         */
+        template<class... Args>
+        pair<iterator, bool> emplace(Args &&...args) {
+            Node *tmp = NewNode(0, std::forward<Args>(args)...), *res;
+            tmp->hash_value = MyHash(tmp->data()->first);
+            res = FindNode(tmp->data()->first, tmp->hash_value);
+            if(res){
+                DelNode(tmp);
+                return {iterator(res, this), false};
+            }
+            Link(tmp);
+            return {iterator(tmp, this), true};
+        }
+        /**
+         * 键不存在时才用 args 构造值，键已存在时 key 和 args 都不会被移动
+         */
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+            size_t h = MyHash(key);
+            Node *tmp = FindNode(key, h);
+            if(tmp)
+                return {iterator(tmp, this), false};
+            tmp = NewNodeFor(h, key, std::forward<Args>(args)...);
+            Link(tmp);
+            return {iterator(tmp, this), true};
+        }
+        template<class... Args>
+        pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+            size_t h = MyHash(key);
+            Node *tmp = FindNode(key, h);
+            if(tmp)
+                return {iterator(tmp, this), false};
+            tmp = NewNodeFor(h, std::move(key), std::forward<Args>(args)...);
+            Link(tmp);
             return {iterator(tmp, this), true};
         }
         void erase(iterator pos) {
-            if(pos.from != this || pos.ptr == tail || pos.ptr == head || pos.ptr == nullptr)
+            if(pos.from != this || pos.ptr == tail || pos.ptr == head || pos.ptr == nullptr || pos.Stale())
                 throw invalid_iterator();
-            int index = GetIndex(pos.ptr->hash_value);
-            Node *p = array[index], *las = nullptr;
-            while(p != pos.ptr){
-                las = p;
-                p = p->nxtData;
+            Unlink(pos.ptr);
+            DelNode(pos.ptr);
+        }
+        /**
+         * 结点句柄：持有一个从容器中摘下的结点，可以原样插回同类型的任意 linked_hashmap，
+         * 转移过程中不申请、不释放内存，也不拷贝键和值。
+         * 和容器本身一样不是线程安全的：未插回的句柄析构时结点归还到摘下它的容器的结点池。
+         */
+        class node_type {
+            friend class linked_hashmap;
+        private:
+            Node *ptr = nullptr;
+            NodePool *pool = nullptr; //摘下结点的容器的池，句柄持有它的一个引用
+            node_type(Node *p, NodePool *from) : ptr(p), pool(from) {
+                pool->lent++;
+                pool->Retain();
+            }
+            //结点已插入容器，交出结点和池的引用
+            void Release(){
+                pool->lent--;
+                pool->Release();
+                ptr = nullptr;
+                pool = nullptr;
+            }
+            void Reset(){
+                if(ptr){
+                    ptr->data()->~value_type();
+                    pool->deallocate(ptr);
+                    Release();
+                }
+            }
+        public:
+            node_type() {}
+            node_type(node_type &&other) : ptr(other.ptr), pool(other.pool) {
+                other.ptr = nullptr;
+                other.pool = nullptr;
+            }
+            node_type &operator = (node_type &&other){
+                if(this == &other) return *this;
+                Reset();
+                ptr = other.ptr;
+                pool = other.pool;
+                other.ptr = nullptr;
+                other.pool = nullptr;
+                return *this;
+            }
+            node_type(const node_type &) = delete;
+            node_type &operator = (const node_type &) = delete;
+            ~node_type(){
+                Reset();
+            }
+            bool empty() const {
+                return ptr == nullptr;
             }
+            explicit operator bool() const {
+                return ptr != nullptr;
+            }
+            const Key &key() const {
+                if(!ptr) throw invalid_iterator();
+                return ptr->data()->first;
+            }
+            T &mapped() const {
+                if(!ptr) throw invalid_iterator();
+                return ptr->data()->second;
+            }
+            value_type &value() const {
+                if(!ptr) throw invalid_iterator();
+                return *(ptr->data());
+            }
+        };
+        struct insert_return_type {
+            iterator position;
+            bool inserted;
+            node_type node; //插入失败时结点原样交还
+        };
+        node_type extract(iterator pos) {
+            if(pos.from != this || pos.ptr == tail || pos.ptr == head || pos.ptr == nullptr || pos.Stale())
+                throw invalid_iterator();
+            Unlink(pos.ptr);
+            return node_type(pos.ptr, pool);
+        }
+        /**
+         * 键不存在时返回空句柄
+         */
+        node_type extract(const Key &key) {
+            Node *p = FindNode(key, MyHash(key));
+            if(p == nullptr)
+                return node_type();
+            return extract(iterator(p, this));
+        }
+        /**
+         * 插入句柄中的结点并追加到插入顺序末尾；键已存在时不插入，结点留在返回值的 node 中
+         */
+        insert_return_type insert(node_type &&nh) {
+            if(nh.empty())
+                return {end(), false, node_type()};
+            Node *p = FindNode(nh.key(), nh.ptr->hash_value);
+            if(p)
+                return {iterator(p, this), false, static_cast<node_type &&>(nh)};
+            p = nh.ptr;
+            Adopt(nh.pool);
+            Link(p);
+            nh.Release(); //本容器与句柄的池已在同一组，组的计数不会归零
+            return {iterator(p, this), true, node_type()};
+        }
+        /**
+         * 把 other 中本容器没有的键按 other 的插入顺序转移过来，键已存在的元素留在 other 中
+         */
+        void merge(linked_hashmap &other) {
+            if(&other == this) return;
+            for(Node *p = other.head->nxtIns, *tmp; p != other.tail; p = tmp){
+                tmp = p->nxtIns;
+                if(FindNode(p->data()->first, p->hash_value))
+                    continue;
+                other.Unlink(p);
+                Adopt(other.pool);
+                Link(p);
+            }
+        }
+        /**
+         * 把 pos 移到插入顺序的末尾，O(1)，不改变哈希表结构，迭代器仍然有效
+         */
+        void move_to_back(iterator pos) {
+            if(pos.from != this || pos.ptr == tail || pos.ptr == head || pos.ptr == nullptr || pos.Stale())
+                throw invalid_iterator();
+            Node *p = pos.ptr, *las = tail->preIns;
+            if(p == las)
+                return;
             p->preIns->nxtIns = p->nxtIns;
             p->nxtIns->preIns = p->preIns;
-            if(las == nullptr){
-                array[index] = p->nxtData;
-                delete p;
+            las->nxtIns = p;
+            p->preIns = las;
+            p->nxtIns = tail;
+            tail->preIns = p;
+        }
+        /**
+         * 保证再插入到 n 个元素之前不会扩容
+         */
+        void reserve(size_t n) {
+            size_t cap = BucketsFor(n);
+            if(cap > capacity)
+                Resize(cap, false);
+        }
+        /**
+         * 把桶数设为不小于 n 的 2 的幂，但不会少于容纳当前元素所需的桶数
+         */
+        void rehash(size_t n) {
+            size_t cap = BucketsFor(num);
+            while(cap < n){
+                if(cap >= MaxBuckets)
+                    throw runtime_error();
+                cap <<= 1;
+            }
+            if(cap != capacity || oldArray)
+                Resize(cap, false);
+        }
+        /**
+         * 释放多余的桶：桶数降到容纳当前元素所需的最小值
+         */
+        void shrink_to_fit() {
+            size_t cap = BucketsFor(num);
+            if(cap < capacity)
+                Resize(cap, false);
+        }
+        double load_factor() const {
+            return (double) num / capacity;
+        }
+        double max_load_factor() const {
+            return LoadFactor;
+        }
+        /**
+         * 设置最大负载因子，若当前元素已超过新的上限则立即扩容；
+         * 小于 MinLoadFactor（或为 NaN）时抛 runtime_error
+         */
+        void max_load_factor(double ml) {
+            if(!(ml >= MinLoadFactor))
+                throw runtime_error();
+            double old = LoadFactor;
+            LoadFactor = ml;
+            try{
+                size_t cap = BucketsFor(num);
+                if(cap > capacity)
+                    Resize(cap, false);
+            }catch(...){
+                LoadFactor = old;
+                throw;
             }
-            else{
-                las->nxtData = p->nxtData;
-                delete p;
+        }
+        size_t bucket_count() const {
+            return capacity;
+        }
+        size_t bucket_size(size_t n) const {
+            if(n >= capacity)
+                throw index_out_of_bound();
+            size_t res = 0;
+            for(Node *p = array[n]; p; p = p->nxtData)
+                res++;
+            for(size_t i = migratePos; oldArray && i < oldCapacity; ++i)
+                for(Node *p = oldArray[i]; p; p = p->nxtData)
+                    if(GetIndex(p->hash_value) == n)
+                        res++;
+            return res;
+        }
+        /**
+         * 最长链的长度；迁移过程中旧表里尚未迁移的链也计算在内
+         */
+        size_t longest_chain() const {
+            size_t res = 0;
+            ChainStat([&res](size_t len){ if(len > res) res = len; });
+            return res;
+        }
+        /**
+         * 成功查找平均需要比较的结点数，即 sum(len * (len + 1) / 2) / size()
+         */
+        double average_probe_length() const {
+            if(!num)
+                return 0;
+            double res = 0;
+            ChainStat([&res](size_t len){ res += len * (len + 1) / 2.0; });
+            return res / num;
+        }
+        template<class F>
+        void ChainStat(F f) const {
+            for(size_t i = 0; i < capacity; ++i){
+                size_t len = 0;
+                for(Node *p = array[i]; p; p = p->nxtData)
+                    len++;
+                f(len);
+            }
+            for(size_t i = migratePos; oldArray && i < oldCapacity; ++i){
+                size_t len = 0;
+                for(Node *p = oldArray[i]; p; p = p->nxtData)
+                    len++;
+                f(len);
             }
-            num--;
         }
         size_t count(const Key &key) const {
             if(find(key) == cend()) return 0;
             else return 1;
         }
-        iterator find(const Key &key) {
-            int pos = GetIndex(MyHash(key));
-            Node *p = array[pos];
-            while(p){
-                if(Equal()(p->data->first, key))
-                    return iterator(p, this);
-                p = p->nxtData;
+        /**
+         * 批量查找 keys[0, n)，out[i] 为 keys[i] 对应的迭代器，找不到为 end()。
+         * 一组键的缓存缺失交错重叠，比逐个 find 少等待内存
+         */
+        void find_batch(const Key *keys, size_t n, iterator *out) {
+            Node *res[BatchGroup];
+            for(size_t base = 0; base < n; base += BatchGroup){
+                size_t m = n - base < BatchGroup ? n - base : BatchGroup;
+                FindBatchNodes(keys + base, m, res);
+                for(size_t i = 0; i < m; ++i)
+                    out[base + i] = res[i] ? iterator(res[i], this) : end();
             }
-            return end();
         }
-        const_iterator find(const Key &key) const{
-            int pos = GetIndex((MyHash(key)));
-            Node *p = array[pos];
-            while(p){
-                if(Equal()(p->data->first, key))
-                    return const_iterator(p, this);
-                p = p->nxtData;
+        void find_batch(const Key *keys, size_t n, const_iterator *out) const {
+            Node *res[BatchGroup];
+            for(size_t base = 0; base < n; base += BatchGroup){
+                size_t m = n - base < BatchGroup ? n - base : BatchGroup;
+                FindBatchNodes(keys + base, m, res);
+                for(size_t i = 0; i < m; ++i)
+                    out[base + i] = res[i] ? const_iterator(res[i], this) : cend();
             }
-            return cend();
+        }
+        iterator find(const Key &key) {
+            Node *p = FindNode(key, MyHash(key));
+            return p ? iterator(p, this) : end();
+        }
+        const_iterator find(const Key &key) const{
+            Node *p = FindNode(key, MyHash(key));
+            return p ? const_iterator(p, this) : cend();
         }
     };
 
@@ -0,0 +1,164 @@
+////sjtu::linked_hashmap 的二进制镜像：文件头、按插入顺序排列的 value_type 数组、哈希索引
+////哈希索引是 2 的幂个 {哈希值, 下标 + 1} 槽位的开放寻址表（线性探测，0 表示空槽），
+////打开时直接在映射的索引上查找。索引中保存的是 Mix()(Hash()(key))，
+////因此打开镜像时必须使用与写入时相同的 Hash 与 Mix。
+#ifndef SJTU_LINKED_HASHMAP_IMAGE_HPP
+#define SJTU_LINKED_HASHMAP_IMAGE_HPP
+
+#include <cstddef>
+#include <new>
+#include <functional>
+#include <type_traits>
+#include "linked_hashmap.hpp"
+#include "mapped_file.hpp"
+
+namespace sjtu {
+
+    struct image_index_slot {
+        unsigned long long hash_value;
+        unsigned long long pos; //元素下标 + 1，0 表示空槽
+    };
+
+    template<
+            class Key,
+            class T,
+            class Hash = std::hash<Key>,
+            class Equal = std::equal_to<Key>,
+            class Mix = fast_hash_mix
+    > class linked_hashmap_image_writer {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "linked_hashmap image requires trivially copyable key and value types");
+    public:
+        typedef pair<const Key, T> value_type;
+    private:
+        image_writer out;
+    public:
+        explicit linked_hashmap_image_writer(const char *path) {
+            out.header.init(LINKED_HASHMAP_IMAGE, sizeof(Key), sizeof(T), sizeof(value_type));
+            out.open(path);
+        }
+        /**
+         * 追加一个元素，遍历顺序即写入顺序。重复的键在 finish 时检查
+         */
+        void push(const Key &key, const T &value) {
+            //在清零的缓冲上构造，保证填充字节也是确定的
+            alignas(value_type) unsigned char raw[sizeof(value_type)] = {};
+            new(raw) value_type(key, value);
+            out.write(raw, sizeof(value_type));
+            out.header.count++;
+        }
+        size_t size() const {
+            return out.header.count;
+        }
+        /**
+         * 在文件末尾建立哈希索引，回填文件头并关闭文件。
+         * 索引通过可写映射在文件上原地建立，元素不必留在内存里；出现重复的键时抛出 runtime_error。
+         * 未调用 finish（或 finish 失败）就析构时文件被删除
+         */
+        void finish() {
+            out.pad(64);
+            unsigned long long slots = 16;
+            while(slots < out.header.count * 2) slots <<= 1;
+            out.header.index_offset = out.offset();
+            out.header.index_slots = slots;
+            out.flush();
+            size_t len = (size_t) (out.header.index_offset + slots * sizeof(image_index_slot));
+            int fd = out.descriptor();
+            if(ftruncate(fd, (off_t) len) != 0) throw runtime_error();
+            void *addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(addr == MAP_FAILED) throw runtime_error();
+            const value_type *array = reinterpret_cast<const value_type *>(static_cast<char *>(addr) + out.header.data_offset);
+            image_index_slot *index = reinterpret_cast<image_index_slot *>(static_cast<char *>(addr) + out.header.index_offset);
+            unsigned long long mask = slots - 1;
+            for(unsigned long long i = 0; i < out.header.count; ++i){
+                unsigned long long h = Mix()(Hash()(array[i].first));
+                unsigned long long p = h & mask;
+                while(index[p].pos){
+                    if(index[p].hash_value == h && Equal()(array[index[p].pos - 1].first, array[i].first)){
+                        munmap(addr, len);
+                        throw runtime_error();
+                    }
+                    p = (p + 1) & mask;
+                }
+                index[p].hash_value = h;
+                index[p].pos = i + 1;
+            }
+            munmap(addr, len);
+            out.finish();
+        }
+    };
+
+    template<class Key, class T, class Hash, class Equal, class Mix>
+    void write_image(const linked_hashmap<Key, T, Hash, Equal, Mix> &m, const char *path) {
+        linked_hashmap_image_writer<Key, T, Hash, Equal, Mix> w(path);
+        for(typename linked_hashmap<Key, T, Hash, Equal, Mix>::const_iterator it = m.cbegin(); it != m.cend(); ++it)
+            w.push(it->first, it->second);
+        w.finish();
+    }
+
+    /**
+     * 只读的 linked_hashmap 镜像视图，按插入顺序遍历，查找走映射的哈希索引
+     */
+    template<
+            class Key,
+            class T,
+            class Hash = std::hash<Key>,
+            class Equal = std::equal_to<Key>,
+            class Mix = fast_hash_mix
+    > class mapped_linked_hashmap {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "linked_hashmap image requires trivially copyable key and value types");
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef const value_type *const_iterator;
+    private:
+        mapped_file file;
+        const value_type *array = nullptr;
+        const image_index_slot *index = nullptr;
+        size_t num = 0;
+        unsigned long long mask = 0;
+    public:
+        mapped_linked_hashmap() {}
+        explicit mapped_linked_hashmap(const char *path) {
+            open(path);
+        }
+        void open(const char *path) {
+            file.open(path);
+            const image_header &h = file.header(LINKED_HASHMAP_IMAGE, sizeof(Key), sizeof(T), sizeof(value_type), alignof(value_type));
+            //槽位数必须是 2 的幂且留有空槽，否则探测可能不终止；索引按槽位对齐
+            if(!h.index_slots || (h.index_slots & (h.index_slots - 1)) || h.index_slots <= h.count ||
+               h.index_offset % alignof(image_index_slot))
+                throw runtime_error();
+            array = reinterpret_cast<const value_type *>(file.data() + h.data_offset);
+            index = reinterpret_cast<const image_index_slot *>(file.data() + h.index_offset);
+            num = h.count;
+            mask = h.index_slots - 1;
+        }
+        /**
+         * 查到返回指向元素的指针，否则返回 nullptr
+         */
+        const value_type *find(const Key &key) const {
+            if(!index) return nullptr;
+            unsigned long long h = Mix()(Hash()(key));
+            for(unsigned long long p = h & mask; index[p].pos; p = (p + 1) & mask)
+                if(index[p].hash_value == h && index[p].pos <= num && Equal()(array[index[p].pos - 1].first, key))
+                    return array + (index[p].pos - 1);
+            return nullptr;
+        }
+        const T & at(const Key &key) const {
+            const value_type *res = find(key);
+            if(!res) throw index_out_of_bound();
+            return res->second;
+        }
+        size_t count(const Key &key) const {
+            return find(key) ? 1 : 0;
+        }
+        const_iterator cbegin() const { return array; }
+        const_iterator cend() const { return array + num; }
+        bool empty() const { return !num; }
+        size_t size() const { return num; }
+    };
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+////基于 linked_hashmap 的定长 LRU 缓存
+////linked_hashmap 的插入顺序链表即为访问顺序：命中时用 move_to_back 把元素移到末尾，
+////容量满时淘汰链表头部（最久未访问）的元素，命中与插入都不需要额外的内存分配。
+#ifndef SJTU_LRU_CACHE_HPP
+#define SJTU_LRU_CACHE_HPP
+
+#include <functional>
+#include <cstddef>
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+
+    template<
+            class Key,
+            class T,
+            class Hash = std::hash<Key>,
+            class Equal = std::equal_to<Key>,
+            class Mix = fast_hash_mix
+    > class lru_cache {
+    public:
+        typedef linked_hashmap<Key, T, Hash, Equal, Mix> map_type;
+        typedef typename map_type::value_type value_type;
+        typedef typename map_type::const_iterator const_iterator;
+        //元素被淘汰前调用，可以在回调里把值移走
+        typedef std::function<void(const Key &, T &)> evict_callback;
+    private:
+        map_type table;
+        size_t cap;
+        evict_callback onEvict;
+        size_t hitCnt = 0, missCnt = 0, evictCnt = 0;
+
+        void EvictFront(){
+            typename map_type::iterator victim = table.begin();
+            if(onEvict)
+                onEvict(victim->first, victim->second);
+            table.erase(victim);
+            evictCnt++;
+        }
+    public:
+        explicit lru_cache(size_t capacity) : table(capacity), cap(capacity) {
+            if(!capacity)
+                throw runtime_error();
+        }
+        lru_cache(size_t capacity, const evict_callback &f) : lru_cache(capacity) {
+            onEvict = f;
+        }
+        /**
+         * 查询并把命中的元素标记为最近使用；未命中返回 nullptr。
+         * 返回的指针在下一次修改缓存之前有效。
+         */
+        T *get(const Key &key) {
+            typename map_type::iterator res = table.find(key);
+            if(res == table.end()){
+                missCnt++;
+                return nullptr;
+            }
+            hitCnt++;
+            table.move_to_back(res);
+            return &(res->second);
+        }
+        /**
+         * 只查询，不更新访问顺序，也不计入命中统计
+         */
+        const T *peek(const Key &key) const {
+            const_iterator res = table.find(key);
+            return res == table.cend() ? nullptr : &(res->second);
+        }
+        bool contains(const Key &key) const {
+            return table.count(key);
+        }
+        /**
+         * 插入或覆盖 key 对应的值并标记为最近使用，满时先淘汰最久未使用的元素
+         */
+        T &put(const Key &key, const T &value) {
+            typename map_type::iterator res = table.find(key);
+            if(res != table.end()){
+                res->second = value;
+                table.move_to_back(res);
+                return res->second;
+            }
+            if(table.size() >= cap)
+                EvictFront();
+            return table.insert(value_type(key, value)).first->second;
+        }
+        bool erase(const Key &key) {
+            typename map_type::iterator res = table.find(key);
+            if(res == table.end())
+                return false;
+            table.erase(res);
+            return true;
+        }
+        /**
+         * 修改容量，容量变小时按 LRU 顺序淘汰多出的元素（会触发回调）
+         */
+        void resize(size_t capacity) {
+            if(!capacity)
+                throw runtime_error();
+            cap = capacity;
+            while(table.size() > cap)
+                EvictFront();
+            table.reserve(cap);
+        }
+        void clear() {
+            table.clear();
+        }
+        void set_evict_callback(const evict_callback &f) {
+            onEvict = f;
+        }
+        size_t size() const {
+            return table.size();
+        }
+        bool empty() const {
+            return table.empty();
+        }
+        size_t capacity() const {
+            return cap;
+        }
+        size_t hits() const {
+            return hitCnt;
+        }
+        size_t misses() const {
+            return missCnt;
+        }
+        size_t evictions() const {
+            return evictCnt;
+        }
+        void reset_stats() {
+            hitCnt = missCnt = evictCnt = 0;
+        }
+        //从最久未使用到最近使用遍历
+        const_iterator cbegin() const {
+            return table.cbegin();
+        }
+        const_iterator cend() const {
+            return table.cend();
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,641 @@
+////有序数组实现的只读优化 map，接口与 sjtu::map 相同（含结点句柄、merge 与 find_batch）
+////元素按键升序存放在连续的 value_type 数组中，另有一份紧凑的键数组专门用于查找，
+////二分时每条缓存行都装满键；查找使用无分支的二分。
+////单个插入 / 删除需要移动后面的元素，是 O(n) 的；大量数据请用区间构造或区间 insert，
+////它们先对新元素排序去重，再与已有元素一次归并。
+////插入、删除会使所有迭代器和引用失效。
+////flat_map 没有结点，node_type 持有从数组中移出的元素，extract / insert(node_type) 各移动元素一次。
+#ifndef SJTU_FLAT_MAP_HPP
+#define SJTU_FLAT_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+template<
+	class Key,
+	class T,
+	class Compare = std::less<Key>
+> class flat_map {
+public:
+	typedef pair<const Key, T> value_type;
+private:
+    Key *keys;
+    value_type *data;
+    size_t num, cap;
+
+    //第一个不小于 key 的位置。每轮只根据比较结果移动 base，编译为条件传送
+    size_t LowerBound(const Key &key) const {
+        const Key *base = keys;
+        size_t len = num;
+        while(len > 1){
+            size_t half = len >> 1;
+            base = Compare()(base[half - 1], key) ? base + half : base;
+            len -= half;
+        }
+        if(len && Compare()(*base, key)) ++base;
+        return base - keys;
+    }
+    size_t Find(const Key &key) const {
+        size_t pos = LowerBound(key);
+        if(pos == num || Compare()(key, keys[pos])) return num;
+        return pos;
+    }
+    /**
+     * 新申请的一对数组，元素只在末尾追加。全部构造完后用 Adopt 换入表中；
+     * 中途抛出异常时析构已构造的元素并释放，原来的表不受影响
+     */
+    struct Fresh {
+        Key *keys;
+        value_type *data;
+        size_t num = 0, cap;
+        explicit Fresh(size_t n) : cap(n) {
+            keys = (Key*) malloc(n * sizeof(Key));
+            data = (value_type*) malloc(n * sizeof(value_type));
+            if(!keys || !data){
+                free(keys);
+                free(data);
+                throw std::bad_alloc();
+            }
+        }
+        Fresh(const Fresh &) = delete;
+        Fresh &operator = (const Fresh &) = delete;
+        ~Fresh() {
+            for(size_t i = 0; i < num; ++i){
+                keys[i].~Key();
+                data[i].~value_type();
+            }
+            free(keys);
+            free(data);
+        }
+        template<class K, class V>
+        void Push(K &&key, V &&value) {
+            new (data + num) value_type(std::forward<V>(value));
+            try{
+                new (keys + num) Key(std::forward<K>(key));
+            }catch(...){
+                data[num].~value_type();
+                throw;
+            }
+            num++;
+        }
+    };
+    //析构并释放当前的数组，换成 f 中已构造好的数组
+    void Adopt(Fresh &f){
+        Destroy();
+        free(keys);
+        free(data);
+        keys = f.keys;
+        data = f.data;
+        num = f.num;
+        cap = f.cap;
+        f.keys = nullptr;
+        f.data = nullptr;
+        f.num = 0;
+    }
+    //装下 n 个元素的容量：从 16 开始倍增
+    size_t CapFor(size_t n) const {
+        size_t newCap = cap ? cap : 16;
+        while(newCap < n) newCap <<= 1;
+        return newCap;
+    }
+    //已有元素搬到新数组：移动不会抛出时移动，否则拷贝，失败时表保持原状
+    void PushOld(Fresh &f, size_t i){
+        f.Push(std::move_if_noexcept(keys[i]), std::move_if_noexcept(data[i]));
+    }
+    void Reserve(size_t n){
+        if(n <= cap) return;
+        Fresh f(CapFor(n));
+        for(size_t i = 0; i < num; ++i) PushOld(f, i);
+        Adopt(f);
+    }
+    //把 [pos, num) 整体后移一位，空出 pos（未构造）
+    void ShiftRight(size_t pos){
+        Reserve(num + 1);
+        for(size_t i = num; i > pos; --i){
+            new (keys + i) Key(std::move(keys[i - 1]));
+            new (data + i) value_type(std::move(data[i - 1]));
+            keys[i - 1].~Key();
+            data[i - 1].~value_type();
+        }
+    }
+    //在 pos 处插入一个已经构造好的元素
+    //把 [pos + 1, num + 1) 整体前移一位，填上 pos 处的空位
+    void ShiftLeft(size_t pos){
+        for(size_t i = pos + 1; i <= num; ++i){
+            new (keys + i - 1) Key(std::move(keys[i]));
+            new (data + i - 1) value_type(std::move(data[i]));
+            keys[i].~Key();
+            data[i].~value_type();
+        }
+    }
+    //在 pos 处用 args 原地构造元素；构造失败时把后移的元素移回原处
+    template<class... Args>
+    size_t InsertAt(size_t pos, Args &&...args){
+        ShiftRight(pos);
+        try{
+            new (data + pos) value_type(std::forward<Args>(args)...);
+        }catch(...){
+            ShiftLeft(pos);
+            throw;
+        }
+        try{
+            new (keys + pos) Key(data[pos].first);
+        }catch(...){
+            data[pos].~value_type();
+            ShiftLeft(pos);
+            throw;
+        }
+        num++;
+        return pos;
+    }
+    static void Prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p);
+#else
+        (void) p;
+#endif
+    }
+    static const size_t BatchGroup = 16; //find_batch 一次最多同时查找的键数
+    /**
+     * 同时为 keys[0, n)（n 不超过 BatchGroup）做无分支二分，结果为下标，找不到为 num。
+     * 所有键的区间长度同步减半，每轮先为所有键预取下一次要比较的位置
+     */
+    void FindBatch(const Key *query, size_t n, size_t *res) const {
+        const Key *base[BatchGroup];
+        for(size_t i = 0; i < n; ++i) base[i] = keys;
+        size_t len = num;
+        while(len > 1){
+            size_t half = len >> 1;
+            for(size_t i = 0; i < n; ++i)
+                base[i] = Compare()(base[i][half - 1], query[i]) ? base[i] + half : base[i];
+            len -= half;
+            if(len > 1)
+                for(size_t i = 0; i < n; ++i) Prefetch(base[i] + (len >> 1) - 1);
+        }
+        for(size_t i = 0; i < n; ++i){
+            size_t pos = base[i] - keys;
+            if(len && Compare()(keys[pos], query[i])) ++pos;
+            res[i] = (pos == num || Compare()(query[i], keys[pos])) ? num : pos;
+        }
+    }
+    void Destroy(){
+        for(size_t i = 0; i < num; ++i){
+            keys[i].~Key();
+            data[i].~value_type();
+        }
+        num = 0;
+    }
+    /**
+     * 对 v[0, n) 的下标按键做稳定归并排序，并去掉重复的键（保留先出现的），返回剩余个数
+     */
+    static size_t SortUnique(const value_type *v, size_t *idx, size_t n){
+        size_t *tmp = new size_t[n ? n : 1];
+        for(size_t i = 0; i < n; ++i) idx[i] = i;
+        size_t *src = idx, *dst = tmp;
+        for(size_t width = 1; width < n; width <<= 1){
+            for(size_t l = 0; l < n; l += width * 2){
+                size_t m = l + width < n ? l + width : n, r = m + width < n ? m + width : n;
+                size_t a = l, b = m, k = l;
+                while(a < m && b < r) dst[k++] = Compare()(v[src[b]].first, v[src[a]].first) ? src[b++] : src[a++];
+                while(a < m) dst[k++] = src[a++];
+                while(b < r) dst[k++] = src[b++];
+            }
+            size_t *t = src; src = dst; dst = t;
+        }
+        size_t res = 0;
+        for(size_t i = 0; i < n; ++i)
+            if(!res || Compare()(v[idx[res - 1]].first, v[src[i]].first)) idx[res++] = src[i];
+        delete []tmp;
+        return res;
+    }
+    //把 [first, last) 拷贝进临时数组，返回个数；调用者负责销毁与释放
+    template<class InputIt>
+    static size_t Collect(InputIt first, InputIt last, value_type *&buf){
+        size_t n = 0, bufCap = 16;
+        buf = (value_type*) malloc(bufCap * sizeof(value_type));
+        if(!buf) throw std::bad_alloc();
+        try{
+            for(; first != last; ++first){
+                if(n == bufCap){
+                    value_type *tmp = (value_type*) malloc(bufCap * 2 * sizeof(value_type));
+                    if(!tmp) throw std::bad_alloc();
+                    //先全部搬到 tmp 再析构旧的，搬移中途抛出时 buf 仍然完整
+                    size_t moved = 0;
+                    try{
+                        for(; moved < n; ++moved) new (tmp + moved) value_type(std::move_if_noexcept(buf[moved]));
+                    }catch(...){
+                        for(size_t i = 0; i < moved; ++i) tmp[i].~value_type();
+                        free(tmp);
+                        throw;
+                    }
+                    for(size_t i = 0; i < n; ++i) buf[i].~value_type();
+                    free(buf);
+                    buf = tmp;
+                    bufCap *= 2;
+                }
+                new (buf + n) value_type(*first);
+                n++;
+            }
+        }catch(...){
+            for(size_t i = 0; i < n; ++i) buf[i].~value_type();
+            free(buf);
+            buf = nullptr;
+            throw;
+        }
+        return n;
+    }
+public:
+	class const_iterator;
+	class iterator {
+    public:
+        size_t pos;
+        const flat_map *from;
+	public:
+		iterator() : pos(0), from(nullptr){}
+        iterator(size_t tmp_pos, const flat_map *tmp_from) : pos(tmp_pos), from(tmp_from){}
+		iterator operator++(int) {
+            iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+		iterator & operator++() {
+            if(from == nullptr || pos >= from->num) throw invalid_iterator();
+            pos++;
+            return *this;
+        }
+		iterator operator--(int) {
+            iterator tmp(*this);
+            --*this;
+            return tmp;
+        }
+		iterator & operator--() {
+            if(from == nullptr || pos == 0) throw invalid_iterator();
+            pos--;
+            return *this;
+        }
+		value_type & operator*() const {
+            if(from == nullptr || pos >= from->num) throw invalid_iterator();
+            return from->data[pos];
+        }
+		bool operator==(const iterator &rhs) const {
+            return from == rhs.from && pos == rhs.pos;
+        }
+		bool operator==(const const_iterator &rhs) const {
+            return from == rhs.from && pos == rhs.pos;
+        }
+		bool operator!=(const iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		value_type* operator->() const {
+            return &**this;
+        }
+	};
+	class const_iterator {
+    public:
+        size_t pos;
+        const flat_map *from;
+	public:
+		const_iterator() : pos(0), from(nullptr){}
+        const_iterator(size_t tmp_pos, const flat_map *tmp_from) : pos(tmp_pos), from(tmp_from){}
+		const_iterator(const iterator &other) : pos(other.pos), from(other.from){}
+		const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+		const_iterator & operator++() {
+            if(from == nullptr || pos >= from->num) throw invalid_iterator();
+            pos++;
+            return *this;
+        }
+		const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --*this;
+            return tmp;
+        }
+		const_iterator & operator--() {
+            if(from == nullptr || pos == 0) throw invalid_iterator();
+            pos--;
+            return *this;
+        }
+		const value_type & operator*() const {
+            if(from == nullptr || pos >= from->num) throw invalid_iterator();
+            return from->data[pos];
+        }
+		bool operator==(const iterator &rhs) const {
+            return from == rhs.from && pos == rhs.pos;
+        }
+		bool operator==(const const_iterator &rhs) const {
+            return from == rhs.from && pos == rhs.pos;
+        }
+		bool operator!=(const iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		const value_type* operator->() const {
+            return &**this;
+        }
+	};
+	flat_map() : keys(nullptr), data(nullptr), num(0), cap(0) {}
+    /**
+     * 由无序的 [first, last) 批量构造，重复的键保留先出现的一个
+     */
+    template<class InputIt>
+    flat_map(InputIt first, InputIt last) : flat_map() {
+        insert(first, last);
+    }
+	flat_map(const flat_map &other) : flat_map() {
+        Reserve(other.num);
+        for(; num < other.num; ++num){
+            new (keys + num) Key(other.keys[num]);
+            try{
+                new (data + num) value_type(other.data[num]);
+            }catch(...){
+                keys[num].~Key();
+                Destroy();
+                free(keys);
+                free(data);
+                throw;
+            }
+        }
+    }
+	flat_map & operator=(const flat_map &other) {
+        if(this == &other) return *this;
+        flat_map tmp(other);
+        Key *k = keys; keys = tmp.keys; tmp.keys = k;
+        value_type *d = data; data = tmp.data; tmp.data = d;
+        size_t n = num; num = tmp.num; tmp.num = n;
+        size_t c = cap; cap = tmp.cap; tmp.cap = c;
+        return *this;
+    }
+	~flat_map() {
+        Destroy();
+        free(keys);
+        free(data);
+    }
+	T & at(const Key &key) {
+        size_t pos = Find(key);
+        if(pos == num) throw index_out_of_bound();
+        return data[pos].second;
+    }
+	const T & at(const Key &key) const {
+        size_t pos = Find(key);
+        if(pos == num) throw index_out_of_bound();
+        return data[pos].second;
+    }
+	T & operator[](const Key &key) {
+        return try_emplace(key).first->second;
+    }
+	T & operator[](Key &&key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+	const T & operator[](const Key &key) const {
+        return at(key);
+    }
+	iterator begin() { return iterator(0, this); }
+	const_iterator cbegin() const { return const_iterator(0, this); }
+	iterator end() { return iterator(num, this); }
+	const_iterator cend() const { return const_iterator(num, this); }
+	bool empty() const {return !num;}
+	size_t size() const {return num;}
+	void clear() {Destroy();}
+	pair<iterator, bool> insert(const value_type &value) {
+        size_t pos = LowerBound(value.first);
+        if(pos < num && !Compare()(value.first, keys[pos])) return pair<iterator, bool>(iterator(pos, this), 0);
+        return pair<iterator, bool>(iterator(InsertAt(pos, value), this), 1);
+    }
+	pair<iterator, bool> insert(value_type &&value) {
+        size_t pos = LowerBound(value.first);
+        if(pos < num && !Compare()(value.first, keys[pos])) return pair<iterator, bool>(iterator(pos, this), 0);
+        return pair<iterator, bool>(iterator(InsertAt(pos, std::move(value)), this), 1);
+    }
+    template<class... Args>
+    pair<iterator, bool> emplace(Args &&...args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        size_t pos = LowerBound(key);
+        if(pos < num && !Compare()(key, keys[pos])) return pair<iterator, bool>(iterator(pos, this), 0);
+        return pair<iterator, bool>(iterator(InsertAt(pos, std::piecewise_construct, std::forward_as_tuple(key),
+                                                      std::forward_as_tuple(std::forward<Args>(args)...)), this), 1);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+        size_t pos = LowerBound(key);
+        if(pos < num && !Compare()(key, keys[pos])) return pair<iterator, bool>(iterator(pos, this), 0);
+        return pair<iterator, bool>(iterator(InsertAt(pos, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                                      std::forward_as_tuple(std::forward<Args>(args)...)), this), 1);
+    }
+    /**
+     * 批量插入：新元素先排序去重，再与已有元素一次归并到新数组，总代价 O(n + m log m)。
+     * 已存在的键不会被覆盖；元素的拷贝抛出异常时表保持原状
+     */
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        value_type *buf;
+        size_t m = Collect(first, last, buf);
+        size_t *idx = nullptr;
+        try{
+            idx = new size_t[m ? m : 1];
+            size_t u = SortUnique(buf, idx, m), fresh = 0;
+            //顺序扫描一遍已有的键，去掉已存在的键
+            for(size_t i = 0, p = 0; i < u; ++i){
+                const Key &key = buf[idx[i]].first;
+                while(p < num && Compare()(keys[p], key)) ++p;
+                if(p == num || Compare()(key, keys[p])) idx[fresh++] = idx[i];
+            }
+            if(fresh){
+                Fresh f(CapFor(num + fresh));
+                for(size_t i = 0, j = 0; i < num || j < fresh;){
+                    if(j == fresh || (i < num && Compare()(keys[i], buf[idx[j]].first))) PushOld(f, i++);
+                    else{
+                        value_type &v = buf[idx[j++]];
+                        f.Push(v.first, std::move(v));
+                    }
+                }
+                Adopt(f);
+            }
+        }catch(...){
+            delete []idx;
+            for(size_t i = 0; i < m; ++i) buf[i].~value_type();
+            free(buf);
+            throw;
+        }
+        delete []idx;
+        for(size_t i = 0; i < m; ++i) buf[i].~value_type();
+        free(buf);
+    }
+	void erase(iterator pos) {
+        if(pos.from != this || pos.pos >= num) throw invalid_iterator();
+        keys[pos.pos].~Key();
+        data[pos.pos].~value_type();
+        num--;
+        ShiftLeft(pos.pos);
+    }
+    /**
+     * 元素句柄：持有从数组中移出的一个元素，可以插入同类型的任意 flat_map
+     */
+    class node_type {
+        friend class flat_map;
+    private:
+        value_type *ptr = nullptr; //malloc 申请、placement new 构造，与表中的数组一致
+        explicit node_type(value_type *p) : ptr(p) {}
+        void Reset(){
+            if(ptr){
+                ptr->~value_type();
+                free(ptr);
+                ptr = nullptr;
+            }
+        }
+    public:
+        node_type() {}
+        node_type(node_type &&other) : ptr(other.ptr) {
+            other.ptr = nullptr;
+        }
+        node_type &operator = (node_type &&other){
+            if(this == &other) return *this;
+            Reset();
+            ptr = other.ptr;
+            other.ptr = nullptr;
+            return *this;
+        }
+        node_type(const node_type &) = delete;
+        node_type &operator = (const node_type &) = delete;
+        ~node_type(){
+            Reset();
+        }
+        bool empty() const {return ptr == nullptr;}
+        explicit operator bool() const {return ptr != nullptr;}
+        const Key &key() const {
+            if(!ptr) throw invalid_iterator();
+            return ptr->first;
+        }
+        T &mapped() const {
+            if(!ptr) throw invalid_iterator();
+            return ptr->second;
+        }
+        value_type &value() const {
+            if(!ptr) throw invalid_iterator();
+            return *ptr;
+        }
+    };
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node; //插入失败时元素原样交还
+    };
+    node_type extract(iterator pos) {
+        if(pos.from != this || pos.pos >= num) throw invalid_iterator();
+        value_type *p = (value_type*) malloc(sizeof(value_type));
+        if(!p) throw std::bad_alloc();
+        try{
+            new (p) value_type(std::move(data[pos.pos]));
+        }catch(...){
+            free(p);
+            throw;
+        }
+        node_type res(p);
+        erase(pos);
+        return res;
+    }
+    /**
+     * 键不存在时返回空句柄
+     */
+    node_type extract(const Key &key) {
+        size_t pos = Find(key);
+        if(pos == num) return node_type();
+        return extract(iterator(pos, this));
+    }
+    /**
+     * 插入句柄中的元素；键已存在时不插入，元素留在返回值的 node 中
+     */
+    insert_return_type insert(node_type &&nh) {
+        if(nh.empty()) return {end(), false, node_type()};
+        size_t pos = LowerBound(nh.key());
+        if(pos < num && !Compare()(nh.key(), keys[pos])) return {iterator(pos, this), false, static_cast<node_type &&>(nh)};
+        InsertAt(pos, std::move(*nh.ptr));
+        nh.Reset();
+        return {iterator(pos, this), true, node_type()};
+    }
+    /**
+     * 把 other 中本容器没有的键转移过来，键已存在的元素留在 other 中。
+     * 两个有序数组顺序扫描一遍找出要转移的元素，再把归并结果与 other 剩下的元素各构造到新数组中，总代价 O(n + m)
+     */
+    void merge(flat_map &other) {
+        if(&other == this) return;
+        size_t *idx = new size_t[other.num ? other.num : 1];
+        size_t fresh = 0;
+        for(size_t i = 0, p = 0; i < other.num; ++i){
+            while(p < num && Compare()(keys[p], other.keys[i])) ++p;
+            if(p == num || Compare()(other.keys[i], keys[p])) idx[fresh++] = i;
+        }
+        if(!fresh){
+            delete []idx;
+            return;
+        }
+        try{
+            //两边都先构造到新数组中，全部成功后才换入，任何一步抛出两个表都保持原状
+            Fresh f(CapFor(num + fresh)), rest(other.CapFor(other.num - fresh));
+            for(size_t i = 0, j = 0; i < num || j < fresh;){
+                if(j == fresh || (i < num && Compare()(keys[i], other.keys[idx[j]]))) PushOld(f, i++);
+                else other.PushOld(f, idx[j++]);
+            }
+            for(size_t r = 0, t = 0; r < other.num; ++r){
+                if(t < fresh && idx[t] == r) ++t;
+                else other.PushOld(rest, r);
+            }
+            Adopt(f);
+            other.Adopt(rest);
+        }catch(...){
+            delete []idx;
+            throw;
+        }
+        delete []idx;
+    }
+    /**
+     * 批量查找 keys[0, n)，out[i] 为 keys[i] 对应的迭代器，找不到为 end()。
+     * 每组键同步二分，一组内的缓存缺失相互重叠
+     */
+    void find_batch(const Key *query, size_t n, iterator *out) {
+        size_t res[BatchGroup];
+        for(size_t base = 0; base < n; base += BatchGroup){
+            size_t m = n - base < BatchGroup ? n - base : BatchGroup;
+            FindBatch(query + base, m, res);
+            for(size_t i = 0; i < m; ++i) out[base + i] = iterator(res[i], this);
+        }
+    }
+    void find_batch(const Key *query, size_t n, const_iterator *out) const {
+        size_t res[BatchGroup];
+        for(size_t base = 0; base < n; base += BatchGroup){
+            size_t m = n - base < BatchGroup ? n - base : BatchGroup;
+            FindBatch(query + base, m, res);
+            for(size_t i = 0; i < m; ++i) out[base + i] = const_iterator(res[i], this);
+        }
+    }
+	size_t count(const Key &key) const {
+        return Find(key) == num ? 0 : 1;
+    }
+	iterator find(const Key &key) {
+        return iterator(Find(key), this);
+    }
+	const_iterator find(const Key &key) const {
+        return const_iterator(Find(key), this);
+    }
+};
+
+}
+
+#endif
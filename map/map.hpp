@@ -6,8 +6,30 @@
 
 #include <functional>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "instrument.hpp"
+
+//迭代器检查策略：开启时迭代器额外记录容器的代数，每次移动、解引用都检查越界与失效；
+//关闭时迭代器只做指针操作。默认随 NDEBUG 关闭，也可以在包含头文件前显式定义为 0 / 1。
+#ifndef SJTU_CHECKED_ITERATORS
+#ifdef NDEBUG
+#define SJTU_CHECKED_ITERATORS 0
+#else
+#define SJTU_CHECKED_ITERATORS 1
+#endif
+#endif
+
+//紧凑结点：结点从同类型 map 共用的 NodeArena 中分配，儿子与父结点都存成 32 位编号，
+//颜色放进父结点编号的低位，元素直接存放在结点内；每个元素省下数据指针和两次 malloc 的块头，
+//三个链接各只占 4 字节。代价是每走一步要由编号换算地址，且池中的内存只复用、不归还。默认关闭。
+#ifndef SJTU_MAP_COMPACT_NODES
+#define SJTU_MAP_COMPACT_NODES 0
+#endif
 
 namespace sjtu {
 
@@ -27,59 +49,194 @@ template<
 public:
 	typedef pair<const Key, T> value_type;
     enum NodeColor { RED, BLACK };
+    struct NodeArena;
+    //结点的父指针、颜色与元素只通过下面的访问函数读写，两种布局共用同一套树算法
     struct RedBlackNode{
-        value_type *data;
-        RedBlackNode *p, *son[2];
-        NodeColor color;
-        RedBlackNode():color(RED){
-            p = son[0] = son[1] = nullptr;
-            data = nullptr;
-        }
-        explicit RedBlackNode(const value_type &tmp_data, RedBlackNode *tmp_p = nullptr, NodeColor c = RED){
+#if SJTU_MAP_COMPACT_NODES
+        //儿子链接：存结点在 NodeArena 中的编号（0 为空），读写时与 RedBlackNode * 互相转换
+        class Ref {
+            uint32_t id = 0;
+        public:
+            Ref &operator = (RedBlackNode *x) {
+                id = x ? x->self : 0;
+                return *this;
+            }
+            operator RedBlackNode *() const {return NodeArena::At(id);}
+            RedBlackNode *operator->() const {return NodeArena::At(id);}
+        };
+        Ref son[2];
+    private:
+        uint32_t self; //本结点的编号
+        //父结点编号 << 2 | 是否存有元素（次低位）| 颜色（最低位，即 NodeColor 的值）
+        uint32_t link;
+        alignas(value_type) unsigned char buf[sizeof(value_type)];
+        static const uint32_t ColorBit = 1, ValueBit = 2, FlagMask = 3;
+        friend struct NodeArena;
+    public:
+        RedBlackNode() : self(0), link(RED){
             son[0] = son[1] = nullptr;
-            p = tmp_p;
-            color = c;
-            data = (value_type*) malloc(sizeof(value_type));
-            new (data) value_type(tmp_data);
         }
-        RedBlackNode(const RedBlackNode &rhs, RedBlackNode *tmp_p):p(tmp_p), color(rhs.color){
+        RedBlackNode *parent() const {return NodeArena::At(link >> 2);}
+        void setParent(RedBlackNode *x) {link = (x ? x->self << 2 : 0) | (link & FlagMask);}
+        NodeColor color() const {return NodeColor(link & ColorBit);}
+        void setColor(NodeColor c) {link = (link & ~ColorBit) | uint32_t(c);}
+        bool hasValue() const {return link & ValueBit;}
+        //只在 hasValue() 时有意义；不做判断，查找路径上不多一次分支
+        value_type *data() {return reinterpret_cast<value_type *>(buf);}
+        const value_type *data() const {return reinterpret_cast<const value_type *>(buf);}
+        template<class... Args>
+        void construct(Args &&...args){
+            new (buf) value_type(std::forward<Args>(args)...);
+            link |= ValueBit;
+        }
+        ~RedBlackNode(){
+            if(hasValue()) data()->~value_type();
+        }
+#else
+        RedBlackNode *son[2];
+    private:
+        value_type *val;
+        RedBlackNode *fa;
+        NodeColor col;
+    public:
+        RedBlackNode() : val(nullptr), fa(nullptr), col(RED){
             son[0] = son[1] = nullptr;
-            if(!rhs.data) data = nullptr;
-            else {
-                data = (value_type*) malloc(sizeof(value_type));
-                new (data) value_type (*rhs.data);
+        }
+        RedBlackNode *parent() const {return fa;}
+        void setParent(RedBlackNode *x) {fa = x;}
+        NodeColor color() const {return col;}
+        void setColor(NodeColor c) {col = c;}
+        bool hasValue() const {return val != nullptr;}
+        value_type *data() {return val;}
+        const value_type *data() const {return val;}
+        template<class... Args>
+        void construct(Args &&...args){
+            value_type *tmp = (value_type*) malloc(sizeof(value_type));
+            try{
+                new (tmp) value_type(std::forward<Args>(args)...);
+            }catch(...){
+                free(tmp);
+                throw;
             }
+            val = tmp;
         }
         ~RedBlackNode(){
-            if(data){
-                (*data).~value_type();
-                free(data);
-                data = nullptr;
+            if(val){
+                val->~value_type();
+                free(val);
+                val = nullptr;
+            }
+        }
+#endif
+        //复制颜色与元素，父结点为 tmp_p
+        RedBlackNode(const RedBlackNode &rhs, RedBlackNode *tmp_p) : RedBlackNode(){
+            setParent(tmp_p);
+            setColor(rhs.color());
+            if(rhs.hasValue()) construct(*rhs.data());
+        }
+        RedBlackNode(const RedBlackNode &) = delete;
+        RedBlackNode &operator = (const RedBlackNode &) = delete;
+    };
+#if SJTU_MAP_COMPACT_NODES
+    /**
+     * 同类型的所有 map 共用的结点池。槽按 4096 个一块分配，编号 i（从 1 开始）在第 i >> 12 块，
+     * 由编号换算地址只需一次移位和一次查表；块只追加、不移动，已发出的地址始终有效。
+     * 结点句柄、merge 与 map_parallel 在同类型的 map 之间转移结点时编号不变。
+     * 释放的槽串成空闲链表（下一个空闲槽的编号写在槽的开头）复用，块直到进程结束才归还。
+     * 分配与释放加锁，map_parallel 可以在多个线程里同时建结点
+     */
+    struct NodeArena {
+        //最多 2^30 - 1 个槽，编号放得进父结点的 30 位；块表 2MB，只有用到的部分才会占用物理页
+        static const int ChunkBits = 12, ChunkNum = 1 << 18;
+        static const uint32_t ChunkMask = (1u << ChunkBits) - 1;
+        static inline unsigned char *chunks[ChunkNum] = {};
+        static inline uint32_t used = 1, freeList = 0; //编号 0 表示空，不发出
+        static inline std::mutex lock;
+        static RedBlackNode *At(uint32_t id) {
+            if(!id) return nullptr;
+            return reinterpret_cast<RedBlackNode *>(chunks[id >> ChunkBits]) + (id & ChunkMask);
+        }
+        static uint32_t Allocate() {
+            std::lock_guard<std::mutex> guard(lock);
+            if(freeList){
+                uint32_t id = freeList;
+                memcpy(&freeList, At(id), sizeof(uint32_t));
+                return id;
+            }
+            uint32_t k = used >> ChunkBits;
+            if(k >= (uint32_t) ChunkNum) throw std::bad_alloc();
+            if(!chunks[k]) chunks[k] = static_cast<unsigned char *>(::operator new(sizeof(RedBlackNode) << ChunkBits, std::align_val_t(alignof(RedBlackNode))));
+            return used++;
+        }
+        static void Deallocate(uint32_t id) {
+            std::lock_guard<std::mutex> guard(lock);
+            memcpy(static_cast<void *>(At(id)), &freeList, sizeof(uint32_t));
+            freeList = id;
+        }
+        //在新取的槽里构造结点，构造失败时槽归还
+        template<class... Args>
+        static RedBlackNode *Create(Args &&...args) {
+            uint32_t id = Allocate();
+            RedBlackNode *res;
+            try{
+                res = new (At(id)) RedBlackNode(std::forward<Args>(args)...);
+            }catch(...){
+                Deallocate(id);
+                throw;
             }
+            res->self = id;
+            return res;
+        }
+        static void Destroy(RedBlackNode *t) {
+            if(!t) return;
+            uint32_t id = t->self;
+            t->~RedBlackNode();
+            Deallocate(id);
         }
     };
+#endif
+    //结点的创建与释放：紧凑布局下在 NodeArena 的槽里，否则直接 new / delete
+    template<class... Args>
+    static RedBlackNode *CreateNode(Args &&...args) {
+#if SJTU_MAP_COMPACT_NODES
+        return NodeArena::Create(std::forward<Args>(args)...);
+#else
+        return new RedBlackNode(std::forward<Args>(args)...);
+#endif
+    }
+    static void DestroyNode(RedBlackNode *t) {
+#if SJTU_MAP_COMPACT_NODES
+        NodeArena::Destroy(t);
+#else
+        delete t;
+#endif
+    }
     class RedBlackTree{
     private:
         RedBlackNode *root;
-        bool isEqual(const Key &a, const Key &b) const {return !(Compare()(a, b) || Compare()(b, a));}
+        bool Less(const Key &a, const Key &b) const {
+            SJTU_INSTRUMENT_ADD(map_comparisons, 1);
+            return Compare()(a, b);
+        }
+        bool isEqual(const Key &a, const Key &b) const {return !(Less(a, b) || Less(b, a));}
     public:
         size_t size;
         RedBlackNode *endNode;
         RedBlackTree() : root(nullptr), size(0){
-            endNode = new RedBlackNode();
+            endNode = CreateNode();
         }
         RedBlackTree &operator = (const RedBlackTree &other){
             if(this == &other) return *this;
-            delete endNode;
-            endNode = new RedBlackNode();
+            DestroyNode(endNode);
+            endNode = CreateNode();
             treeClear(root);
-            treeClone(other.root, root, nullptr);
+            treeClone(other.root, nullptr, 0);
             size = other.size;
             return *this;
         }
         ~RedBlackTree(){
             treeClear(root);
-            delete endNode;
+            DestroyNode(endNode);
             size = 0;
         }
         void findNext(RedBlackNode * &t) const {
@@ -88,8 +245,8 @@ public:
                 while(t->son[0]) t = t->son[0];
             }
             else{
-                while(t->p && t->p->son[1] == t) t = t->p;
-                t = t->p;
+                while(t->parent() && t->parent()->son[1] == t) t = t->parent();
+                t = t->parent();
             }
             if(t == nullptr) t = endNode;
         }
@@ -104,8 +261,8 @@ public:
                     while(t->son[1]) t = t->son[1];
                 }
                 else{
-                    while(t->p && t->p->son[0] == t) t = t->p;
-                    t = t->p;
+                    while(t->parent() && t->parent()->son[0] == t) t = t->parent();
+                    t = t->parent();
                 }
             }
         }
@@ -117,80 +274,147 @@ public:
         }
         RedBlackNode *find(const Key &x) const{
             RedBlackNode *t = root;
-            while(t != nullptr && !isEqual(t->data->first, x))
-                Compare()(x, t->data->first) ? t = t->son[0] : t = t->son[1];
+            while(t != nullptr && !isEqual(t->data()->first, x)){
+                SJTU_INSTRUMENT_ADD(map_descents, 1);
+                Less(x, t->data()->first) ? t = t->son[0] : t = t->son[1];
+            }
             return t;
         }
+        static void Prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#else
+            (void) p;
+#endif
+        }
+        static const size_t BatchGroup = 16; //findBatch 一次最多同时下降的键数
+        /**
+         * 同时为 keys[0, n) 下降（n 不超过 BatchGroup），每轮所有未结束的键各走一层：
+         * 先预取当前结点的数据块，再比较并预取下一层结点，一组内的缓存缺失相互重叠
+         */
+        void findBatch(const Key *keys, size_t n, RedBlackNode **res) const {
+            RedBlackNode *cur[BatchGroup];
+            size_t active = 0;
+            for(size_t i = 0; i < n; ++i){
+                res[i] = nullptr;
+                cur[i] = root;
+                if(root) active++;
+            }
+            while(active){
+                for(size_t i = 0; i < n; ++i)
+                    if(cur[i]) Prefetch(cur[i]->data());
+                for(size_t i = 0; i < n; ++i){
+                    RedBlackNode *t = cur[i];
+                    if(!t) continue;
+                    if(Less(keys[i], t->data()->first)) cur[i] = t->son[0];
+                    else if(Less(t->data()->first, keys[i])) cur[i] = t->son[1];
+                    else{
+                        res[i] = t;
+                        cur[i] = nullptr;
+                    }
+                    if(cur[i]){
+                        SJTU_INSTRUMENT_ADD(map_descents, 1);
+                        Prefetch(cur[i]);
+                    }
+                    else active--;
+                }
+            }
+        }
         void treeMakeEmpty(){
             treeClear(root);
             size = 0;
         }
-        void treeInsert(const value_type &x){
+        RedBlackNode *getRoot() const {return root;}
+        //交出整棵树（容器变空）/ 接管一棵结点与父指针都已连好的树，供 map_parallel.hpp 的 join 类算法直接改写结点
+        RedBlackNode *release(){
+            RedBlackNode *res = root;
+            root = nullptr;
+            size = 0;
+            return res;
+        }
+        void adopt(RedBlackNode *r, size_t n){
+            treeClear(root);
+            root = r;
+            if(root){
+                root->setParent(nullptr);
+                root->setColor(BLACK);
+            }
+            size = n;
+        }
+        //把一个游离的结点插入树中（调用前须确认键不存在），返回该结点
+        RedBlackNode *treeInsert(RedBlackNode *n){
+            n->son[0] = n->son[1] = nullptr;
             if(!root){
-                root = new RedBlackNode(x, nullptr, BLACK);
+                root = n;
+                n->setParent(nullptr);
+                n->setColor(BLACK);
                 size++;
-                return;
+                return n;
             }
+            const Key &x = n->data()->first;
             RedBlackNode *t = root, *fa = nullptr;
             while(true){
                 if(t){
-                    if(t->son[0] && t->son[1] && t->son[0]->color == RED && t->son[1]->color == RED){
-                        t->son[0]->color = t->son[1]->color = BLACK;
-                        t->color = RED;
+                    if(t->son[0] && t->son[1] && t->son[0]->color() == RED && t->son[1]->color() == RED){
+                        t->son[0]->setColor(BLACK), t->son[1]->setColor(BLACK);
+                        t->setColor(RED);
                         insertAdjust(t);
                     }
                     fa = t;
-                    t = (Compare()(x.first, t->data->first) ? t->son[0] : t->son[1]);
+                    SJTU_INSTRUMENT_ADD(map_descents, 1);
+                    t = (Less(x, t->data()->first) ? t->son[0] : t->son[1]);
                 }
                 else {
-                    t = new RedBlackNode(x, fa, RED);
+                    t = n;
+                    t->setColor(RED);
                     size++;
-                    Compare()(x.first, fa->data->first) ? fa->son[0] = t : fa->son[1] = t;
-                    t->p = fa;
+                    Less(x, fa->data()->first) ? fa->son[0] = t : fa->son[1] = t;
+                    t->setParent(fa);
                     insertAdjust(t);
-                    root->color = BLACK; //如果根节点是被旋转上去的红结点，需要改变根节点的颜色。
-                    return;
+                    root->setColor(BLACK); //如果根节点是被旋转上去的红结点，需要改变根节点的颜色。
+                    return n;
                 }
             }
         }
-        void treeRemove(const Key &x){
+        //把键为 x 的结点从树中摘下并返回（不释放），调用前须确认键存在
+        RedBlackNode *treeRemove(const Key &x){
             RedBlackNode *t, *p, *c;
-            if(!root) return;
-            if(isEqual(root->data->first, x) && root->son[0] == nullptr && root->son[1] == nullptr){
-                delete root;
+            if(!root) return nullptr;
+            if(isEqual(root->data()->first, x) && root->son[0] == nullptr && root->son[1] == nullptr){
+                c = root;
                 root = nullptr;
                 size--;
-                return;
+                return c;
             }
             p = c = t = root;
             while(true){
                 removeAdjust(p, c, t, x);
-                if(isEqual(c->data->first, x) && c->son[0] && c->son[1]){
+                if(isEqual(c->data()->first, x) && c->son[0] && c->son[1]){
                     RedBlackNode *alter = c->son[1], *alt_fa, *c_fa, *tmp_node;
                     NodeColor alt_color;
                     while(alter->son[0]) alter = alter->son[0];
-                    alt_fa = alter->p, c_fa = c->p;
-                    alt_color = alter->color;
+                    alt_fa = alter->parent(), c_fa = c->parent();
+                    alt_color = alter->color();
                     if(alt_fa == c){//处理特殊情况
-                        alter->color = c->color, c->color = alt_color;
+                        alter->setColor(c->color()), c->setColor(alt_color);
                         if(c_fa) c == c_fa->son[0] ? c_fa->son[0] = alter : c_fa->son[1] = alter;
-                        alter->p = c_fa;
+                        alter->setParent(c_fa);
                         tmp_node = c->son[0];
-                        c->son[0] = alter->son[0]; if(c->son[0]) c->son[0]->p = c;
-                        c->son[1] = alter->son[1]; if(c->son[1]) c->son[1]->p = c;
-                        alter->son[0] = tmp_node, alter->son[0]->p = alter;
-                        alter->son[1] = c, c->p = alter;
+                        c->son[0] = alter->son[0]; if(c->son[0]) c->son[0]->setParent(c);
+                        c->son[1] = alter->son[1]; if(c->son[1]) c->son[1]->setParent(c);
+                        alter->son[0] = tmp_node, alter->son[0]->setParent(alter);
+                        alter->son[1] = c, c->setParent(alter);
                     }
                     else{
-                        alter->color = c->color, c->color = alt_color;
+                        alter->setColor(c->color()), c->setColor(alt_color);
                         if(c_fa) c == c_fa->son[0] ? c_fa->son[0] = alter : c_fa->son[1] = alter;
-                        alter->p = c_fa;
-                        alt_fa->son[0] = c, c->p = alt_fa;
+                        alter->setParent(c_fa);
+                        alt_fa->son[0] = c, c->setParent(alt_fa);
                         RedBlackNode *alter_sonR = alter->son[1];
-                        alter->son[0] = c->son[0], c->son[0]->p = alter;
-                        alter->son[1] = c->son[1], c->son[1]->p = alter;
+                        alter->son[0] = c->son[0], c->son[0]->setParent(alter);
+                        alter->son[1] = c->son[1], c->son[1]->setParent(alter);
                         c->son[0] = nullptr;
-                        c->son[1] = alter_sonR; if(c->son[1]) c->son[1]->p = c;
+                        c->son[1] = alter_sonR; if(c->son[1]) c->son[1]->setParent(c);
                     }
                     if(c == root) root = alter;
                     p = alter;
@@ -198,42 +422,46 @@ public:
                     t = alter->son[0];
                     continue;
                 }
-                if(isEqual(c->data->first, x)){
+                if(isEqual(c->data()->first, x)){
                     p->son[0] == c ? p->son[0] = c->son[1] : p->son[1] = c->son[1];
-                    delete c;
-                    c = nullptr;
+                    c->setParent(nullptr);
                     size--;
-                    root->color = BLACK;
-                    return;
+                    root->setColor(BLACK);
+                    return c;
                 }
                 p = c;
-                c = (Compare()(x, c->data->first) ? c->son[0] : c->son[1]);
+                SJTU_INSTRUMENT_ADD(map_descents, 1);
+                c = (Less(x, c->data()->first) ? c->son[0] : c->son[1]);
                 t = (p->son[0] == c ? p->son[1] : p->son[0]);
             }
         }
     private:
         bool allBLACK(RedBlackNode *t){
-            return !((t->son[0] && t->son[0]->color == RED) || (t->son[1] && t->son[1]->color == RED));
+            return !((t->son[0] && t->son[0]->color() == RED) || (t->son[1] && t->son[1]->color() == RED));
         }
-        void treeClone(const RedBlackNode *rhs, RedBlackNode * &cur, RedBlackNode *f){
+        //把 rhs 复制为 f 的 d 侧儿子（f 为空时为根）；先挂上再复制子树，中途抛出异常时已复制的部分都在树上
+        void treeClone(const RedBlackNode *rhs, RedBlackNode *f, int d){
             if(rhs == nullptr) return;
-            cur = new RedBlackNode(*rhs, f);
-            treeClone(rhs->son[0], cur->son[0], cur);
-            treeClone(rhs->son[1], cur->son[1], cur);
+            RedBlackNode *cur = CreateNode(*rhs, f);
+            if(f) f->son[d] = cur;
+            else root = cur;
+            treeClone(rhs->son[0], cur, 0);
+            treeClone(rhs->son[1], cur, 1);
         }
         void treeClear(RedBlackNode * &rt){
             if(rt == nullptr) return;
-            treeClear(rt->son[0]);
-            treeClear(rt->son[1]);
-            delete rt;
+            RedBlackNode *l = rt->son[0], *r = rt->son[1];
+            treeClear(l);
+            treeClear(r);
+            DestroyNode(rt);
             rt = nullptr;
         }
         void insertAdjust(RedBlackNode *t){
-            RedBlackNode *f = t->p, *gf;
-            gf = (f == nullptr ? nullptr : f->p);
-            if(f == nullptr || f->color == BLACK) return;
+            RedBlackNode *f = t->parent(), *gf;
+            gf = (f == nullptr ? nullptr : f->parent());
+            if(f == nullptr || f->color() == BLACK) return;
             if(f == root){
-                f->color = BLACK;
+                f->setColor(BLACK);
                 return;
             }
             if(gf && gf->son[0] == f){
@@ -246,101 +474,102 @@ public:
             }
         }
         void removeAdjust(RedBlackNode * &p, RedBlackNode * &c, RedBlackNode * &t,const Key &del){
-            if(c->color == RED) return;
+            if(c->color() == RED) return;
             if(c == root){
-                if(c->son[0] && c->son[1] && c->son[0]->color == c->son[1]->color){
-                    c->color = RED;
-                    c->son[0]->color = c->son[1]->color = BLACK;
+                if(c->son[0] && c->son[1] && c->son[0]->color() == c->son[1]->color()){
+                    c->setColor(RED);
+                    c->son[0]->setColor(BLACK), c->son[1]->setColor(BLACK);
                     return;
                 }
             }
             if(allBLACK(c)){//x 有两个黑儿子
                 if(allBLACK(t)){//t 有两个黑儿子
-                    c->color = RED;
-                    t->color = RED;
-                    p->color = BLACK;
+                    c->setColor(RED);
+                    t->setColor(RED);
+                    p->setColor(BLACK);
                 }
                 else{//t 有红色儿子
                     if(p->son[0] == t){//t 为 p 的左儿子
-                        if(t->son[0] && t->son[0]->color == RED){//t 有外侧红儿子
+                        if(t->son[0] && t->son[0]->color() == RED){//t 有外侧红儿子
                             LL(p);
-                            c->color = RED;
-                            t->color = RED;
-                            t->son[0]->color = BLACK;
-                            p->color = BLACK;
+                            c->setColor(RED);
+                            t->setColor(RED);
+                            t->son[0]->setColor(BLACK);
+                            p->setColor(BLACK);
                             t = p->son[0];
                         }
                         else{//t 有内侧红儿子
                             LR(p);
-                            p->p->color = RED;
-                            c->color = RED;
-                            p->color = BLACK;
-                            t->color = BLACK;
+                            p->parent()->setColor(RED);
+                            c->setColor(RED);
+                            p->setColor(BLACK);
+                            t->setColor(BLACK);
                             t = p->son[0];
                         }
                     }
                     else{// t 为 p 的右儿子
-                        if(t->son[1] && t->son[1]->color == RED){//t 有外侧红儿子
+                        if(t->son[1] && t->son[1]->color() == RED){//t 有外侧红儿子
                             RR(p);
-                            c->color = RED;
-                            t->color = RED;
-                            t->son[1]->color = BLACK;
-                            p->color = BLACK;
+                            c->setColor(RED);
+                            t->setColor(RED);
+                            t->son[1]->setColor(BLACK);
+                            p->setColor(BLACK);
                             t = p->son[1];
                         }
                         else{//t 有内侧红儿子
                             RL(p);
-                            p->p->color = RED;
-                            c->color = RED;
-                            t->color = BLACK;
-                            p->color = BLACK;
+                            p->parent()->setColor(RED);
+                            c->setColor(RED);
+                            t->setColor(BLACK);
+                            p->setColor(BLACK);
                             t = p->son[1];
                         }
                     }
                 }
             }
             else{//x 至少有一个红儿子
-                if(isEqual(c->data->first, del)){//x 是被删节点
+                if(isEqual(c->data()->first, del)){//x 是被删节点
                     if(c->son[0] && c->son[1]){//x 有两个儿子
-                        if(c->son[1]->color == BLACK){
+                        if(c->son[1]->color() == BLACK){
                             LL(c);
-                            c->color = RED;
-                            c->p->color = BLACK;
-                            p = c->p;
+                            c->setColor(RED);
+                            c->parent()->setColor(BLACK);
+                            p = c->parent();
                             t = p->son[0];
                         }
                         return;
                     }
                     if(c->son[0]){//x 只有左儿子
                         LL(c);
-                        c->color = RED;
-                        c->p->color = BLACK;
-                        p = c->p;
+                        c->setColor(RED);
+                        c->parent()->setColor(BLACK);
+                        p = c->parent();
                         t = p->son[0];
                     }
                     else{//x 只有右儿子
                         RR(c);
-                        c->color = RED;
-                        c->p->color = BLACK;
-                        p = c->p;
+                        c->setColor(RED);
+                        c->parent()->setColor(BLACK);
+                        p = c->parent();
                         t = p->son[1];
                     }
                 }
                 else{//x 不是被删节点
                     //往下走一层
                     p = c;
-                    c = (Compare()(del, p->data->first) ? p->son[0] : p->son[1]);
+                    SJTU_INSTRUMENT_ADD(map_descents, 1);
+                    c = (Less(del, p->data()->first) ? p->son[0] : p->son[1]);
                     t = (c == p->son[0] ? p->son[1] : p->son[0]);
-                    if(c->color == BLACK){//如果新的 x 结点为黑结点
+                    if(c->color() == BLACK){//如果新的 x 结点为黑结点
                         if(t == p->son[1]){//新的 x 是左儿子
                             RR(p);
-                            p->color = RED;
-                            t->color = BLACK;
+                            p->setColor(RED);
+                            t->setColor(BLACK);
                         }
                         else{//新的 x 是右儿子
                             LL(p);
-                            p->color = RED;
-                            t->color = BLACK;
+                            p->setColor(RED);
+                            t->setColor(BLACK);
                         }
                         c = p;
                         p = t;
@@ -351,90 +580,110 @@ public:
             }
         }
         void LL(RedBlackNode *gf){
-            RedBlackNode *p = gf->son[0], *fa = gf->p;
-            if(fa) fa->son[0] == gf ? fa->son[0] = p : fa->son[1] = p; p->p = fa;
-            gf->son[0] = p->son[1]; if(gf->son[0]) gf->son[0]->p = gf;
-            p->son[1] = gf, gf->p = p;
-            p->color = BLACK, gf->color = RED;
-            while(root->p) root = root->p;
+            SJTU_INSTRUMENT_ADD(map_rotations, 1);
+            RedBlackNode *p = gf->son[0], *fa = gf->parent();
+            if(fa) fa->son[0] == gf ? fa->son[0] = p : fa->son[1] = p; p->setParent(fa);
+            gf->son[0] = p->son[1]; if(gf->son[0]) gf->son[0]->setParent(gf);
+            p->son[1] = gf, gf->setParent(p);
+            p->setColor(BLACK), gf->setColor(RED);
+            while(root->parent()) root = root->parent();
         }
         void RR(RedBlackNode *gf){
-            RedBlackNode *p = gf->son[1], *fa = gf->p;
-            if(fa) fa->son[0] == gf ? fa->son[0] = p : fa->son[1] = p; p->p = fa;
-            gf->son[1] = p->son[0]; if(gf->son[1]) gf->son[1]->p = gf;
-            p->son[0] = gf, gf->p = p;
-            p->color = BLACK, gf->color = RED;
-            while(root->p) root = root->p;
+            SJTU_INSTRUMENT_ADD(map_rotations, 1);
+            RedBlackNode *p = gf->son[1], *fa = gf->parent();
+            if(fa) fa->son[0] == gf ? fa->son[0] = p : fa->son[1] = p; p->setParent(fa);
+            gf->son[1] = p->son[0]; if(gf->son[1]) gf->son[1]->setParent(gf);
+            p->son[0] = gf, gf->setParent(p);
+            p->setColor(BLACK), gf->setColor(RED);
+            while(root->parent()) root = root->parent();
         }
         void LR(RedBlackNode *gf){
-            RedBlackNode *p = gf->son[0], *t = p->son[1], *fa = gf->p;
-            if(fa) fa->son[0] == gf ? fa->son[0] = t : fa->son[1] = t; t->p = fa;
-            gf->son[0] = t->son[1]; if(gf->son[0]) gf->son[0]->p = gf;
-            p->son[1] = t->son[0]; if(p->son[1]) p->son[1]->p = p;
-            t->son[0] = p, p->p = t;
-            t->son[1] = gf, gf->p = t;
-            t->color = BLACK, gf->color = RED;
-            while(root->p) root = root->p;
+            SJTU_INSTRUMENT_ADD(map_rotations, 1);
+            RedBlackNode *p = gf->son[0], *t = p->son[1], *fa = gf->parent();
+            if(fa) fa->son[0] == gf ? fa->son[0] = t : fa->son[1] = t; t->setParent(fa);
+            gf->son[0] = t->son[1]; if(gf->son[0]) gf->son[0]->setParent(gf);
+            p->son[1] = t->son[0]; if(p->son[1]) p->son[1]->setParent(p);
+            t->son[0] = p, p->setParent(t);
+            t->son[1] = gf, gf->setParent(t);
+            t->setColor(BLACK), gf->setColor(RED);
+            while(root->parent()) root = root->parent();
         }
         void RL(RedBlackNode *gf){
-            RedBlackNode *p = gf->son[1], *t = p->son[0], *fa = gf->p;
-            if(fa) fa->son[0] == gf ? fa->son[0] = t : fa->son[1] = t; t->p = fa;
-            gf->son[1] = t->son[0]; if(gf->son[1]) gf->son[1]->p = gf;
-            p->son[0] = t->son[1]; if(p->son[0]) p->son[0]->p = p;
-            t->son[1] = p, p->p = t;
-            t->son[0] = gf, gf->p = t;
-            t->color = BLACK, gf->color = RED;
-            while(root->p) root = root->p;
+            SJTU_INSTRUMENT_ADD(map_rotations, 1);
+            RedBlackNode *p = gf->son[1], *t = p->son[0], *fa = gf->parent();
+            if(fa) fa->son[0] == gf ? fa->son[0] = t : fa->son[1] = t; t->setParent(fa);
+            gf->son[1] = t->son[0]; if(gf->son[1]) gf->son[1]->setParent(gf);
+            p->son[0] = t->son[1]; if(p->son[0]) p->son[0]->setParent(p);
+            t->son[1] = p, p->setParent(t);
+            t->son[0] = gf, gf->setParent(t);
+            t->setColor(BLACK), gf->setColor(RED);
+            while(root->parent()) root = root->parent();
         }
     };
     RedBlackTree Tree;
+#if SJTU_CHECKED_ITERATORS
+    size_t generation = 0; //clear 与整体赋值时加一，使此前的迭代器全部失效
+#endif
+    void BumpGeneration() {
+#if SJTU_CHECKED_ITERATORS
+        ++generation;
+#endif
+    }
 	class const_iterator;
 	class iterator {
     public:
         RedBlackNode *p;
         const map *from;
+#if SJTU_CHECKED_ITERATORS
+        size_t gen = 0; //创建时容器的代数
+#endif
         using iterator_assignable = my_true_type;
+        //迭代器是否在 clear 或整体赋值之前创建
+        bool Stale() const {
+#if SJTU_CHECKED_ITERATORS
+            return from && gen != from->generation;
+#else
+            return false;
+#endif
+        }
 	public:
 		iterator() : p(nullptr), from(nullptr){}
         iterator(RedBlackNode *tmp_p, const map *tmp_from){
             p = tmp_p;
             from = tmp_from;
+#if SJTU_CHECKED_ITERATORS
+            if(from) gen = from->generation;
+#endif
         }
-		iterator(const iterator &other) {
-			p = other.p;
-            from = other.from;
-		}
-        iterator &operator = (const iterator &other){
-            if(this == &other) return *this;
-            p = other.p;
-            from = other.from;
-            return *this;
-        }
+		iterator(const iterator &other) = default;
+        iterator &operator = (const iterator &other) = default;
 		iterator operator++(int) {
             iterator tmp(*this);
-            if(p == from->Tree.endNode || p == nullptr) throw invalid_iterator();
-            from->Tree.findNext(p);
+            ++*this;
             return tmp;
         }
 		iterator & operator++() {
-            if(p == from->Tree.endNode || p == nullptr) throw invalid_iterator();
+            if(SJTU_CHECKED_ITERATORS && (p == nullptr || p == from->Tree.endNode || Stale())) throw invalid_iterator();
             from->Tree.findNext(p);
             return *this;
         }
 		iterator operator--(int) {
             iterator tmp(*this);
-            if(*this == from->cbegin() || p == nullptr) throw invalid_iterator();
-            from->Tree.findLast(p);
+            --*this;
             return tmp;
         }
+        //begin() 没有前驱，findLast 会得到空指针，据此判断越界而不必重新找最小结点
 		iterator & operator--() {
-            if(*this == from->cbegin() || p == nullptr) throw invalid_iterator();
-            from->Tree.findLast(p);
+            if(SJTU_CHECKED_ITERATORS && (p == nullptr || Stale())) throw invalid_iterator();
+            RedBlackNode *tmp = p;
+            from->Tree.findLast(tmp);
+            if(tmp == nullptr) throw invalid_iterator();
+            p = tmp;
             return *this;
         }
 		value_type & operator*() const {
-            if(p == from->Tree.endNode || p == nullptr) throw invalid_iterator();
-            return *(p->data);
+            if(SJTU_CHECKED_ITERATORS && (p == nullptr || p == from->Tree.endNode || Stale())) throw invalid_iterator();
+            return *(p->data());
         }
 		bool operator==(const iterator &rhs) const {
             return p == rhs.p;
@@ -448,66 +697,72 @@ public:
 		bool operator!=(const const_iterator &rhs) const {
             return !(*this == rhs);
         }
-		value_type* operator->() const noexcept {
-            if(p == from->Tree.endNode || p == nullptr) throw invalid_iterator();
-            return p->data;
+		value_type* operator->() const {
+            return &**this;
         }
 	};
 	class const_iterator {
     public:
         RedBlackNode *p;
         const map *from;
+#if SJTU_CHECKED_ITERATORS
+        size_t gen = 0;
+#endif
         using iterator_assignable = my_false_type;
+        bool Stale() const {
+#if SJTU_CHECKED_ITERATORS
+            return from && gen != from->generation;
+#else
+            return false;
+#endif
+        }
     public:
         const_iterator() :p(nullptr), from(nullptr) {}
         const_iterator(RedBlackNode *tmp_p, const map *tmp_from){
             p = tmp_p;
             from = tmp_from;
+#if SJTU_CHECKED_ITERATORS
+            if(from) gen = from->generation;
+#endif
         }
         const_iterator(const iterator &other){
             p = other.p;
             from = other.from;
+#if SJTU_CHECKED_ITERATORS
+            gen = other.gen;
+#endif
         }
-        const_iterator(const const_iterator &other) {
-            p = other.p;
-            from = other.from;
-        }
+        const_iterator(const const_iterator &other) = default;
         const_iterator &operator = (const iterator &other){
-            p = other.p;
-            from = other.from;
-            return *this;
-        }
-        const_iterator &operator = (const const_iterator &other){
-            if(this == &other) return *this;
-            p = other.p;
-            from = other.from;
-            return *this;
+            return *this = const_iterator(other);
         }
+        const_iterator &operator = (const const_iterator &other) = default;
         const_iterator operator++(int) {
             const_iterator tmp(*this);
-            if(p == from->Tree.endNode || p == nullptr) throw invalid_iterator();
-            from->Tree.findNext(p);
+            ++*this;
             return tmp;
         }
         const_iterator & operator++() {
-            if(p == from->Tree.endNode || p == nullptr) throw invalid_iterator();
+            if(SJTU_CHECKED_ITERATORS && (p == nullptr || p == from->Tree.endNode || Stale())) throw invalid_iterator();
             from->Tree.findNext(p);
             return *this;
         }
         const_iterator operator--(int) {
             const_iterator tmp(*this);
-            if(*this == from->cbegin() || p == nullptr) throw invalid_iterator();
-            from->Tree.findLast(p);
+            --*this;
             return tmp;
         }
         const_iterator & operator--() {
-            if(*this == from->cbegin() || p == nullptr) throw invalid_iterator();
-            from->Tree.findLast(p);
+            if(SJTU_CHECKED_ITERATORS && (p == nullptr || Stale())) throw invalid_iterator();
+            RedBlackNode *tmp = p;
+            from->Tree.findLast(tmp);
+            if(tmp == nullptr) throw invalid_iterator();
+            p = tmp;
             return *this;
         }
         const value_type & operator*() const {
-            if(p == nullptr || p == from->Tree.endNode) throw invalid_iterator();
-            return *(p->data);
+            if(SJTU_CHECKED_ITERATORS && (p == nullptr || p == from->Tree.endNode || Stale())) throw invalid_iterator();
+            return *(p->data());
         }
         bool operator==(const iterator &rhs) const {
             return p == rhs.p;
@@ -521,9 +776,8 @@ public:
         bool operator!=(const const_iterator &rhs) const {
             return !(*this == rhs);
         }
-        const value_type* operator->() const noexcept {
-            if(p == nullptr || p == from->Tree.endNode) throw invalid_iterator();
-            return p->data;
+        const value_type* operator->() const {
+            return &**this;
         }
 	};
 	map() = default;
@@ -532,29 +786,30 @@ public:
     }
 	map & operator=(const map &other) {
         Tree = other.Tree;
+        BumpGeneration();
         return *this;
     }
 	~map() {}
 	T & at(const Key &key) {
         RedBlackNode *res = Tree.find(key);
         if(res == nullptr) throw index_out_of_bound();
-        return res->data->second;
+        return res->data()->second;
     }
 	const T & at(const Key &key) const {
         RedBlackNode *res = Tree.find(key);
         if(res == nullptr) throw index_out_of_bound();
-        return res->data->second;
+        return res->data()->second;
     }
 	T & operator[](const Key &key) {
-        RedBlackNode *res = Tree.find(key);
-        if(res == nullptr)
-            return insert(value_type(key, T())).first.p->data->second;
-        else return res->data->second;
+        return try_emplace(key).first.p->data()->second;
+    }
+	T & operator[](Key &&key) {
+        return try_emplace(static_cast<Key &&>(key)).first.p->data()->second;
     }
 	const T & operator[](const Key &key) const {
         RedBlackNode *res = Tree.find(key);
         if(res == nullptr) throw index_out_of_bound();
-        return res->data->second;
+        return res->data()->second;
     }
 	iterator begin() {
         return iterator(Tree.getMin(), this);
@@ -570,17 +825,180 @@ public:
     }
 	bool empty() const {return !Tree.size;}
 	size_t size() const {return Tree.size;}
-	void clear() {Tree.treeMakeEmpty();}
+	void clear() {
+        Tree.treeMakeEmpty();
+        BumpGeneration();
+    }
+    //在新结点中直接用 args 构造 value_type
+    template<class... Args>
+    static RedBlackNode *NewNode(Args &&...args){
+        RedBlackNode *res = CreateNode();
+        try{
+            res->construct(std::forward<Args>(args)...);
+        }catch(...){
+            DestroyNode(res);
+            throw;
+        }
+        return res;
+    }
+    //键由 key 构造，值直接在结点里用 args 构造，不经过 T 的临时对象
+    template<class K, class... Args>
+    static RedBlackNode *NewNodeFor(K &&key, Args &&...args){
+        return NewNode(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+    }
 	pair<iterator, bool> insert(const value_type &value) {
         RedBlackNode *res = Tree.find(value.first);
         if(res != nullptr) return pair<iterator, bool>(iterator(res, this), 0);
-        Tree.treeInsert(value);
-        res = Tree.find(value.first);
+        res = Tree.treeInsert(NewNode(value));
+        return pair<iterator, bool>(iterator(res, this), 1);
+    }
+	pair<iterator, bool> insert(value_type &&value) {
+        RedBlackNode *res = Tree.find(value.first);
+        if(res != nullptr) return pair<iterator, bool>(iterator(res, this), 0);
+        res = Tree.treeInsert(NewNode(std::move(value)));
+        return pair<iterator, bool>(iterator(res, this), 1);
+    }
+    /**
+     * 用 args 原地构造元素；需要先构造出键才能查找，键已存在时新结点被丢弃
+     */
+    template<class... Args>
+    pair<iterator, bool> emplace(Args &&...args) {
+        RedBlackNode *tmp = NewNode(std::forward<Args>(args)...);
+        RedBlackNode *res = Tree.find(tmp->data()->first);
+        if(res != nullptr){
+            DestroyNode(tmp);
+            return pair<iterator, bool>(iterator(res, this), 0);
+        }
+        Tree.treeInsert(tmp);
+        return pair<iterator, bool>(iterator(tmp, this), 1);
+    }
+    /**
+     * 键不存在时才用 args 构造值，键已存在时 key 和 args 都不会被移动
+     */
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        RedBlackNode *res = Tree.find(key);
+        if(res != nullptr) return pair<iterator, bool>(iterator(res, this), 0);
+        res = Tree.treeInsert(NewNodeFor(key, std::forward<Args>(args)...));
+        return pair<iterator, bool>(iterator(res, this), 1);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+        RedBlackNode *res = Tree.find(key);
+        if(res != nullptr) return pair<iterator, bool>(iterator(res, this), 0);
+        res = Tree.treeInsert(NewNodeFor(std::move(key), std::forward<Args>(args)...));
         return pair<iterator, bool>(iterator(res, this), 1);
     }
 	void erase(iterator pos) {
-        if(pos == this->end() || pos.p == nullptr || pos.from != this) throw invalid_iterator();
-        Tree.treeRemove(pos.p->data->first);
+        if(pos == this->end() || pos.p == nullptr || pos.from != this || pos.Stale()) throw invalid_iterator();
+        DestroyNode(Tree.treeRemove(pos.p->data()->first));
+    }
+    /**
+     * 结点句柄：持有一个从树中摘下的结点，可以原样插回同类型的任意 map，
+     * 转移过程中不申请、不释放内存，也不拷贝键和值。
+     */
+    class node_type {
+        friend class map;
+    private:
+        RedBlackNode *ptr = nullptr;
+        explicit node_type(RedBlackNode *p) : ptr(p) {}
+    public:
+        node_type() {}
+        node_type(node_type &&other) : ptr(other.ptr) {
+            other.ptr = nullptr;
+        }
+        node_type &operator = (node_type &&other){
+            if(this == &other) return *this;
+            DestroyNode(ptr);
+            ptr = other.ptr;
+            other.ptr = nullptr;
+            return *this;
+        }
+        node_type(const node_type &) = delete;
+        node_type &operator = (const node_type &) = delete;
+        ~node_type(){
+            DestroyNode(ptr);
+        }
+        bool empty() const {return ptr == nullptr;}
+        explicit operator bool() const {return ptr != nullptr;}
+        const Key &key() const {
+            if(!ptr) throw invalid_iterator();
+            return ptr->data()->first;
+        }
+        T &mapped() const {
+            if(!ptr) throw invalid_iterator();
+            return ptr->data()->second;
+        }
+        value_type &value() const {
+            if(!ptr) throw invalid_iterator();
+            return *(ptr->data());
+        }
+    };
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node; //插入失败时结点原样交还
+    };
+    node_type extract(iterator pos) {
+        if(pos == this->end() || pos.p == nullptr || pos.from != this || pos.Stale()) throw invalid_iterator();
+        return node_type(Tree.treeRemove(pos.p->data()->first));
+    }
+    /**
+     * 键不存在时返回空句柄
+     */
+    node_type extract(const Key &key) {
+        RedBlackNode *res = Tree.find(key);
+        if(res == nullptr) return node_type();
+        return node_type(Tree.treeRemove(key));
+    }
+    /**
+     * 插入句柄中的结点；键已存在时不插入，结点留在返回值的 node 中
+     */
+    insert_return_type insert(node_type &&nh) {
+        if(nh.empty()) return {end(), false, node_type()};
+        RedBlackNode *res = Tree.find(nh.key());
+        if(res != nullptr) return {iterator(res, this), false, static_cast<node_type &&>(nh)};
+        res = nh.ptr;
+        nh.ptr = nullptr;
+        Tree.treeInsert(res);
+        return {iterator(res, this), true, node_type()};
+    }
+    /**
+     * 把 other 中本容器没有的键连同结点一起转移过来，键已存在的元素留在 other 中
+     */
+    void merge(map &other) {
+        if(&other == this) return;
+        RedBlackNode *cur = other.Tree.getMin(), *nxt;
+        while(cur != other.Tree.endNode){
+            nxt = cur;
+            other.Tree.findNext(nxt); //摘除结点时其他结点只改变链接，nxt 依然有效
+            if(Tree.find(cur->data()->first) == nullptr)
+                Tree.treeInsert(other.Tree.treeRemove(cur->data()->first));
+            cur = nxt;
+        }
+    }
+    /**
+     * 批量查找 keys[0, n)，out[i] 为 keys[i] 对应的迭代器，找不到为 end()。
+     * 每组键交错下降，一组内的缓存缺失相互重叠，比逐个 find 少等待内存
+     */
+    void find_batch(const Key *keys, size_t n, iterator *out) {
+        RedBlackNode *res[RedBlackTree::BatchGroup];
+        for(size_t base = 0; base < n; base += RedBlackTree::BatchGroup){
+            size_t m = n - base < RedBlackTree::BatchGroup ? n - base : RedBlackTree::BatchGroup;
+            Tree.findBatch(keys + base, m, res);
+            for(size_t i = 0; i < m; ++i)
+                out[base + i] = iterator(res[i] ? res[i] : Tree.endNode, this);
+        }
+    }
+    void find_batch(const Key *keys, size_t n, const_iterator *out) const {
+        RedBlackNode *res[RedBlackTree::BatchGroup];
+        for(size_t base = 0; base < n; base += RedBlackTree::BatchGroup){
+            size_t m = n - base < RedBlackTree::BatchGroup ? n - base : RedBlackTree::BatchGroup;
+            Tree.findBatch(keys + base, m, res);
+            for(size_t i = 0; i < m; ++i)
+                out[base + i] = const_iterator(res[i] ? res[i] : Tree.endNode, this);
+        }
     }
 	size_t count(const Key &key) const {
         RedBlackNode *res = Tree.find(key);
@@ -0,0 +1,127 @@
+////sjtu::map 的二进制镜像：文件头之后是按键升序排列的 value_type 数组
+////map_image_writer 要求按键严格递增的顺序写入（例如直接遍历一棵 map），
+////mapped_map 在映射的数组上二分查找，不需要重建红黑树。
+#ifndef SJTU_MAP_IMAGE_HPP
+#define SJTU_MAP_IMAGE_HPP
+
+#include <cstddef>
+#include <new>
+#include <functional>
+#include <type_traits>
+#include "map.hpp"
+#include "mapped_file.hpp"
+
+namespace sjtu {
+
+    template<class Key, class T, class Compare = std::less<Key>>
+    class map_image_writer {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "map image requires trivially copyable key and value types");
+    public:
+        typedef pair<const Key, T> value_type;
+    private:
+        image_writer out;
+        alignas(value_type) unsigned char last[sizeof(value_type)];
+    public:
+        explicit map_image_writer(const char *path) {
+            out.header.init(MAP_IMAGE, sizeof(Key), sizeof(T), sizeof(value_type));
+            out.open(path);
+        }
+        /**
+         * 键必须严格大于上一次写入的键，否则抛出 runtime_error
+         */
+        void push(const Key &key, const T &value) {
+            const value_type *prev = reinterpret_cast<const value_type *>(last);
+            if(out.header.count && !Compare()(prev->first, key))
+                throw runtime_error();
+            //在清零的缓冲上构造，保证填充字节也是确定的
+            alignas(value_type) unsigned char raw[sizeof(value_type)] = {};
+            new(raw) value_type(key, value);
+            out.write(raw, sizeof(value_type));
+            memcpy(last, raw, sizeof(value_type));
+            out.header.count++;
+        }
+        size_t size() const {
+            return out.header.count;
+        }
+        /**
+         * 回填文件头并关闭文件，之后镜像才能被打开；未调用 finish 就析构时文件被删除
+         */
+        void finish() {
+            out.finish();
+        }
+    };
+
+    template<class Key, class T, class Compare>
+    void write_image(const map<Key, T, Compare> &m, const char *path) {
+        map_image_writer<Key, T, Compare> w(path);
+        for(typename map<Key, T, Compare>::const_iterator it = m.cbegin(); it != m.cend(); ++it)
+            w.push(it->first, it->second);
+        w.finish();
+    }
+
+    /**
+     * 只读的 map 镜像视图，按键升序遍历，查找为数组上的二分
+     */
+    template<class Key, class T, class Compare = std::less<Key>>
+    class mapped_map {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "map image requires trivially copyable key and value types");
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef const value_type *const_iterator;
+    private:
+        mapped_file file;
+        const value_type *array = nullptr;
+        size_t num = 0;
+    public:
+        mapped_map() {}
+        explicit mapped_map(const char *path) {
+            open(path);
+        }
+        void open(const char *path) {
+            file.open(path);
+            const image_header &h = file.header(MAP_IMAGE, sizeof(Key), sizeof(T), sizeof(value_type), alignof(value_type));
+            array = reinterpret_cast<const value_type *>(file.data() + h.data_offset);
+            num = h.count;
+        }
+        /**
+         * 第一个不小于 key 的元素；不存在时返回 cend()
+         */
+        const_iterator lower_bound(const Key &key) const {
+            const value_type *base = array;
+            size_t len = num;
+            //分支少的二分：每轮只根据比较结果移动 base
+            while(len > 1){
+                size_t half = len >> 1;
+                base = Compare()(base[half - 1].first, key) ? base + half : base;
+                len -= half;
+            }
+            if(len && Compare()(base->first, key)) ++base;
+            return base;
+        }
+        /**
+         * 查到返回指向元素的指针，否则返回 nullptr
+         */
+        const value_type *find(const Key &key) const {
+            const value_type *res = lower_bound(key);
+            if(res == cend() || Compare()(key, res->first)) return nullptr;
+            return res;
+        }
+        const T & at(const Key &key) const {
+            const value_type *res = find(key);
+            if(!res) throw index_out_of_bound();
+            return res->second;
+        }
+        size_t count(const Key &key) const {
+            return find(key) ? 1 : 0;
+        }
+        const_iterator cbegin() const { return array; }
+        const_iterator cend() const { return array + num; }
+        bool empty() const { return !num; }
+        size_t size() const { return num; }
+    };
+
+}
+
+#endif
@@ -0,0 +1,374 @@
+////sjtu::map 上基于 join 的并行批量算法，线程池见 thread_pool.hpp
+////join(L, k, R) 把键都小于 k 的树 L、结点 k、键都大于 k 的树 R 接成一棵红黑树，只沿较高一棵的边界下降，
+////代价为两棵树黑高之差；split 沿一条路径把树按键切成两半，途中用 join 重新拼接。
+////并 / 交 / 差都是「按一棵树的根切开另一棵，两侧递归，再 join 回来」，两侧递归互不相交，交给线程池并行。
+////所有算法直接改写结点之间的链接，元素既不拷贝也不移动；与 clear 一样，结束后被改写的容器代数加一，
+////开启迭代器检查时此前的迭代器都视为失效。
+////不传线程池的重载使用 thread_pool::global()。
+#ifndef SJTU_MAP_PARALLEL_HPP
+#define SJTU_MAP_PARALLEL_HPP
+
+#include <cstddef>
+#include <atomic>
+#include "map.hpp"
+#include "thread_pool.hpp"
+
+namespace sjtu {
+
+    namespace map_parallel_detail {
+        const size_t Grain = 1 << 14; //元素总数少于该值时整棵树串行处理
+
+        //递归到这一深度之前两侧分别作为任务提交，约为线程数的 8 倍个任务
+        inline int ForkDepth(thread_pool &pool, size_t n) {
+            if(n < Grain) return 0;
+            int d = 3;
+            for(size_t t = 1; t < pool.size(); t <<= 1) ++d;
+            return d;
+        }
+
+        template<class F, class G>
+        void Fork(thread_pool &pool, bool parallel, F &f, G &g) {
+            if(!parallel){
+                f();
+                g();
+                return;
+            }
+            pool.run(2, [&](size_t i){ i ? g() : f(); });
+        }
+
+        template<class Key, class T, class Compare>
+        struct Join {
+            typedef map<Key, T, Compare> Map;
+            typedef typename Map::RedBlackNode Node;
+
+            static bool IsRed(const Node *t) {return t && t->color() == Map::RED;}
+            static const Key &KeyOf(const Node *t) {return t->data()->first;}
+            static void Link(Node *p, int d, Node *c) {
+                p->son[d] = c;
+                if(c) c->setParent(p);
+            }
+            //黑高：从 t 到叶子路径上黑结点的个数（含 t 本身）。只在算法入口算一次，递归中由父结点推出
+            static size_t BlackHeight(const Node *t) {
+                size_t h = 0;
+                for(; t; t = t->son[0])
+                    if(!IsRed(t)) ++h;
+                return h;
+            }
+            //t 的儿子的黑高
+            static size_t SonHeight(const Node *t, size_t h) {
+                return IsRed(t) ? h : h - 1;
+            }
+            //t 的 !d 侧儿子转上来，t 转到它的 d 侧；新子树根的父指针由调用者连接
+            static Node *Rotate(Node *t, int d) {
+                Node *s = t->son[!d];
+                Link(t, !d, s->son[d]);
+                Link(s, d, t);
+                return s;
+            }
+            static size_t Free(Node *t) {
+                if(!t) return 0;
+                size_t n = 1 + Free(t->son[0]) + Free(t->son[1]);
+                Map::DestroyNode(t);
+                return n;
+            }
+            //big 比 small 高（根都为黑）：沿 big 靠近 small 的 d 侧边界下降到黑高相等的黑结点，
+            //在那里挂上红色的 k，回溯时若出现红红相连就旋转一次
+            static Node *JoinSide(Node *big, size_t hb, Node *k, Node *small, size_t hs, int d) {
+                if(!IsRed(big) && hb == hs){
+                    Link(k, !d, big);
+                    Link(k, d, small);
+                    k->setColor(Map::RED);
+                    return k;
+                }
+                Node *c = JoinSide(big->son[d], hb - (IsRed(big) ? 0 : 1), k, small, hs, d);
+                Link(big, d, c);
+                if(!IsRed(big) && IsRed(c) && IsRed(c->son[d])){
+                    c->son[d]->setColor(Map::BLACK);
+                    return Rotate(big, !d);
+                }
+                return big;
+            }
+            //l 的键都小于 k，r 的键都大于 k，hl、hr 为它们的黑高，结果的黑高存入 h；l、r 的父指针可以是旧值
+            static Node *DoJoin(Node *l, size_t hl, Node *k, Node *r, size_t hr, size_t &h) {
+                if(IsRed(l)){
+                    l->setColor(Map::BLACK);
+                    ++hl;
+                }
+                if(IsRed(r)){
+                    r->setColor(Map::BLACK);
+                    ++hr;
+                }
+                h = hl > hr ? hl : hr; //JoinSide 不改变较高一棵的黑高
+                Node *res;
+                if(hl > hr) res = JoinSide(l, hl, k, r, hr, 1);
+                else if(hr > hl) res = JoinSide(r, hr, k, l, hl, 0);
+                else{
+                    Link(k, 0, l);
+                    Link(k, 1, r);
+                    k->setColor(Map::RED);
+                    res = k;
+                }
+                if(IsRed(res) && (IsRed(res->son[0]) || IsRed(res->son[1]))){
+                    res->setColor(Map::BLACK);
+                    ++h;
+                }
+                res->setParent(nullptr);
+                return res;
+            }
+            //摘下黑高为 ht 的 t 中的最大结点 last，返回其余部分，其黑高存入 h
+            static Node *SplitLast(Node *t, size_t ht, Node *&last, size_t &h) {
+                size_t hs = SonHeight(t, ht);
+                if(!t->son[1]){
+                    last = t;
+                    h = hs;
+                    return t->son[0];
+                }
+                size_t hr;
+                Node *r = SplitLast(t->son[1], hs, last, hr);
+                return DoJoin(t->son[0], hs, t, r, hr, h);
+            }
+            //没有中间结点的 join：借 l 的最大结点作为 k
+            static Node *Join2(Node *l, size_t hl, Node *r, size_t hr, size_t &h) {
+                if(!l){
+                    h = hr;
+                    return r;
+                }
+                Node *k;
+                size_t hrest;
+                Node *rest = SplitLast(l, hl, k, hrest);
+                return DoJoin(rest, hrest, k, r, hr, h);
+            }
+            //按 key 把黑高为 ht 的 t 切成 l（键小于 key）、m（键等于 key 的结点或空）、r（键大于 key），
+            //hl、hr 为切出两棵树的黑高。黑高随递归向下传递，每次 join 只花两棵树黑高之差，整次切分 O(log n)
+            static void Split(Node *t, size_t ht, const Key &key, Node *&l, size_t &hl, Node *&m, Node *&r, size_t &hr) {
+                if(!t){
+                    l = m = r = nullptr;
+                    hl = hr = 0;
+                    return;
+                }
+                Node *tl = t->son[0], *tr = t->son[1];
+                size_t hs = SonHeight(t, ht);
+                if(Compare()(key, KeyOf(t))){
+                    Node *rl;
+                    size_t hrl;
+                    Split(tl, hs, key, l, hl, m, rl, hrl);
+                    r = DoJoin(rl, hrl, t, tr, hs, hr);
+                }
+                else if(Compare()(KeyOf(t), key)){
+                    Node *lr;
+                    size_t hlr;
+                    Split(tr, hs, key, lr, hlr, m, r, hr);
+                    l = DoJoin(tl, hs, t, lr, hlr, hl);
+                }
+                else{
+                    l = tl;
+                    m = t;
+                    r = tr;
+                    hl = hr = hs;
+                }
+            }
+            //有序序列 [l, r) 取中点建成完全平衡的子树：前 red 层（满层）为黑，最后不满的一层为红
+            template<class RandomIt>
+            static Node *Build(thread_pool &pool, int fork, RandomIt first, size_t l, size_t r, size_t depth, size_t red) {
+                if(l >= r) return nullptr;
+                size_t mid = l + (r - l) / 2;
+                Node *t = Map::NewNode(*(first + mid));
+                Node *x = nullptr, *y = nullptr;
+                auto left = [&]{ x = Build(pool, fork - 1, first, l, mid, depth + 1, red); };
+                auto right = [&]{ y = Build(pool, fork - 1, first, mid + 1, r, depth + 1, red); };
+                try{
+                    Fork(pool, fork > 0, left, right);
+                }catch(...){
+                    Free(x);
+                    Free(y);
+                    Map::DestroyNode(t);
+                    throw;
+                }
+                Link(t, 0, x);
+                Link(t, 1, y);
+                t->setColor(depth >= red ? Map::RED : Map::BLACK);
+                return t;
+            }
+            //键重复时保留 a 中的结点，b 中的结点释放并计入 dup；ha、hb 为黑高，结果的黑高存入 h
+            static Node *Union(thread_pool &pool, int fork, Node *a, size_t ha, Node *b, size_t hb, size_t &h, size_t &dup) {
+                if(!a){
+                    h = hb;
+                    return b;
+                }
+                if(!b){
+                    h = ha;
+                    return a;
+                }
+                Node *l, *m, *r, *x, *y;
+                size_t hl, hr, hx, hy;
+                Split(b, hb, KeyOf(a), l, hl, m, r, hr);
+                if(m){
+                    Map::DestroyNode(m);
+                    ++dup;
+                }
+                Node *al = a->son[0], *ar = a->son[1];
+                size_t hs = SonHeight(a, ha), d1 = 0, d2 = 0;
+                auto left = [&]{ x = Union(pool, fork - 1, al, hs, l, hl, hx, d1); };
+                auto right = [&]{ y = Union(pool, fork - 1, ar, hs, r, hr, hy, d2); };
+                Fork(pool, fork > 0, left, right);
+                dup += d1 + d2;
+                return DoJoin(x, hx, a, y, hy, h);
+            }
+            //沿 b 的结构切开 a；b 只读
+            static Node *Intersect(thread_pool &pool, int fork, Node *a, size_t ha, const Node *b, size_t &h, size_t &removed) {
+                h = 0;
+                if(!a) return nullptr;
+                if(!b){
+                    removed += Free(a);
+                    return nullptr;
+                }
+                Node *l, *m, *r, *x, *y;
+                size_t hl, hr, hx, hy;
+                Split(a, ha, KeyOf(b), l, hl, m, r, hr);
+                size_t r1 = 0, r2 = 0;
+                auto left = [&]{ x = Intersect(pool, fork - 1, l, hl, b->son[0], hx, r1); };
+                auto right = [&]{ y = Intersect(pool, fork - 1, r, hr, b->son[1], hy, r2); };
+                Fork(pool, fork > 0, left, right);
+                removed += r1 + r2;
+                return m ? DoJoin(x, hx, m, y, hy, h) : Join2(x, hx, y, hy, h);
+            }
+            static Node *Difference(thread_pool &pool, int fork, Node *a, size_t ha, const Node *b, size_t &h, size_t &removed) {
+                h = ha;
+                if(!a || !b) return a;
+                Node *l, *m, *r, *x, *y;
+                size_t hl, hr, hx, hy;
+                Split(a, ha, KeyOf(b), l, hl, m, r, hr);
+                if(m){
+                    Map::DestroyNode(m);
+                    ++removed;
+                }
+                size_t r1 = 0, r2 = 0;
+                auto left = [&]{ x = Difference(pool, fork - 1, l, hl, b->son[0], hx, r1); };
+                auto right = [&]{ y = Difference(pool, fork - 1, r, hr, b->son[1], hy, r2); };
+                Fork(pool, fork > 0, left, right);
+                removed += r1 + r2;
+                return Join2(x, hx, y, hy, h);
+            }
+            template<class F>
+            static void InOrder(Node *t, F &f) {
+                if(!t) return;
+                InOrder(t->son[0], f);
+                f(*t->data());
+                InOrder(t->son[1], f);
+            }
+            template<class F>
+            static void ForEach(thread_pool &pool, int fork, Node *t, F &f) {
+                if(!t) return;
+                if(fork <= 0){
+                    InOrder(t, f);
+                    return;
+                }
+                f(*t->data());
+                auto left = [&]{ ForEach(pool, fork - 1, t->son[0], f); };
+                auto right = [&]{ ForEach(pool, fork - 1, t->son[1], f); };
+                Fork(pool, true, left, right);
+            }
+        };
+    }
+
+    /**
+     * 用按键严格递增的 [first, last) 重建 m，元素为可构造 value_type 的 pair；
+     * 不是严格递增时抛出 runtime_error，m 保持不变
+     */
+    template<class Key, class T, class Compare, class RandomIt>
+    void parallel_build(thread_pool &pool, map<Key, T, Compare> &m, RandomIt first, RandomIt last) {
+        typedef map_parallel_detail::Join<Key, T, Compare> J;
+        using map_parallel_detail::Grain;
+        size_t n = last - first, blocks = (n + Grain - 1) / Grain;
+        std::atomic<bool> sorted{true};
+        pool.run(blocks, [&](size_t b){
+            size_t hi = (b + 1) * Grain < n ? (b + 1) * Grain : n;
+            for(size_t i = b ? b * Grain : 1; i < hi && sorted.load(std::memory_order_relaxed); ++i)
+                if(!Compare()((first + (i - 1))->first, (first + i)->first)) sorted.store(false, std::memory_order_relaxed);
+        });
+        if(!sorted.load()) throw runtime_error();
+        size_t red = 0; //满层的层数 floor(log2(n + 1))
+        while(((size_t) 2 << red) - 1 <= n) ++red;
+        typename J::Node *t = J::Build(pool, map_parallel_detail::ForkDepth(pool, n), first, 0, n, 0, red);
+        m.clear();
+        m.Tree.adopt(t, n);
+    }
+    /**
+     * a = a ∪ b，键相同时保留 a 的元素；b 的结点直接并入 a，b 变为空
+     */
+    template<class Key, class T, class Compare>
+    void parallel_union(thread_pool &pool, map<Key, T, Compare> &a, map<Key, T, Compare> &b) {
+        typedef map_parallel_detail::Join<Key, T, Compare> J;
+        if(&a == &b) return;
+        size_t n = a.size() + b.size(), dup = 0, h;
+        int fork = map_parallel_detail::ForkDepth(pool, n);
+        typename J::Node *ra = a.Tree.release(), *rb = b.Tree.release();
+        typename J::Node *res = J::Union(pool, fork, ra, J::BlackHeight(ra), rb, J::BlackHeight(rb), h, dup);
+        a.Tree.adopt(res, n - dup);
+        a.BumpGeneration();
+        b.BumpGeneration();
+    }
+    /**
+     * a = a ∩ b，b 不变
+     */
+    template<class Key, class T, class Compare>
+    void parallel_intersection(thread_pool &pool, map<Key, T, Compare> &a, const map<Key, T, Compare> &b) {
+        typedef map_parallel_detail::Join<Key, T, Compare> J;
+        if(&a == &b) return;
+        size_t n = a.size(), removed = 0, h;
+        int fork = map_parallel_detail::ForkDepth(pool, n + b.size());
+        typename J::Node *ra = a.Tree.release();
+        typename J::Node *res = J::Intersect(pool, fork, ra, J::BlackHeight(ra), b.Tree.getRoot(), h, removed);
+        a.Tree.adopt(res, n - removed);
+        a.BumpGeneration();
+    }
+    /**
+     * a = a \ b，b 不变
+     */
+    template<class Key, class T, class Compare>
+    void parallel_difference(thread_pool &pool, map<Key, T, Compare> &a, const map<Key, T, Compare> &b) {
+        typedef map_parallel_detail::Join<Key, T, Compare> J;
+        if(&a == &b){
+            a.clear();
+            return;
+        }
+        size_t n = a.size(), removed = 0, h;
+        int fork = map_parallel_detail::ForkDepth(pool, n + b.size());
+        typename J::Node *ra = a.Tree.release();
+        typename J::Node *res = J::Difference(pool, fork, ra, J::BlackHeight(ra), b.Tree.getRoot(), h, removed);
+        a.Tree.adopt(res, n - removed);
+        a.BumpGeneration();
+    }
+    /**
+     * 对每个元素调用 f(value_type &)，各子树并行，调用顺序不确定
+     */
+    template<class Key, class T, class Compare, class F>
+    void parallel_for_each(thread_pool &pool, map<Key, T, Compare> &m, F f) {
+        typedef map_parallel_detail::Join<Key, T, Compare> J;
+        J::ForEach(pool, map_parallel_detail::ForkDepth(pool, m.size()), m.Tree.getRoot(), f);
+    }
+
+    template<class Key, class T, class Compare, class RandomIt>
+    void parallel_build(map<Key, T, Compare> &m, RandomIt first, RandomIt last) {
+        parallel_build(thread_pool::global(), m, first, last);
+    }
+    template<class Key, class T, class Compare>
+    void parallel_union(map<Key, T, Compare> &a, map<Key, T, Compare> &b) {
+        parallel_union(thread_pool::global(), a, b);
+    }
+    template<class Key, class T, class Compare>
+    void parallel_intersection(map<Key, T, Compare> &a, const map<Key, T, Compare> &b) {
+        parallel_intersection(thread_pool::global(), a, b);
+    }
+    template<class Key, class T, class Compare>
+    void parallel_difference(map<Key, T, Compare> &a, const map<Key, T, Compare> &b) {
+        parallel_difference(thread_pool::global(), a, b);
+    }
+    template<class Key, class T, class Compare, class F>
+    void parallel_for_each(map<Key, T, Compare> &m, F f) {
+        parallel_for_each(thread_pool::global(), m, f);
+    }
+
+}
+
+#endif
@@ -0,0 +1,599 @@
+////纯自顶向下的红黑树 map，接口与 sjtu::map 相同（含 emplace / try_emplace、结点句柄、find_batch）
+////结点没有父指针：插入在下降途中分裂 4-结点并就地旋转，删除在下降途中把红色推到要删的位置，
+////两者都只沿一条路径向下走一遍，不需要回溯，也不需要旋转后沿父指针找回根。
+////迭代器只记当前结点：有右（左）子树时 ++（--）在子树内下降，否则从根按当前键重新下降找后继（前驱），O(log n)。
+////元素始终留在自己的结点里，插入、删除都不会使指向其他元素的迭代器失效，与 sjtu::map 一致。
+#ifndef SJTU_TOPDOWN_MAP_HPP
+#define SJTU_TOPDOWN_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+template<
+	class Key,
+	class T,
+	class Compare = std::less<Key>
+> class topdown_map {
+public:
+	typedef pair<const Key, T> value_type;
+private:
+    struct Node{
+        Node *son[2];
+        bool red;
+        alignas(value_type) unsigned char buf[sizeof(value_type)];
+        value_type *data() {return reinterpret_cast<value_type *>(buf);}
+        const Key &key() const {return reinterpret_cast<const value_type *>(buf)->first;}
+    };
+    //红黑树高度不超过 2log(n+1)，结点至少 32 字节，96 层足以容纳地址空间能放下的任何树
+    static const int MaxHeight = 96;
+
+    Node *root;
+    size_t num;
+
+    static bool Less(const Key &a, const Key &b) {return Compare()(a, b);}
+    static bool IsRed(const Node *t) {return t && t->red;}
+    //以 t 为根向 dir 方向单旋，返回新的子树根
+    static Node *Rotate(Node *t, int dir){
+        Node *s = t->son[!dir];
+        t->son[!dir] = s->son[dir];
+        s->son[dir] = t;
+        t->red = true;
+        s->red = false;
+        return s;
+    }
+    static Node *RotateTwice(Node *t, int dir){
+        t->son[!dir] = Rotate(t->son[!dir], !dir);
+        return Rotate(t, dir);
+    }
+    template<class... Args>
+    static Node *NewNode(Args &&...args){
+        Node *res = new Node;
+        try{
+            new (res->buf) value_type(std::forward<Args>(args)...);
+        }catch(...){
+            delete res;
+            throw;
+        }
+        res->son[0] = res->son[1] = nullptr;
+        res->red = true;
+        return res;
+    }
+    //结点作为新叶子挂入树前的状态
+    static Node *Detached(Node *t){
+        t->son[0] = t->son[1] = nullptr;
+        t->red = true;
+        return t;
+    }
+    //把子树按中序串成经由 son[1] 相连的链表，返回表头
+    static Node *Flatten(Node *t){
+        Node *stack[MaxHeight], *head = nullptr, **tail = &head;
+        int depth = 0;
+        while(t || depth){
+            while(t){
+                stack[depth++] = t;
+                t = t->son[0];
+            }
+            t = stack[--depth];
+            Node *r = t->son[1]; //先取出右儿子，下一步才会覆盖 son[1]
+            *tail = t;
+            tail = &t->son[1];
+            t = r;
+        }
+        *tail = nullptr;
+        return head;
+    }
+    static void Prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p);
+#else
+        (void) p;
+#endif
+    }
+    static const size_t BatchGroup = 16; //find_batch 一次最多同时下降的键数
+    static void DelNode(Node *t){
+        t->data()->~value_type();
+        delete t;
+    }
+    static void Free(Node *t){
+        if(!t) return;
+        Free(t->son[0]);
+        Free(t->son[1]);
+        DelNode(t);
+    }
+    static Node *Clone(const Node *t){
+        if(!t) return nullptr;
+        Node *res = NewNode(*reinterpret_cast<const value_type *>(t->buf));
+        res->red = t->red;
+        try{
+            res->son[0] = Clone(t->son[0]);
+            res->son[1] = Clone(t->son[1]);
+        }catch(...){
+            Free(res);
+            throw;
+        }
+        return res;
+    }
+    Node *FindNode(const Key &key) const {
+        Node *t = root;
+        while(t){
+            if(Less(key, t->key())) t = t->son[0];
+            else if(Less(t->key(), key)) t = t->son[1];
+            else break;
+        }
+        return t;
+    }
+    //子树 t 中的最小 / 最大结点（dir 为 0 / 1）
+    static Node *Extreme(Node *t, int dir){
+        if(t) while(t->son[dir]) t = t->son[dir];
+        return t;
+    }
+    //中序后继：有右子树就取右子树的最小结点，否则从根按键下降，最后一次向左拐的结点即后继；没有后继返回 nullptr
+    Node *Next(const Node *t) const {
+        if(t->son[1]) return Extreme(t->son[1], 0);
+        Node *res = nullptr;
+        for(Node *q = root; q; ){
+            if(Less(t->key(), q->key())) res = q, q = q->son[0];
+            else q = q->son[1];
+        }
+        return res;
+    }
+    //中序前驱，t 为 nullptr（end）时取最大结点；没有前驱返回 nullptr
+    Node *Prev(const Node *t) const {
+        if(!t) return Extreme(root, 1);
+        if(t->son[0]) return Extreme(t->son[0], 1);
+        Node *res = nullptr;
+        for(Node *q = root; q; ){
+            if(Less(q->key(), t->key())) res = q, q = q->son[1];
+            else q = q->son[0];
+        }
+        return res;
+    }
+    /**
+     * 自顶向下插入：下降途中遇到两个红儿子就做颜色翻转，翻转造成的红红冲突
+     * 用记录的曾祖父 / 祖父 / 父结点就地旋转消除。键不存在时调用 make() 得到新结点挂在空位上，
+     * make 只在最后一次比较之后调用，因此可以从 key 移动构造。返回键所在的结点，inserted 表示是否新建
+     */
+    template<class Make>
+    Node *Insert(const Key &key, bool &inserted, Make make){
+        inserted = false;
+        if(!root){
+            root = make();
+            root->red = false;
+            num++;
+            inserted = true;
+            return root;
+        }
+        Node head; //伪根，head.son[1] 指向真正的根，根处的旋转也能统一处理
+        head.son[0] = nullptr;
+        head.son[1] = root;
+        head.red = false;
+        Node *gg = &head, *g = nullptr, *p = nullptr, *q = root, *res = nullptr;
+        int dir = 0, last = 0;
+        while(true){
+            if(!q){
+                p->son[dir] = q = res = make();
+                num++;
+                inserted = true;
+            }
+            else if(IsRed(q->son[0]) && IsRed(q->son[1])){
+                q->red = true;
+                q->son[0]->red = q->son[1]->red = false;
+            }
+            if(IsRed(q) && IsRed(p)){
+                int dir2 = gg->son[1] == g;
+                gg->son[dir2] = (q == p->son[last] ? Rotate(g, !last) : RotateTwice(g, !last));
+            }
+            if(res) break;
+            last = dir;
+            dir = Less(q->key(), key);
+            if(!dir && !Less(key, q->key())){
+                res = q;
+                break;
+            }
+            if(g) gg = g;
+            g = p, p = q;
+            q = q->son[dir];
+        }
+        root = head.son[1];
+        root->red = false;
+        return res;
+    }
+    /**
+     * 自顶向下删除：下降途中保证当前结点或其下一步的儿子为红，最终摘下的结点必为红色叶子或单支结点。
+     * 找到目标 f 后继续走到它的前驱 q，摘下 q 并让它顶替 f 的位置与颜色，元素本身不移动。
+     * fp 跟踪 f 的父结点：只有 f 自己被旋转下去时它才会改变。
+     * 返回摘下的结点（不释放），键不存在时返回 nullptr
+     */
+    Node *Remove(const Key &key){
+        if(!root) return nullptr;
+        Node head;
+        head.son[0] = nullptr;
+        head.son[1] = root;
+        head.red = false;
+        Node *g = nullptr, *p = nullptr, *q = &head, *f = nullptr, *fp = nullptr;
+        int dir = 1;
+        while(q->son[dir]){
+            int last = dir;
+            g = p, p = q;
+            q = q->son[dir];
+            dir = Less(q->key(), key);
+            if(!f && !dir && !Less(key, q->key())) f = q, fp = p;
+            if(!IsRed(q) && !IsRed(q->son[dir])){
+                if(IsRed(q->son[!dir])){
+                    p = p->son[last] = Rotate(q, dir);
+                    if(q == f) fp = p;
+                }
+                else{
+                    Node *s = p->son[!last];
+                    if(s){
+                        if(!IsRed(s->son[0]) && !IsRed(s->son[1])){
+                            p->red = false;
+                            s->red = q->red = true;
+                        }
+                        else{
+                            int dir2 = g->son[1] == p;
+                            g->son[dir2] = (IsRed(s->son[last]) ? RotateTwice(p, last) : Rotate(p, last));
+                            g->son[dir2]->red = q->red = true;
+                            g->son[dir2]->son[0]->red = g->son[dir2]->son[1]->red = false;
+                            if(p == f) fp = g->son[dir2];
+                        }
+                    }
+                }
+            }
+        }
+        if(f){
+            p->son[p->son[1] == q] = q->son[q->son[0] == nullptr];
+            if(q != f){
+                q->son[0] = f->son[0];
+                q->son[1] = f->son[1];
+                q->red = f->red;
+                fp->son[fp->son[1] == f] = q;
+            }
+            num--;
+        }
+        root = head.son[1];
+        if(root) root->red = false;
+        return f;
+    }
+    //键由 key 构造，值直接在结点里用 args 构造
+    template<class K, class... Args>
+    static Node *NewNodeFor(K &&key, Args &&...args){
+        return NewNode(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    //把 keys[0, n)（n 不超过 BatchGroup）的查找结果写进 out[0, n)，每轮所有未结束的键各走一层
+    template<class Iter>
+    void FindBatch(const Key *keys, size_t n, Iter *out) const {
+        Node *cur[BatchGroup];
+        size_t active = 0;
+        for(size_t i = 0; i < n; ++i){
+            out[i] = Iter(nullptr, this);
+            cur[i] = root;
+            if(root) active++;
+        }
+        while(active){
+            for(size_t i = 0; i < n; ++i)
+                if(cur[i]) Prefetch(cur[i]->buf);
+            for(size_t i = 0; i < n; ++i){
+                Node *t = cur[i];
+                if(!t) continue;
+                if(Less(keys[i], t->key())) t = t->son[0];
+                else if(Less(t->key(), keys[i])) t = t->son[1];
+                else{
+                    out[i].p = t;
+                    cur[i] = nullptr;
+                    active--;
+                    continue;
+                }
+                if(t) Prefetch(t);
+                else active--; //找不到，保持 end()
+                cur[i] = t;
+            }
+        }
+    }
+
+public:
+	class const_iterator;
+	class iterator {
+    public:
+        Node *p; //nullptr 表示 end()
+        const topdown_map *from;
+	public:
+		iterator() : p(nullptr), from(nullptr){}
+        iterator(Node *tmp_p, const topdown_map *tmp_from) : p(tmp_p), from(tmp_from){}
+		iterator operator++(int) {
+            iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+		iterator & operator++() {
+            if(from == nullptr || p == nullptr) throw invalid_iterator();
+            p = from->Next(p);
+            return *this;
+        }
+		iterator operator--(int) {
+            iterator tmp(*this);
+            --*this;
+            return tmp;
+        }
+		iterator & operator--() {
+            if(from == nullptr) throw invalid_iterator();
+            Node *tmp = from->Prev(p);
+            if(tmp == nullptr) throw invalid_iterator();
+            p = tmp;
+            return *this;
+        }
+		value_type & operator*() const {
+            if(from == nullptr || p == nullptr) throw invalid_iterator();
+            return *p->data();
+        }
+		bool operator==(const iterator &rhs) const {
+            return from == rhs.from && p == rhs.p;
+        }
+		bool operator==(const const_iterator &rhs) const {
+            return from == rhs.from && p == rhs.p;
+        }
+		bool operator!=(const iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		value_type* operator->() const {
+            return &**this;
+        }
+	};
+	class const_iterator {
+    public:
+        Node *p;
+        const topdown_map *from;
+	public:
+		const_iterator() : p(nullptr), from(nullptr){}
+        const_iterator(Node *tmp_p, const topdown_map *tmp_from) : p(tmp_p), from(tmp_from){}
+		const_iterator(const iterator &other) : p(other.p), from(other.from){}
+		const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+		const_iterator & operator++() {
+            if(from == nullptr || p == nullptr) throw invalid_iterator();
+            p = from->Next(p);
+            return *this;
+        }
+		const_iterator operator--(int) {
+            const_iterator tmp(*this);
+            --*this;
+            return tmp;
+        }
+		const_iterator & operator--() {
+            if(from == nullptr) throw invalid_iterator();
+            Node *tmp = from->Prev(p);
+            if(tmp == nullptr) throw invalid_iterator();
+            p = tmp;
+            return *this;
+        }
+		const value_type & operator*() const {
+            if(from == nullptr || p == nullptr) throw invalid_iterator();
+            return *p->data();
+        }
+		bool operator==(const iterator &rhs) const {
+            return from == rhs.from && p == rhs.p;
+        }
+		bool operator==(const const_iterator &rhs) const {
+            return from == rhs.from && p == rhs.p;
+        }
+		bool operator!=(const iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+		const value_type* operator->() const {
+            return &**this;
+        }
+	};
+	topdown_map() : root(nullptr), num(0) {}
+	topdown_map(const topdown_map &other) : root(Clone(other.root)), num(other.num) {}
+	topdown_map & operator=(const topdown_map &other) {
+        if(this == &other) return *this;
+        Node *tmp = Clone(other.root);
+        Free(root);
+        root = tmp;
+        num = other.num;
+        return *this;
+    }
+	~topdown_map() {Free(root);}
+	T & at(const Key &key) {
+        Node *res = FindNode(key);
+        if(res == nullptr) throw index_out_of_bound();
+        return res->data()->second;
+    }
+	const T & at(const Key &key) const {
+        Node *res = FindNode(key);
+        if(res == nullptr) throw index_out_of_bound();
+        return res->data()->second;
+    }
+    //不需要迭代器，一次下降完成；只在键不存在时构造 T
+	T & operator[](const Key &key) {
+        bool inserted;
+        return Insert(key, inserted, [&]{return NewNodeFor(key);})->data()->second;
+    }
+	T & operator[](Key &&key) {
+        bool inserted;
+        return Insert(key, inserted, [&]{return NewNodeFor(std::move(key));})->data()->second;
+    }
+	const T & operator[](const Key &key) const {
+        return at(key);
+    }
+	iterator begin() {return iterator(Extreme(root, 0), this);}
+	const_iterator cbegin() const {return const_iterator(Extreme(root, 0), this);}
+	iterator end() {return iterator(nullptr, this);}
+	const_iterator cend() const {return const_iterator(nullptr, this);}
+	bool empty() const {return !num;}
+	size_t size() const {return num;}
+	void clear() {
+        Free(root);
+        root = nullptr;
+        num = 0;
+    }
+    /**
+     * 返回的迭代器直接指向插入时那一次下降找到或挂上的结点
+     */
+	pair<iterator, bool> insert(const value_type &value) {
+        bool inserted;
+        Node *res = Insert(value.first, inserted, [&]{return NewNode(value);});
+        return pair<iterator, bool>(iterator(res, this), inserted);
+    }
+	pair<iterator, bool> insert(value_type &&value) {
+        bool inserted;
+        Node *res = Insert(value.first, inserted, [&]{return NewNode(std::move(value));});
+        return pair<iterator, bool>(iterator(res, this), inserted);
+    }
+    /**
+     * 用 args 原地构造元素；需要先构造出键才能查找，键已存在时新结点被丢弃
+     */
+    template<class... Args>
+    pair<iterator, bool> emplace(Args &&...args) {
+        Node *tmp = NewNode(std::forward<Args>(args)...);
+        bool inserted;
+        Node *res = Insert(tmp->key(), inserted, [tmp]{return tmp;});
+        if(!inserted) DelNode(tmp);
+        return pair<iterator, bool>(iterator(res, this), inserted);
+    }
+    /**
+     * 只在下降到空位时才构造结点，值直接用 args 原地构造；键已存在时 key 和 args 都不会被移动
+     */
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        bool inserted;
+        Node *res = Insert(key, inserted, [&]{return NewNodeFor(key, std::forward<Args>(args)...);});
+        return pair<iterator, bool>(iterator(res, this), inserted);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+        bool inserted;
+        Node *res = Insert(key, inserted, [&]{return NewNodeFor(std::move(key), std::forward<Args>(args)...);});
+        return pair<iterator, bool>(iterator(res, this), inserted);
+    }
+	void erase(iterator pos) {
+        if(pos.from != this || pos.p == nullptr) throw invalid_iterator();
+        DelNode(Remove(pos.p->key()));
+    }
+    /**
+     * 结点句柄：持有一个从树中摘下的结点，可以原样插回同类型的任意 topdown_map，
+     * 转移过程中不申请、不释放内存，也不拷贝键和值。
+     */
+    class node_type {
+        friend class topdown_map;
+    private:
+        Node *ptr = nullptr;
+        explicit node_type(Node *p) : ptr(p) {}
+    public:
+        node_type() {}
+        node_type(node_type &&other) : ptr(other.ptr) {
+            other.ptr = nullptr;
+        }
+        node_type &operator = (node_type &&other){
+            if(this == &other) return *this;
+            if(ptr) DelNode(ptr);
+            ptr = other.ptr;
+            other.ptr = nullptr;
+            return *this;
+        }
+        node_type(const node_type &) = delete;
+        node_type &operator = (const node_type &) = delete;
+        ~node_type(){
+            if(ptr) DelNode(ptr);
+        }
+        bool empty() const {return ptr == nullptr;}
+        explicit operator bool() const {return ptr != nullptr;}
+        const Key &key() const {
+            if(!ptr) throw invalid_iterator();
+            return ptr->key();
+        }
+        T &mapped() const {
+            if(!ptr) throw invalid_iterator();
+            return ptr->data()->second;
+        }
+        value_type &value() const {
+            if(!ptr) throw invalid_iterator();
+            return *(ptr->data());
+        }
+    };
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node; //插入失败时结点原样交还
+    };
+    node_type extract(iterator pos) {
+        if(pos.from != this || pos.p == nullptr) throw invalid_iterator();
+        return node_type(Remove(pos.p->key()));
+    }
+    /**
+     * 键不存在时返回空句柄
+     */
+    node_type extract(const Key &key) {
+        return node_type(Remove(key));
+    }
+    /**
+     * 插入句柄中的结点；键已存在时不插入，结点留在返回值的 node 中
+     */
+    insert_return_type insert(node_type &&nh) {
+        if(nh.empty()) return {end(), false, node_type()};
+        Node *tmp = nh.ptr;
+        bool inserted;
+        Node *res = Insert(tmp->key(), inserted, [tmp]{return Detached(tmp);});
+        if(!inserted) return {iterator(res, this), false, static_cast<node_type &&>(nh)};
+        nh.ptr = nullptr;
+        return {iterator(res, this), true, node_type()};
+    }
+    /**
+     * 把 other 中本容器没有的键连同结点一起转移过来，键已存在的元素留在 other 中。
+     * other 先整体拆成有序链表，再把每个结点插入本容器或插回 other
+     */
+    void merge(topdown_map &other) {
+        if(&other == this) return;
+        Node *list = Flatten(other.root);
+        other.root = nullptr;
+        other.num = 0;
+        while(list){
+            Node *t = list;
+            list = list->son[1];
+            bool inserted;
+            Insert(t->key(), inserted, [t]{return Detached(t);});
+            if(!inserted) other.Insert(t->key(), inserted, [t]{return Detached(t);});
+        }
+    }
+    /**
+     * 批量查找 keys[0, n)，out[i] 为 keys[i] 对应的迭代器，找不到为 end()。
+     * 每组键交错下降并顺带记录路径，一组内的缓存缺失相互重叠
+     */
+    void find_batch(const Key *keys, size_t n, iterator *out) {
+        for(size_t base = 0; base < n; base += BatchGroup)
+            FindBatch(keys + base, n - base < BatchGroup ? n - base : BatchGroup, out + base);
+    }
+    void find_batch(const Key *keys, size_t n, const_iterator *out) const {
+        for(size_t base = 0; base < n; base += BatchGroup)
+            FindBatch(keys + base, n - base < BatchGroup ? n - base : BatchGroup, out + base);
+    }
+	size_t count(const Key &key) const {
+        return FindNode(key) ? 1 : 0;
+    }
+	iterator find(const Key &key) {
+        return iterator(FindNode(key), this);
+    }
+	const_iterator find(const Key &key) const {
+        return const_iterator(FindNode(key), this);
+    }
+};
+
+}
+
+#endif
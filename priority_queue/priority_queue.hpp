@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <functional>
 #include "exceptions.hpp"
+#include "instrument.hpp"
 
 namespace sjtu {
 template<typename T, class Compare = std::less<T>>
@@ -46,6 +47,7 @@ public:
         void Heap_Clone(const Node *rhs, Node * &cur){//用于递归实现拷贝构造函数.
             if(rhs == nullptr) return;
             cur = new Node(*rhs);
+            SJTU_INSTRUMENT_ADD(priority_queue_node_allocations, 1);
             Heap_Clone(rhs->lc, cur->lc);
             Heap_Clone(rhs->rc, cur->rc);
         }
@@ -58,6 +60,7 @@ public:
         Node* Heap_Merge(Node *a, Node *b){
             if(a == nullptr) return b;
             if(b == nullptr) return a;
+            SJTU_INSTRUMENT_ADD(priority_queue_merges, 1);
             //小堆与大堆的右子堆合并
             //确保 a > b
             if(Compare()(a->val, b->val)) Swap_Node(a, b);
@@ -67,6 +70,7 @@ public:
         }
         void Heap_Insert(const T &p){
             Node *tmp = new Node(p); //构建单节点堆
+            SJTU_INSTRUMENT_ADD(priority_queue_node_allocations, 1);
             root =  Heap_Merge(root, tmp);
             Size++;
         }
@@ -2,6 +2,7 @@
 #define SJTU_UTILITY_HPP
 
 #include <utility>
+#include <tuple>
 
 namespace sjtu {
 
@@ -15,11 +16,19 @@ public:
 	pair(pair &&other) = default;
 	pair(const T1 &x, const T2 &y) : first(x), second(y) {}
 	template<class U1, class U2>
-	pair(U1 &&x, U2 &&y) : first(x), second(y) {}
+	pair(U1 &&x, U2 &&y) : first(std::forward<U1>(x)), second(std::forward<U2>(y)) {}
 	template<class U1, class U2>
 	pair(const pair<U1, U2> &other) : first(other.first), second(other.second) {}
 	template<class U1, class U2>
-	pair(pair<U1, U2> &&other) : first(other.first), second(other.second) {}
+	pair(pair<U1, U2> &&other) : first(std::move(other.first)), second(std::move(other.second)) {}
+	//分别用两组参数原地构造 first 与 second，不经过临时对象
+	template<class... Args1, class... Args2>
+	pair(std::piecewise_construct_t, std::tuple<Args1...> x, std::tuple<Args2...> y)
+		: pair(x, y, std::index_sequence_for<Args1...>(), std::index_sequence_for<Args2...>()) {}
+private:
+	template<class Tuple1, class Tuple2, std::size_t... I1, std::size_t... I2>
+	pair(Tuple1 &x, Tuple2 &y, std::index_sequence<I1...>, std::index_sequence<I2...>)
+		: first(std::get<I1>(std::move(x))...), second(std::get<I2>(std::move(y))...) {}
 };
 
 }
@@ -0,0 +1,191 @@
+////concurrent_linked_hashmap 的测试：单线程下 insert / assign / update / erase / find 与 std::map 对照，
+////for_each_ordered 按全局插入顺序遍历；多线程各自操作不相交的键后结果与串行一致，
+////同一个键上的并发 update 不丢失；以及拷贝元素时抛出异常，表不变、锁被释放。
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "concurrent_linked_hashmap.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::concurrent_linked_hashmap<int, std::string> map_type;
+
+static int TestDifferential() {
+    map_type m(1000);
+    std::map<int, std::string> ref;
+    std::vector<int> order; //第一次插入的顺序，覆盖不改变顺序
+    std::mt19937 rng(17);
+    for(int step = 0; step < 50000; ++step){
+        int k = (int) (rng() % 3000), op = (int) (rng() % 6);
+        std::string v = std::to_string(step);
+        if(op < 2){
+            bool ok = m.insert(k, v);
+            CHECK(ok == !ref.count(k));
+            if(ok){ ref[k] = v; order.push_back(k); }
+        }
+        else if(op == 2){
+            if(!ref.count(k)) order.push_back(k);
+            m.assign(k, v);
+            ref[k] = v;
+        }
+        else if(op == 3){
+            bool ok = m.update(k, [](std::string &s){ s += "+"; });
+            CHECK(ok == (ref.count(k) == 1));
+            if(ok) ref[k] += "+";
+        }
+        else if(op == 4){
+            bool ok = m.erase(k);
+            CHECK(ok == (ref.erase(k) == 1));
+            if(ok){
+                for(size_t i = 0; i < order.size(); ++i)
+                    if(order[i] == k){ order.erase(order.begin() + i); break; }
+            }
+        }
+        else{
+            std::string out;
+            CHECK(m.find(k, out) == (ref.count(k) == 1) && m.count(k) == ref.count(k));
+            if(ref.count(k)) CHECK(out == ref[k]);
+        }
+    }
+    CHECK(m.size() == ref.size() && m.empty() == ref.empty());
+    size_t seen = 0;
+    bool ok = true;
+    m.for_each([&](const int &k, const std::string &v){
+        ++seen;
+        auto it = ref.find(k);
+        if(it == ref.end() || it->second != v) ok = false;
+    });
+    CHECK(ok && seen == ref.size());
+    std::vector<int> ordered;
+    m.for_each_ordered([&](const int &k, const std::string &){ ordered.push_back(k); });
+    CHECK(ordered == order);
+    m.clear();
+    CHECK(m.empty() && m.size() == 0);
+    return 0;
+}
+
+static int TestThreads() {
+    const int Threads = 8, PerThread = 20000;
+    map_type m;
+    std::vector<std::thread> workers;
+    //各线程只碰自己的键：插入、覆盖一半、删除三分之一
+    for(int t = 0; t < Threads; ++t){
+        workers.emplace_back([&m, t]{
+            for(int i = 0; i < PerThread; ++i) m.insert(i * Threads + t, std::to_string(i));
+            for(int i = 0; i < PerThread; i += 2) m.assign(i * Threads + t, "a");
+            for(int i = 0; i < PerThread; i += 3) m.erase(i * Threads + t);
+        });
+    }
+    //同时有读者在遍历
+    workers.emplace_back([&m]{
+        for(int round = 0; round < 20; ++round){
+            size_t cnt = 0;
+            m.for_each_ordered([&](const int &, const std::string &){ ++cnt; });
+            std::string out;
+            m.find(round, out);
+        }
+    });
+    for(auto &w : workers) w.join();
+    size_t expect = 0;
+    for(int t = 0; t < Threads; ++t){
+        for(int i = 0; i < PerThread; ++i){
+            int k = i * Threads + t;
+            std::string out;
+            bool present = m.find(k, out);
+            CHECK(present == (i % 3 != 0));
+            if(present){
+                ++expect;
+                CHECK(out == (i % 2 == 0 ? std::string("a") : std::to_string(i)));
+            }
+        }
+    }
+    CHECK(m.size() == expect);
+    //每个线程内部的插入顺序在全局顺序里保持
+    std::vector<int> last(Threads, -1);
+    bool ok = true;
+    m.for_each_ordered([&](const int &k, const std::string &){
+        int t = k % Threads, i = k / Threads;
+        if(i <= last[t]) ok = false;
+        last[t] = i;
+    });
+    CHECK(ok);
+
+    //同一个键上的并发 update 在分片写锁下串行，一次都不丢
+    sjtu::concurrent_linked_hashmap<int, long long> counter;
+    counter.insert(1, 0);
+    workers.clear();
+    for(int t = 0; t < Threads; ++t)
+        workers.emplace_back([&counter]{
+            for(int i = 0; i < 10000; ++i) counter.update(1, [](long long &x){ ++x; });
+        });
+    for(auto &w : workers) w.join();
+    long long total = 0;
+    CHECK(counter.find(1, total) && total == (long long) Threads * 10000);
+    return 0;
+}
+
+//拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）
+struct Thrower {
+    static int countdown;
+    std::string s;
+    Thrower() {}
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+    Thrower &operator=(const Thrower &o) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+        s = o.s;
+        return *this;
+    }
+};
+int Thrower::countdown = -1;
+
+static int TestThrowingCopy() {
+    sjtu::concurrent_linked_hashmap<int, Thrower> m;
+    for(int i = 0; i < 100; ++i) m.insert(i, Thrower(i));
+    //插入时拷贝抛出：不留下半个元素
+    Thrower::countdown = 0;
+    bool inserted = true;
+    try{
+        inserted = m.insert(1000, Thrower(1000));
+    }catch(int){
+        inserted = false;
+    }
+    Thrower::countdown = -1;
+    CHECK(!inserted && m.count(1000) == 0 && m.size() == 100);
+    //覆盖与读出时抛出：原值不变
+    int thrown = 0;
+    Thrower::countdown = 0;
+    try{
+        m.assign(5, Thrower(-5));
+    }catch(int){
+        ++thrown;
+    }
+    Thrower::countdown = 0;
+    Thrower out;
+    try{
+        m.find(5, out);
+    }catch(int){
+        ++thrown;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown == 2 && m.find(5, out) && out.s == Thrower(5).s);
+    //异常之后锁已释放，其他线程照常写入
+    std::thread other([&m]{ m.insert(1000, Thrower(1000)); m.erase(5); });
+    other.join();
+    CHECK(m.count(1000) == 1 && m.count(5) == 0 && m.size() == 100);
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestThreads()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("concurrent_linked_hashmap_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+////deque 的测试：两端插入删除、随机访问、迭代器、拷贝与赋值与 std::deque 对照；
+////两端增长时已有元素的地址不变；以及拷贝元素时抛出异常（包括恰好要新开一个块时），结构不变、不泄漏。
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+#include "deque.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+template<class D, class R>
+static bool Same(const D &d, const R &ref) {
+    if(d.size() != ref.size() || d.empty() != ref.empty()) return false;
+    size_t i = 0;
+    for(auto p = d.cbegin(); p != d.cend(); ++p, ++i)
+        if(*p != ref[i] || d[i] != ref[i]) return false;
+    return true;
+}
+
+static int TestDifferential() {
+    sjtu::deque<std::string> d;
+    std::deque<std::string> ref;
+    std::mt19937 rng(5);
+    for(int step = 0; step < 200000; ++step){
+        int op = (int) (rng() % 10);
+        //前半段偏向增长，后半段偏向收缩，让块反复分配与归还
+        bool grow = step < 100000 ? op < 6 : op < 4;
+        std::string v = std::to_string(step);
+        if(grow){
+            if(rng() % 2){ d.push_back(v); ref.push_back(v); }
+            else{ d.push_front(v); ref.push_front(v); }
+        }
+        else if(!ref.empty()){
+            if(rng() % 2){ d.pop_back(); ref.pop_back(); }
+            else{ d.pop_front(); ref.pop_front(); }
+        }
+        CHECK(d.size() == ref.size());
+        if(!ref.empty()){
+            CHECK(d.front() == ref.front() && d.back() == ref.back());
+            size_t i = rng() % ref.size();
+            CHECK(d.at(i) == ref[i]);
+        }
+        if(step % 20000 == 0){
+            CHECK(Same(d, ref));
+            sjtu::deque<std::string> copy(d), assigned;
+            assigned.push_back("x");
+            assigned = d;
+            CHECK(Same(copy, ref) && Same(assigned, ref));
+        }
+    }
+    CHECK(Same(d, ref));
+    //迭代器算术
+    if(ref.size() > 10){
+        auto it = d.begin() + 3;
+        CHECK(*it == ref[3] && it - d.begin() == 3 && d.end() - d.begin() == (int) ref.size());
+        it += 5;
+        CHECK(*it == ref[8]);
+        --it;
+        CHECK(*it == ref[7] && it->size() == ref[7].size());
+    }
+    bool thrown = false;
+    try{
+        d.at(ref.size());
+    }catch(sjtu::index_out_of_bound &){
+        thrown = true;
+    }
+    CHECK(thrown);
+    d.clear();
+    thrown = false;
+    try{
+        d.pop_front();
+    }catch(sjtu::container_is_empty &){
+        thrown = true;
+    }
+    CHECK(thrown && d.empty());
+    return 0;
+}
+
+//元素从不移动：两端各压入很多块之后，最早的元素地址不变
+static int TestStableAddresses() {
+    sjtu::deque<int> d;
+    d.push_back(1);
+    d.push_back(2);
+    const int *a = &d[0], *b = &d[1];
+    for(int i = 0; i < 100000; ++i){
+        d.push_back(i);
+        d.push_front(-i);
+    }
+    CHECK(&d[100000] == a && &d[100001] == b && *a == 1 && *b == 2);
+    return 0;
+}
+
+//拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）
+struct Thrower {
+    static int countdown;
+    std::string s;
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+    Thrower &operator=(const Thrower &) = default;
+};
+int Thrower::countdown = -1;
+
+static int TestThrowingCopy() {
+    typedef sjtu::deque<Thrower> throw_deque;
+    throw_deque d;
+    //元素个数跨越块边界的各个位置，覆盖新开块与块内两种插入路径
+    for(int i = 0; i < 600; ++i){
+        Thrower v(i);
+        Thrower::countdown = 0;
+        bool thrown = false;
+        try{
+            if(i & 1) d.push_back(v);
+            else d.push_front(v);
+        }catch(int){
+            thrown = true;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown && d.size() == (size_t) i);
+        if(i & 1) d.push_back(v);
+        else d.push_front(v);
+    }
+    for(int i = 0; i < 600; ++i){
+        int expect = i < 300 ? 598 - i * 2 : (i - 300) * 2 + 1;
+        CHECK(d[i].s == Thrower(expect).s);
+    }
+    for(int n : {0, 1, 250, 599}){
+        Thrower::countdown = n;
+        bool thrown = false;
+        try{
+            throw_deque copy(d);
+        }catch(int){
+            thrown = true;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown);
+    }
+    //赋值中途抛出：目标里是已拷贝的前缀，仍可正常使用
+    throw_deque target;
+    target.push_back(Thrower(-1));
+    Thrower::countdown = 100;
+    bool thrown = false;
+    try{
+        target = d;
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && target.size() == 100);
+    for(size_t i = 0; i < target.size(); ++i) CHECK(target[i].s == d[i].s);
+    target.push_front(Thrower(7));
+    target.pop_back();
+    CHECK(target.size() == 100 && d.size() == 600);
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestStableAddresses()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("deque_test: ok\n");
+    return 0;
+}
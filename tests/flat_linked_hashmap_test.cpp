@@ -0,0 +1,118 @@
+////flat_linked_hashmap 的测试：与 std::unordered_map 对照的随机操作（含插入顺序遍历），
+////以及元素拷贝抛出异常时表保持原状。
+#include <cstdio>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "flat_linked_hashmap.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+//拷贝到第 countdown 次时抛出异常，countdown 为负表示不抛
+struct Thrower {
+    static int countdown;
+    std::string s; //有堆内存，半构造或重复析构会被 ASan 发现
+    explicit Thrower(int x) : s(std::string(32, 'a') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+    Thrower(Thrower &&o) noexcept : s(std::move(o.s)) {}
+};
+int Thrower::countdown = -1;
+
+//按插入顺序遍历得到的键序列应与 order 相同
+template<class M>
+static bool SameOrder(M &m, const std::list<int> &order) {
+    auto it = order.begin();
+    for(auto p = m.begin(); p != m.end(); ++p, ++it)
+        if(it == order.end() || p->first != *it) return false;
+    return it == order.end();
+}
+
+static int TestDifferential() {
+    sjtu::flat_linked_hashmap<int, int> m;
+    std::unordered_map<int, int> ref;
+    std::list<int> order;
+    std::unordered_map<int, std::list<int>::iterator> where;
+    std::mt19937 rng(7);
+    for(int step = 0; step < 200000; ++step){
+        int k = (int) (rng() % 2000), op = (int) (rng() % 4);
+        if(op == 0){
+            bool inserted = m.insert(sjtu::pair<const int, int>(k, step)).second;
+            CHECK(inserted == !ref.count(k));
+            if(inserted){
+                ref[k] = step;
+                where[k] = order.insert(order.end(), k);
+            }
+        }
+        else if(op == 1){
+            auto it = m.find(k);
+            CHECK((it == m.end()) == !ref.count(k));
+            if(it != m.end()){
+                m.erase(it);
+                ref.erase(k);
+                order.erase(where[k]);
+                where.erase(k);
+            }
+        }
+        else if(op == 2){
+            if(!ref.count(k)) where[k] = order.insert(order.end(), k);
+            m[k] += 1;
+            ref[k] += 1;
+        }
+        else{
+            CHECK(m.count(k) == ref.count(k));
+            if(ref.count(k)) CHECK(m.at(k) == ref[k]);
+        }
+        CHECK(m.size() == ref.size());
+        if(step % 10000 == 0) CHECK(SameOrder(m, order));
+    }
+    CHECK(SameOrder(m, order));
+    sjtu::flat_linked_hashmap<int, int> copy(m);
+    CHECK(SameOrder(copy, order));
+    for(auto &kv : ref) CHECK(copy.at(kv.first) == kv.second);
+    return 0;
+}
+
+static int TestThrowingCopy() {
+    sjtu::flat_linked_hashmap<int, Thrower> m;
+    for(int i = 0; i < 100; ++i) m.insert(sjtu::pair<const int, Thrower>(i, Thrower(i)));
+    //插入时元素的拷贝抛出：大小不变，新键查不到，旧元素都还在
+    for(int i = 100; i < 200; ++i){
+        Thrower::countdown = 0;
+        bool thrown = false;
+        try{
+            m.insert(sjtu::pair<const int, Thrower>(i, Thrower(i)));
+        }catch(int){
+            thrown = true;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown);
+        CHECK(m.size() == 100 && m.count(i) == 0);
+    }
+    for(int i = 0; i < 100; ++i) CHECK(m.at(i).s == std::string(32, 'a') + std::to_string(i));
+    int n = 0;
+    for(auto it = m.begin(); it != m.end(); ++it) CHECK(it->first == n++);
+    CHECK(n == 100);
+    //拷贝构造中途抛出：不泄漏，原表不变
+    Thrower::countdown = 50;
+    bool thrown = false;
+    try{
+        sjtu::flat_linked_hashmap<int, Thrower> copy(m);
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && m.size() == 100);
+    m.insert(sjtu::pair<const int, Thrower>(100, Thrower(100)));
+    CHECK(m.size() == 101 && m.at(100).s.back() == '0');
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("flat_linked_hashmap_test: ok\n");
+    return 0;
+}
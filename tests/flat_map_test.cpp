@@ -0,0 +1,193 @@
+////flat_map 的测试：单个 / 区间插入、删除、结点句柄、merge 与 find_batch 和 std::map 对照，
+////以及元素的拷贝或移动在区间 insert、merge 中途抛出异常时两个表都保持原状。
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "flat_map.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+//拷贝与移动都计数，到第 countdown 次时抛出异常（countdown 为负表示不抛）。
+//移动构造不是 noexcept，搬移已有元素时 flat_map 会改用拷贝
+struct Thrower {
+    static int countdown;
+    std::string s; //有堆内存，半构造或重复析构会被 ASan 发现
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        Tick();
+    }
+    Thrower(Thrower &&o) : s(o.s) {
+        Tick();
+    }
+    static void Tick() {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+};
+int Thrower::countdown = -1;
+
+typedef sjtu::flat_map<int, std::string> map_type;
+
+template<class M, class R>
+static bool Same(M &m, const R &ref) {
+    if(m.size() != ref.size()) return false;
+    auto it = ref.begin();
+    for(auto p = m.cbegin(); p != m.cend(); ++p, ++it)
+        if(p->first != it->first || p->second != it->second) return false;
+    return true;
+}
+
+static int TestDifferential() {
+    map_type m;
+    std::map<int, std::string> ref;
+    std::mt19937 rng(4);
+    for(int step = 0; step < 20000; ++step){
+        int k = (int) (rng() % 3000), op = (int) (rng() % 8);
+        std::string v = std::to_string(step);
+        if(op < 3){
+            bool inserted = m.insert(map_type::value_type(k, v)).second;
+            CHECK(inserted == !ref.count(k));
+            if(inserted) ref[k] = v;
+        }
+        else if(op == 3){
+            auto it = m.find(k);
+            CHECK((it == m.end()) == !ref.count(k));
+            if(it != m.end()){
+                m.erase(it);
+                ref.erase(k);
+            }
+        }
+        else if(op == 4 && step % 16 == 0){
+            //区间插入：无序、带重复，重复的键保留先出现的
+            std::vector<map_type::value_type> batch;
+            std::map<int, std::string> first;
+            for(int i = 0; i < 200; ++i){
+                int key = (int) (rng() % 3000);
+                batch.push_back(map_type::value_type(key, std::to_string(-i)));
+                first.insert(std::make_pair(key, std::to_string(-i)));
+            }
+            m.insert(batch.begin(), batch.end());
+            for(auto &kv : first) ref.insert(kv);
+        }
+        else if(op == 5){
+            map_type::node_type nh = m.extract(k);
+            CHECK(nh.empty() == !ref.count(k));
+            if(nh){
+                nh.mapped() += "!";
+                auto res = m.insert(std::move(nh));
+                CHECK(res.inserted && res.position->first == k && res.node.empty());
+                ref[k] += "!";
+            }
+        }
+        else if(op == 6 && step % 64 == 0){
+            map_type other;
+            std::map<int, std::string> otherRef;
+            for(int i = 0; i < 300; ++i){
+                int key = (int) (rng() % 3000);
+                if(other.insert(map_type::value_type(key, "o")).second) otherRef[key] = "o";
+            }
+            m.merge(other);
+            for(auto it = otherRef.begin(); it != otherRef.end();){
+                if(ref.insert(*it).second) it = otherRef.erase(it);
+                else ++it;
+            }
+            CHECK(Same(other, otherRef));
+        }
+        else{
+            CHECK(m.count(k) == ref.count(k));
+            if(ref.count(k)) CHECK(m.at(k) == ref[k]);
+        }
+        CHECK(m.size() == ref.size());
+    }
+    CHECK(Same(m, ref));
+    int query[100];
+    map_type::iterator out[100];
+    for(int i = 0; i < 100; ++i) query[i] = (int) (rng() % 3000);
+    m.find_batch(query, 100, out);
+    for(int i = 0; i < 100; ++i) CHECK(out[i] == m.find(query[i]));
+    map_type copy(m), assigned;
+    assigned = m;
+    CHECK(Same(copy, ref) && Same(assigned, ref));
+    return 0;
+}
+
+typedef sjtu::flat_map<int, Thrower> throw_map;
+
+//把表的内容记成字符串序列，异常前后比较
+static std::vector<std::string> Snapshot(throw_map &m) {
+    std::vector<std::string> res;
+    for(auto it = m.cbegin(); it != m.cend(); ++it) res.push_back(std::to_string(it->first) + ":" + it->second.s);
+    return res;
+}
+
+static int TestThrowingRangeInsert() {
+    std::vector<throw_map::value_type> batch;
+    for(int i = 0; i < 64; ++i) batch.push_back(throw_map::value_type(i * 3 + 1, Thrower(i)));
+    bool finished = false;
+    //第 n 次拷贝 / 移动抛出，n 从 0 递增直到区间插入成功
+    for(int n = 0; !finished; ++n){
+        throw_map m;
+        for(int i = 0; i < 64; ++i) m.insert(throw_map::value_type(i * 2, Thrower(-i)));
+        std::vector<std::string> before = Snapshot(m);
+        Thrower::countdown = n;
+        try{
+            m.insert(batch.begin(), batch.end());
+            finished = true;
+        }catch(int){
+        }
+        Thrower::countdown = -1;
+        if(!finished) CHECK(Snapshot(m) == before);
+        else CHECK(m.size() == 128 - 21); //i * 2 与 i * 3 + 1 有 21 个键相同
+        CHECK(n < 100000);
+    }
+    return 0;
+}
+
+static int TestThrowingMerge() {
+    bool finished = false;
+    for(int n = 0; !finished; ++n){
+        throw_map a, b;
+        for(int i = 0; i < 64; ++i){
+            a.insert(throw_map::value_type(i * 2, Thrower(i)));
+            b.insert(throw_map::value_type(i * 3, Thrower(-i)));
+        }
+        std::vector<std::string> beforeA = Snapshot(a), beforeB = Snapshot(b);
+        Thrower::countdown = n;
+        try{
+            a.merge(b);
+            finished = true;
+        }catch(int){
+        }
+        Thrower::countdown = -1;
+        if(!finished) CHECK(Snapshot(a) == beforeA && Snapshot(b) == beforeB);
+        else{
+            CHECK(a.size() == 128 - 22 && b.size() == 22); //0..126 的偶数与 0..189 的 3 的倍数有 22 个相同
+            for(auto it = b.cbegin(); it != b.cend(); ++it) CHECK(it->first % 6 == 0 && a.count(it->first));
+        }
+        CHECK(n < 100000);
+    }
+    //句柄：移出失败时元素留在表中
+    throw_map m;
+    m.insert(throw_map::value_type(1, Thrower(1)));
+    Thrower::countdown = 0;
+    bool thrown = false;
+    try{
+        m.extract(1);
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && m.size() == 1 && m.at(1).s == Thrower(1).s);
+    throw_map::node_type nh = m.extract(1);
+    CHECK(m.empty() && nh.key() == 1);
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestThrowingRangeInsert()) return 1;
+    if(TestThrowingMerge()) return 1;
+    printf("flat_map_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,88 @@
+////linked_hashmap 的就地构造测试：只能移动的值、没有默认构造函数的值、
+////operator[] 未命中时不拷贝也不移动值，以及键已存在时 try_emplace 不动参数。
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "linked_hashmap.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+//只能用两个参数构造，不能默认构造，也不能拷贝或移动
+struct Pinned {
+    int a, b;
+    Pinned(int x, int y) : a(x), b(y) {}
+    Pinned(const Pinned &) = delete;
+    Pinned(Pinned &&) = delete;
+};
+
+//记录拷贝与移动次数
+struct Counted {
+    static int copies, moves;
+    int v;
+    Counted() : v(0) {}
+    explicit Counted(int x) : v(x) {}
+    Counted(const Counted &o) : v(o.v) {copies++;}
+    Counted(Counted &&o) noexcept : v(o.v) {moves++;}
+    Counted &operator=(const Counted &o) {v = o.v; copies++; return *this;}
+    Counted &operator=(Counted &&o) noexcept {v = o.v; moves++; return *this;}
+    static void reset() {copies = moves = 0;}
+};
+int Counted::copies = 0, Counted::moves = 0;
+
+static int TestMoveOnly() {
+    sjtu::linked_hashmap<int, std::unique_ptr<int>> m;
+    CHECK(m.try_emplace(1, new int(10)).second);
+    CHECK(m.emplace(2, std::unique_ptr<int>(new int(20))).second);
+    CHECK(m.insert(sjtu::pair<const int, std::unique_ptr<int>>(3, std::unique_ptr<int>(new int(30)))).second);
+    m[4].reset(new int(40));
+    CHECK(m.size() == 4);
+    for(int i = 1; i <= 4; ++i) CHECK(*m.at(i) == i * 10);
+    //插入顺序保持不变
+    int expect = 1;
+    for(auto it = m.begin(); it != m.end(); ++it) CHECK(it->first == expect++);
+    //键已存在：键和值参数都不能被移走
+    std::string key = "k";
+    sjtu::linked_hashmap<std::string, std::unique_ptr<int>> s;
+    s.try_emplace(key, new int(1));
+    std::unique_ptr<int> keep(new int(99));
+    CHECK(!s.try_emplace(std::move(key), std::move(keep)).second);
+    CHECK(key == "k" && keep && *keep == 99);
+    //结点句柄转移只能移动的值
+    sjtu::linked_hashmap<int, std::unique_ptr<int>> other;
+    other.insert(m.extract(2));
+    CHECK(m.count(2) == 0 && *other.at(2) == 20);
+    m.erase(m.find(3));
+    CHECK(m.size() == 2);
+    return 0;
+}
+
+static int TestNoDefault() {
+    sjtu::linked_hashmap<int, Pinned> m;
+    for(int i = 0; i < 1000; ++i) CHECK(m.try_emplace(i, i, -i).second); //跨过多次扩容
+    CHECK(!m.try_emplace(5, 0, 0).second);
+    CHECK(m.size() == 1000 && m.at(5).a == 5 && m.at(999).b == -999);
+    return 0;
+}
+
+static int TestOperatorBracketMiss() {
+    sjtu::linked_hashmap<int, Counted> m;
+    Counted::reset();
+    m[1].v = 5;
+    m[2];
+    m[1].v++;
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    CHECK(m.at(1).v == 6 && m.at(2).v == 0);
+    Counted::reset();
+    m.try_emplace(3, 7);
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    //扩容只搬动结点，不搬动值
+    for(int i = 4; i < 1000; ++i) m[i];
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    return 0;
+}
+
+int main() {
+    if(TestMoveOnly() || TestNoDefault() || TestOperatorBracketMiss()) return 1;
+    puts("linked_hashmap_emplace_test: ok");
+    return 0;
+}
@@ -0,0 +1,125 @@
+////linked_hashmap 镜像的测试：写出后映射打开，按插入顺序遍历与查找和 linked_hashmap 本身对照；
+////以及文件头被篡改（元素数组或哈希索引的偏移不对齐、越界，槽位数非法）时打开失败。
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include "linked_hashmap_image.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::linked_hashmap<long long, double> map_type;
+typedef sjtu::mapped_linked_hashmap<long long, double> image_type;
+
+static std::string TempPath(const char *name) {
+    return std::string("/tmp/") + name + "." + std::to_string(getpid());
+}
+
+//把文件头 offset 处的 8 字节改成 value
+static void Patch(const std::string &path, size_t offset, unsigned long long value) {
+    FILE *f = fopen(path.c_str(), "r+b");
+    fseek(f, (long) offset, SEEK_SET);
+    fwrite(&value, sizeof(value), 1, f);
+    fclose(f);
+}
+
+template<class M>
+static bool OpenFails(const std::string &path) {
+    try{
+        M m(path.c_str());
+    }catch(sjtu::runtime_error &){
+        return true;
+    }
+    return false;
+}
+
+static int TestRoundTrip() {
+    std::string path = TempPath("linked_hashmap_image_test");
+    map_type m;
+    std::mt19937_64 rng(3);
+    for(int i = 0; i < 50000; ++i){
+        long long k = (long long) (rng() % 200000);
+        m[k] += i;
+        if(i % 7 == 0) m.erase(m.find(k));
+    }
+    sjtu::write_image(m, path.c_str());
+    {
+        image_type img(path.c_str());
+        CHECK(img.size() == m.size());
+        auto it = m.cbegin();
+        for(auto p = img.cbegin(); p != img.cend(); ++p, ++it)
+            CHECK(p->first == it->first && p->second == it->second);
+        for(int i = 0; i < 20000; ++i){
+            long long k = (long long) (rng() % 200000);
+            auto f = m.find(k);
+            CHECK(img.count(k) == (f != m.end()));
+            if(f != m.end()) CHECK(img.at(k) == f->second);
+        }
+        CHECK((OpenFails<sjtu::mapped_linked_hashmap<long long, float>>(path))); //类型不符
+    }
+    //重复的键在 finish 时拒绝
+    {
+        sjtu::linked_hashmap_image_writer<int, int> w(path.c_str());
+        w.push(1, 1);
+        w.push(2, 2);
+        w.push(1, 3);
+        bool thrown = false;
+        try{
+            w.finish();
+        }catch(sjtu::runtime_error &){
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+    sjtu::write_image(map_type(), path.c_str());
+    {
+        image_type img(path.c_str());
+        CHECK(img.empty() && !img.find(1));
+    }
+    unlink(path.c_str());
+    return 0;
+}
+
+static int TestCorruptHeader() {
+    std::string path = TempPath("linked_hashmap_image_test");
+    map_type m;
+    for(long long i = 0; i < 100; ++i) m[i] = (double) i;
+    const size_t DataOffset = offsetof(sjtu::image_header, data_offset), Count = offsetof(sjtu::image_header, count),
+                 IndexOffset = offsetof(sjtu::image_header, index_offset), IndexSlots = offsetof(sjtu::image_header, index_slots);
+    //元素数组不按元素对齐
+    sjtu::write_image(m, path.c_str());
+    Patch(path, DataOffset, sjtu::image_header::HeaderBytes + 4);
+    Patch(path, Count, 99);
+    CHECK(OpenFails<image_type>(path));
+    //哈希索引不按槽位对齐
+    sjtu::write_image(m, path.c_str());
+    unsigned long long index;
+    {
+        image_type img(path.c_str());
+        CHECK(img.size() == 100);
+        FILE *f = fopen(path.c_str(), "rb");
+        fseek(f, (long) IndexOffset, SEEK_SET);
+        CHECK(fread(&index, sizeof(index), 1, f) == 1);
+        fclose(f);
+    }
+    Patch(path, IndexOffset, index - 4);
+    CHECK(OpenFails<image_type>(path));
+    //哈希索引越界
+    sjtu::write_image(m, path.c_str());
+    Patch(path, IndexOffset, index + 64);
+    CHECK(OpenFails<image_type>(path));
+    //槽位数不是 2 的幂
+    sjtu::write_image(m, path.c_str());
+    Patch(path, IndexSlots, 200);
+    CHECK(OpenFails<image_type>(path));
+    unlink(path.c_str());
+    return 0;
+}
+
+int main() {
+    if(TestRoundTrip()) return 1;
+    if(TestCorruptHeader()) return 1;
+    printf("linked_hashmap_image_test: ok\n");
+    return 0;
+}
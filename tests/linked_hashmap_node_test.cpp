@@ -0,0 +1,227 @@
+////linked_hashmap 结点句柄的测试：extract / insert(node_type&&) / merge，包括结点在容器间转移、
+////句柄比源容器活得久、容器按不同顺序析构，以及三个容器间随机转移结点与 std::unordered_map 对照。
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "linked_hashmap.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::linked_hashmap<int, std::string> map_type;
+
+//值带堆内存，结点被重复析构或释放后再用会被 ASan 发现
+static std::string Val(int k) {
+    return std::string(24, 'v') + std::to_string(k);
+}
+
+static void Fill(map_type &m, int lo, int hi) {
+    for(int i = lo; i < hi; ++i) m.insert(map_type::value_type(i, Val(i)));
+}
+
+//按插入顺序遍历得到的键序列应与 order 相同
+static bool SameOrder(map_type &m, const std::list<int> &order) {
+    auto it = order.begin();
+    for(auto p = m.begin(); p != m.end(); ++p, ++it)
+        if(it == order.end() || p->first != *it || p->second != Val(*it)) return false;
+    return it == order.end();
+}
+
+static int TestSameContainer() {
+    map_type m;
+    Fill(m, 0, 10);
+    map_type::node_type nh = m.extract(3);
+    CHECK(nh && nh.key() == 3 && nh.mapped() == Val(3));
+    CHECK(m.size() == 9 && m.count(3) == 0);
+    CHECK(m.extract(3).empty()); //键不存在时返回空句柄
+    nh.mapped() += "!";
+    auto res = m.insert(std::move(nh));
+    CHECK(res.inserted && res.position->first == 3 && res.node.empty() && nh.empty());
+    CHECK(m.at(3) == Val(3) + "!");
+    CHECK((--m.end())->first == 3); //插回的结点排在插入顺序末尾
+    //键已存在：结点原样留在返回值里
+    map_type other;
+    other.insert(map_type::value_type(5, "other"));
+    res = m.insert(other.extract(5));
+    CHECK(!res.inserted && res.position->first == 5 && res.node && res.node.mapped() == "other");
+    CHECK(other.empty() && m.at(5) == Val(5));
+    //空句柄插入什么也不做
+    res = m.insert(map_type::node_type());
+    CHECK(!res.inserted && res.position == m.end());
+    //extract 之后 clear，句柄仍可用
+    nh = m.extract(m.begin());
+    m.clear();
+    CHECK(nh.key() == 0 && m.empty());
+    m.insert(std::move(nh));
+    Fill(m, 100, 200);
+    CHECK(m.size() == 101 && m.at(0) == Val(0));
+    return 0;
+}
+
+static int TestCrossContainer() {
+    //句柄比源容器活得久：源容器析构后再插入另一个容器，目标容器先于源的结点池析构
+    map_type::node_type nh;
+    {
+        map_type a;
+        Fill(a, 0, 50);
+        nh = a.extract(7);
+    }
+    {
+        map_type b;
+        Fill(b, 100, 110);
+        CHECK(b.insert(std::move(nh)).inserted);
+        CHECK(b.at(7) == Val(7));
+        b.erase(b.find(7)); //来自已析构容器的结点也能正常删除
+        Fill(b, 200, 300);
+        CHECK(b.size() == 110);
+    }
+    //句柄在源容器析构后直接析构
+    {
+        map_type *a = new map_type;
+        Fill(*a, 0, 20);
+        map_type::node_type h = a->extract(a->begin());
+        delete a;
+        CHECK(h.key() == 0 && h.mapped() == Val(0));
+    }
+    //源容器先于目标容器析构，以及反过来
+    for(int srcFirst = 0; srcFirst < 2; ++srcFirst){
+        map_type *a = new map_type, *b = new map_type;
+        Fill(*a, 0, 100);
+        Fill(*b, 50, 150);
+        b->merge(*a);
+        CHECK(a->size() == 50 && b->size() == 150);
+        for(int i = 0; i < 50; ++i) CHECK(b->at(i) == Val(i) && a->count(i) == 0);
+        for(int i = 50; i < 100; ++i) CHECK(a->at(i) == Val(i));
+        //被合并的键按 a 的插入顺序排在 b 的末尾
+        auto it = b->begin();
+        for(int i = 50; i < 150; ++i, ++it) CHECK(it->first == i);
+        for(int i = 0; i < 50; ++i, ++it) CHECK(it->first == i);
+        if(srcFirst){
+            delete a;
+            b->clear();
+            Fill(*b, 0, 300);
+            delete b;
+        }
+        else{
+            delete b;
+            a->clear();
+            Fill(*a, 0, 300);
+            delete a;
+        }
+    }
+    //结点在两个容器间来回转移：两个池合并成一组，不会互相持有而泄漏
+    {
+        map_type a, b;
+        Fill(a, 0, 10);
+        for(int round = 0; round < 5; ++round){
+            b.merge(a);
+            CHECK(a.empty() && b.size() == 10);
+            a.merge(b);
+            CHECK(b.empty() && a.size() == 10);
+        }
+        CHECK(SameOrder(a, std::list<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    }
+    //只能移动的值经句柄转移，不拷贝
+    {
+        sjtu::linked_hashmap<int, std::unique_ptr<int>> a, b;
+        a.try_emplace(1, new int(10));
+        auto h = a.extract(1);
+        int *raw = h.mapped().get();
+        CHECK(b.insert(std::move(h)).inserted);
+        CHECK(b.at(1).get() == raw && *raw == 10);
+    }
+    return 0;
+}
+
+//三个容器间随机 extract / insert / merge / erase / clear，与 std::unordered_map 加插入顺序链表对照
+static int TestDifferential() {
+    const int M = 3;
+    map_type *m[M];
+    std::unordered_map<int, std::list<int>::iterator> where[M];
+    std::list<int> order[M];
+    for(int i = 0; i < M; ++i) m[i] = new map_type;
+    std::mt19937 rng(11);
+    std::list<map_type::node_type> handles;
+    for(int step = 0; step < 100000; ++step){
+        int x = (int) (rng() % M), y = (int) (rng() % M), k = (int) (rng() % 300), op = (int) (rng() % 16);
+        if(op < 6){
+            bool inserted = m[x]->insert(map_type::value_type(k, Val(k))).second;
+            CHECK(inserted == !where[x].count(k));
+            if(inserted) where[x][k] = order[x].insert(order[x].end(), k);
+        }
+        else if(op < 8){
+            auto it = m[x]->find(k);
+            CHECK((it == m[x]->end()) == !where[x].count(k));
+            if(it != m[x]->end()){
+                m[x]->erase(it);
+                order[x].erase(where[x][k]);
+                where[x].erase(k);
+            }
+        }
+        else if(op < 11){
+            //从 x 摘下结点插入 y；y 已有该键时句柄暂存起来，稍后插回或丢弃
+            map_type::node_type nh = m[x]->extract(k);
+            CHECK(nh.empty() == !where[x].count(k));
+            if(nh.empty()) continue;
+            order[x].erase(where[x][k]);
+            where[x].erase(k);
+            auto res = m[y]->insert(std::move(nh));
+            CHECK(res.inserted == !where[y].count(k));
+            if(res.inserted) where[y][k] = order[y].insert(order[y].end(), k);
+            else handles.push_back(std::move(res.node));
+        }
+        else if(op < 13){
+            if(handles.empty()) continue;
+            map_type::node_type &nh = handles.front();
+            int key = nh.key();
+            auto res = m[x]->insert(std::move(nh));
+            CHECK(res.inserted == !where[x].count(key));
+            if(res.inserted) where[x][key] = order[x].insert(order[x].end(), key);
+            handles.pop_front(); //插入失败时 res.node 在这里析构，结点归还给摘下它的容器
+        }
+        else if(op == 13){
+            m[x]->merge(*m[y]);
+            if(x != y)
+                for(auto it = order[y].begin(); it != order[y].end();){
+                    if(where[x].count(*it)){
+                        ++it;
+                        continue;
+                    }
+                    where[x][*it] = order[x].insert(order[x].end(), *it);
+                    where[y].erase(*it);
+                    it = order[y].erase(it);
+                }
+        }
+        else if(op == 14){
+            if(rng() % 50) continue;
+            m[x]->clear();
+            where[x].clear();
+            order[x].clear();
+        }
+        else{
+            if(rng() % 200) continue;
+            //析构一个容器，换一个新的
+            delete m[x];
+            m[x] = new map_type;
+            where[x].clear();
+            order[x].clear();
+        }
+        for(int i = 0; i < M; ++i) CHECK(m[i]->size() == where[i].size());
+        if(step % 5000 == 0)
+            for(int i = 0; i < M; ++i) CHECK(SameOrder(*m[i], order[i]));
+    }
+    for(int i = 0; i < M; ++i) CHECK(SameOrder(*m[i], order[i]));
+    for(int i = 0; i < M; ++i) delete m[i];
+    handles.clear(); //所有容器析构之后句柄才析构
+    return 0;
+}
+
+int main() {
+    if(TestSameContainer()) return 1;
+    if(TestCrossContainer()) return 1;
+    if(TestDifferential()) return 1;
+    printf("linked_hashmap_node_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+////linked_hashmap 渐进式扩容的测试：迁移进行中（新旧两张桶表并存）查找、删除、插入与按插入顺序遍历，
+////结果与 std::unordered_map 对照；以及迁移中拷贝、clear、关闭渐进式扩容。
+#include <cstdio>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include "linked_hashmap.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::linked_hashmap<int, int> map_type;
+
+struct Ref {
+    std::unordered_map<int, int> val;
+    std::unordered_map<int, std::list<int>::iterator> where;
+    std::list<int> order;
+    void insert(int k, int v) {
+        val[k] = v;
+        where[k] = order.insert(order.end(), k);
+    }
+    void erase(int k) {
+        val.erase(k);
+        order.erase(where[k]);
+        where.erase(k);
+    }
+};
+
+//逐个键查找，并按插入顺序遍历
+static bool Same(const map_type &m, const Ref &ref) {
+    if(m.size() != ref.val.size()) return false;
+    for(auto &kv : ref.val){
+        auto it = m.find(kv.first);
+        if(it == m.cend() || it->second != kv.second) return false;
+    }
+    auto it = ref.order.begin();
+    for(auto p = m.cbegin(); p != m.cend(); ++p, ++it)
+        if(it == ref.order.end() || p->first != *it) return false;
+    return it == ref.order.end();
+}
+
+//插入直到开始一轮迁移
+static void StartMigration(map_type &m, Ref &ref, std::mt19937 &rng) {
+    while(!m.oldArray){
+        int k = (int) (rng() % 1000000);
+        if(m.insert(map_type::value_type(k, k * 3)).second) ref.insert(k, k * 3);
+    }
+}
+
+static int TestMidMigration() {
+    std::mt19937 rng(5);
+    map_type m;
+    m.incremental_rehash(true);
+    Ref ref;
+    int rounds = 0;
+    while(m.size() < 30000){
+        StartMigration(m, ref, rng);
+        rounds++;
+        CHECK(Same(m, ref));
+        //迁移进行中：交替删除与插入，每步都检查未迁移的旧桶与新桶中的键
+        while(m.oldArray){
+            CHECK(m.migratePos < m.oldCapacity);
+            int k = (int) (rng() % 1000000);
+            auto it = m.find(k);
+            CHECK((it == m.end()) == !ref.val.count(k));
+            if(rng() % 3 == 0 && !ref.order.empty()){
+                //删除插入顺序最早的键：它大多还在未迁移的旧桶里
+                int victim = ref.order.front();
+                CHECK(m.find(victim) != m.end());
+                m.erase(m.find(victim));
+                ref.erase(victim);
+                CHECK(m.find(victim) == m.end());
+            }
+            else if(it == m.end()){
+                m.insert(map_type::value_type(k, k * 3));
+                ref.insert(k, k * 3);
+            }
+            if(m.oldArray && rng() % 64 == 0) CHECK(Same(m, ref));
+        }
+        CHECK(Same(m, ref));
+    }
+    CHECK(rounds > 5);
+    return 0;
+}
+
+static int TestCopyClearToggle() {
+    std::mt19937 rng(9);
+    map_type m;
+    m.incremental_rehash(true);
+    Ref ref;
+    for(int i = 0; i < 10; ++i){
+        StartMigration(m, ref, rng);
+        m.incremental_rehash(false);
+        m.incremental_rehash(true);
+    }
+    StartMigration(m, ref, rng);
+    //迁移中拷贝：副本是完整的表，也保留渐进式扩容的设置
+    map_type copy(m);
+    CHECK(copy.incremental_rehash() && Same(copy, ref));
+    map_type assigned;
+    assigned = m;
+    CHECK(assigned.incremental_rehash() && Same(assigned, ref));
+    //关闭时一次迁移完
+    m.incremental_rehash(false);
+    CHECK(!m.oldArray && Same(m, ref));
+    //迁移中 clear 之后可以继续使用
+    Ref copyRef = ref;
+    StartMigration(copy, copyRef, rng);
+    copy.clear();
+    CHECK(copy.empty() && !copy.oldArray && copy.begin() == copy.end());
+    Ref empty;
+    StartMigration(copy, empty, rng);
+    CHECK(Same(copy, empty));
+    return 0;
+}
+
+int main() {
+    if(TestMidMigration()) return 1;
+    if(TestCopyClearToggle()) return 1;
+    printf("linked_hashmap_rehash_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+////lru_cache 的测试：get / peek / put / erase / resize 与一个用链表实现的参考 LRU 对照，
+////检查命中、未命中、淘汰计数，淘汰回调收到的键值以及从旧到新的遍历顺序；
+////以及拷贝元素时抛出异常，缓存内容不变。
+#include <cstdio>
+#include <list>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "lru_cache.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+//最简单的参考实现：表头最久未使用，线性查找
+struct RefLru {
+    size_t cap;
+    std::list<std::pair<int, std::string>> items;
+    std::vector<std::pair<int, std::string>> evicted;
+    size_t hits = 0, misses = 0;
+
+    explicit RefLru(size_t c) : cap(c) {}
+    std::list<std::pair<int, std::string>>::iterator Find(int k) {
+        for(auto it = items.begin(); it != items.end(); ++it)
+            if(it->first == k) return it;
+        return items.end();
+    }
+    std::string *Get(int k) {
+        auto it = Find(k);
+        if(it == items.end()){ ++misses; return nullptr; }
+        ++hits;
+        items.splice(items.end(), items, it);
+        return &items.back().second;
+    }
+    void Put(int k, const std::string &v) {
+        auto it = Find(k);
+        if(it != items.end()){
+            it->second = v;
+            items.splice(items.end(), items, it);
+            return;
+        }
+        if(items.size() >= cap) Evict();
+        items.emplace_back(k, v);
+    }
+    void Evict() {
+        evicted.push_back(items.front());
+        items.pop_front();
+    }
+};
+
+typedef sjtu::lru_cache<int, std::string> cache_type;
+
+static bool Same(const cache_type &c, const RefLru &ref) {
+    if(c.size() != ref.items.size() || c.hits() != ref.hits || c.misses() != ref.misses) return false;
+    auto it = ref.items.begin();
+    for(auto p = c.cbegin(); p != c.cend(); ++p, ++it)
+        if(p->first != it->first || p->second != it->second) return false;
+    return true;
+}
+
+static int TestDifferential() {
+    std::vector<std::pair<int, std::string>> evicted;
+    cache_type c(64, [&](const int &k, std::string &v){ evicted.emplace_back(k, std::move(v)); });
+    RefLru ref(64);
+    std::mt19937 rng(13);
+    for(int step = 0; step < 100000; ++step){
+        int k = (int) (rng() % 200), op = (int) (rng() % 10);
+        if(op < 4){
+            std::string *a = c.get(k), *b = ref.Get(k);
+            CHECK((a == nullptr) == (b == nullptr));
+            if(a) CHECK(*a == *b);
+        }
+        else if(op < 8){
+            std::string v = std::to_string(step);
+            CHECK(c.put(k, v) == v);
+            ref.Put(k, v);
+        }
+        else if(op == 8){
+            //peek 不改变顺序，也不计入统计
+            const std::string *a = c.peek(k);
+            auto it = ref.Find(k);
+            CHECK((a == nullptr) == (it == ref.items.end()) && c.contains(k) == (a != nullptr));
+            if(a) CHECK(*a == it->second);
+            bool erased = c.erase(k);
+            CHECK(erased == (it != ref.items.end()));
+            if(erased) ref.items.erase(it);
+        }
+        else if(step % 1000 == 999){
+            //缩小时按 LRU 顺序淘汰，之后再放大
+            size_t cap = 1 + rng() % 100;
+            c.resize(cap);
+            ref.cap = cap;
+            while(ref.items.size() > cap) ref.Evict();
+            CHECK(c.capacity() == cap);
+        }
+        CHECK(c.size() <= c.capacity());
+    }
+    CHECK(Same(c, ref));
+    CHECK(evicted == ref.evicted && c.evictions() == ref.evicted.size());
+    c.reset_stats();
+    CHECK(c.hits() == 0 && c.misses() == 0 && c.evictions() == 0);
+    c.clear();
+    CHECK(c.empty() && c.get(0) == nullptr && c.misses() == 1);
+    bool thrown = false;
+    try{
+        cache_type bad(0);
+    }catch(sjtu::runtime_error &){
+        thrown = true;
+    }
+    CHECK(thrown);
+    thrown = false;
+    try{
+        c.resize(0);
+    }catch(sjtu::runtime_error &){
+        thrown = true;
+    }
+    CHECK(thrown && c.capacity() != 0);
+    return 0;
+}
+
+//拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）
+struct Thrower {
+    static int countdown;
+    std::string s;
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+    Thrower &operator=(const Thrower &o) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+        s = o.s;
+        return *this;
+    }
+};
+int Thrower::countdown = -1;
+
+static int TestThrowingCopy() {
+    typedef sjtu::lru_cache<int, Thrower> throw_cache;
+    throw_cache c(8);
+    for(int i = 0; i < 8; ++i) c.put(i, Thrower(i));
+    //覆盖已有键时赋值抛出：值与顺序都不变
+    Thrower::countdown = 0;
+    bool thrown = false;
+    try{
+        c.put(3, Thrower(100));
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && c.size() == 8 && c.peek(3)->s == Thrower(3).s);
+    int expect = 0;
+    for(auto it = c.cbegin(); it != c.cend(); ++it, ++expect) CHECK(it->first == expect);
+    //插入新键时拷贝抛出：不留下半个元素
+    for(int n : {0, 1}){
+        Thrower::countdown = n;
+        thrown = false;
+        try{
+            c.put(50 + n, Thrower(50));
+        }catch(int){
+            thrown = true;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown && !c.contains(50 + n) && c.size() <= 8);
+    }
+    c.put(60, Thrower(60));
+    CHECK(c.contains(60) && c.size() <= 8);
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("lru_cache_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,142 @@
+////紧凑结点布局（SJTU_MAP_COMPACT_NODES）的测试：插入、删除、拷贝、赋值、结点句柄在两个 map 之间转移，
+////与 std::map 对照并检查红黑树性质；释放的槽被复用，构造元素抛出异常时槽也归还；
+////以及结点确实按 32 位编号存放。
+#define SJTU_MAP_COMPACT_NODES 1
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include "map.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::map<int, std::string> map_type;
+typedef map_type::RedBlackNode node_type;
+typedef map_type::NodeArena arena_type;
+
+//返回 t 的黑高，不满足红黑树性质时返回 -1
+static int Verify(const node_type *t, const node_type *parent) {
+    if(!t) return 0;
+    if(t->parent() != parent) return -1;
+    bool red = t->color() == map_type::RED;
+    for(int d = 0; d < 2; ++d)
+        if(red && t->son[d] && t->son[d]->color() == map_type::RED) return -1;
+    int hl = Verify(t->son[0], t), hr = Verify(t->son[1], t);
+    if(hl < 0 || hl != hr) return -1;
+    return hl + (red ? 0 : 1);
+}
+
+static bool Same(map_type &m, const std::map<int, std::string> &ref) {
+    if(m.size() != ref.size() || Verify(m.Tree.getRoot(), nullptr) < 0) return false;
+    auto it = ref.begin();
+    for(auto p = m.cbegin(); p != m.cend(); ++p, ++it)
+        if(p->first != it->first || p->second != it->second) return false;
+    return true;
+}
+
+static int TestDifferential() {
+    map_type a, b;
+    std::map<int, std::string> ra, rb;
+    std::mt19937 rng(3);
+    for(int step = 0; step < 60000; ++step){
+        int k = (int) (rng() % 5000), op = (int) (rng() % 6);
+        map_type &m = step & 1 ? a : b;
+        std::map<int, std::string> &ref = step & 1 ? ra : rb;
+        if(op < 3){
+            std::string v = std::to_string(step);
+            if(m.insert(map_type::value_type(k, v)).second) ref[k] = v;
+        }
+        else if(op == 3){
+            auto it = m.find(k);
+            CHECK((it == m.end()) == !ref.count(k));
+            if(it != m.end()){
+                m.erase(it);
+                ref.erase(k);
+            }
+        }
+        else{
+            //结点在两个 map 之间转移，编号不变
+            map_type &other = step & 1 ? b : a;
+            std::map<int, std::string> &otherRef = step & 1 ? rb : ra;
+            map_type::node_type nh = m.extract(k);
+            CHECK(nh.empty() == !ref.count(k));
+            if(nh){
+                auto res = other.insert(std::move(nh));
+                CHECK(res.inserted == !otherRef.count(k));
+                if(res.inserted) otherRef[k] = ref[k];
+                ref.erase(k);
+            }
+        }
+    }
+    CHECK(Same(a, ra) && Same(b, rb));
+    map_type copy(a);
+    b = a;
+    CHECK(Same(copy, ra) && Same(b, ra));
+    b.clear();
+    CHECK(Same(b, std::map<int, std::string>()));
+    return 0;
+}
+
+//释放的槽进空闲链表，反复插入删除不再向池里要新槽
+static int TestReuse() {
+    map_type m;
+    for(int i = 0; i < 10000; ++i) m.insert(map_type::value_type(i, "x"));
+    for(int i = 0; i < 10000; ++i) m.erase(m.find(i));
+    uint32_t used = arena_type::used;
+    for(int round = 0; round < 3; ++round){
+        for(int i = 0; i < 10000; ++i) m.insert(map_type::value_type(i * 7, "y"));
+        m.clear();
+    }
+    CHECK(arena_type::used == used);
+    return 0;
+}
+
+struct Thrower {
+    static int countdown;
+    std::string s = std::string(32, 't');
+    Thrower() {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+};
+int Thrower::countdown = -1;
+
+//构造元素失败时结点的槽归还给池
+static int TestThrowingCopy() {
+    typedef sjtu::map<int, Thrower> throw_map;
+    throw_map m;
+    for(int i = 0; i < 100; ++i) m.insert(throw_map::value_type(i, Thrower()));
+    uint32_t used = throw_map::NodeArena::used;
+    for(int i = 0; i < 100; ++i){
+        Thrower::countdown = 1; //第一次拷贝构造临时的 value_type，第二次在结点里
+        bool thrown = false;
+        try{
+            m.insert(throw_map::value_type(1000 + i, Thrower()));
+        }catch(int){
+            thrown = true;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown);
+    }
+    CHECK(m.size() == 100 && throw_map::NodeArena::used == used + 1); //每次失败的插入都取回同一个槽
+    Thrower::countdown = 50;
+    bool thrown = false;
+    try{
+        throw_map copy(m);
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && m.size() == 100);
+    return 0;
+}
+
+int main() {
+    //两个儿子、父结点与颜色共 12 字节，加上本结点编号
+    static_assert(sizeof(sjtu::map<int, int>::RedBlackNode) == 4 * 4 + sizeof(sjtu::pair<const int, int>), "compact node size");
+    if(TestDifferential()) return 1;
+    if(TestReuse()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("map_compact_test: ok\n");
+    return 0;
+}
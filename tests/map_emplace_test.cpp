@@ -0,0 +1,103 @@
+////map / topdown_map 的就地构造测试：只能移动的值、没有默认构造函数的值、
+////operator[] 未命中时不拷贝也不移动值，以及键已存在时 try_emplace 不动参数。
+#include <cstdio>
+#include <memory>
+#include "map.hpp"
+#include "topdown_map.hpp"
+#include "flat_map.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+//只能用两个参数构造，不能默认构造，也不能拷贝或移动
+struct Pinned {
+    int a, b;
+    Pinned(int x, int y) : a(x), b(y) {}
+    Pinned(const Pinned &) = delete;
+    Pinned(Pinned &&) = delete;
+};
+
+//记录拷贝与移动次数
+struct Counted {
+    static int copies, moves;
+    int v;
+    Counted() : v(0) {}
+    explicit Counted(int x) : v(x) {}
+    Counted(const Counted &o) : v(o.v) {copies++;}
+    Counted(Counted &&o) noexcept : v(o.v) {moves++;}
+    Counted &operator=(const Counted &o) {v = o.v; copies++; return *this;}
+    Counted &operator=(Counted &&o) noexcept {v = o.v; moves++; return *this;}
+    static void reset() {copies = moves = 0;}
+};
+int Counted::copies = 0, Counted::moves = 0;
+
+static int TestMoveOnly() {
+    sjtu::map<int, std::unique_ptr<int>> m;
+    CHECK(m.try_emplace(1, new int(10)).second);
+    CHECK(m.emplace(2, std::unique_ptr<int>(new int(20))).second);
+    CHECK(m.insert(sjtu::pair<const int, std::unique_ptr<int>>(3, std::unique_ptr<int>(new int(30)))).second);
+    m[4].reset(new int(40));
+    CHECK(m.size() == 4);
+    for(int i = 1; i <= 4; ++i) CHECK(*m.at(i) == i * 10);
+    //键已存在：参数不能被移走
+    std::unique_ptr<int> keep(new int(99));
+    CHECK(!m.try_emplace(1, std::move(keep)).second);
+    CHECK(keep && *keep == 99);
+    CHECK(*m.at(1) == 10);
+    //结点句柄转移只能移动的值
+    sjtu::map<int, std::unique_ptr<int>> other;
+    other.insert(m.extract(2));
+    CHECK(m.count(2) == 0 && *other.at(2) == 20);
+    m.erase(m.find(3));
+    CHECK(m.size() == 2);
+    sjtu::topdown_map<int, std::unique_ptr<int>> t, u;
+    CHECK(t.try_emplace(1, new int(10)).second);
+    CHECK(t.emplace(2, std::unique_ptr<int>(new int(20))).second);
+    t[3].reset(new int(30));
+    u.insert(t.extract(2));
+    u[1].reset(new int(11));
+    t.merge(u);
+    CHECK(t.size() == 3 && u.size() == 1 && *t.at(1) == 10 && *t.at(2) == 20 && *u.at(1) == 11);
+    return 0;
+}
+
+static int TestNoDefault() {
+    sjtu::map<int, Pinned> m;
+    CHECK(m.try_emplace(5, 1, 2).second);
+    CHECK(!m.try_emplace(5, 3, 4).second);
+    CHECK(m.at(5).a == 1 && m.at(5).b == 2);
+    sjtu::topdown_map<int, Pinned> t;
+    for(int i = 0; i < 100; ++i) CHECK(t.try_emplace(i, i, -i).second);
+    CHECK(!t.try_emplace(7, 0, 0).second);
+    CHECK(t.size() == 100 && t.at(7).b == -7);
+    return 0;
+}
+
+static int TestOperatorBracketMiss() {
+    sjtu::map<int, Counted> m;
+    Counted::reset();
+    m[1].v = 5;
+    m[2];
+    m[1].v++;
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    CHECK(m.at(1).v == 6 && m.at(2).v == 0);
+    Counted::reset();
+    m.try_emplace(3, 7);
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    sjtu::topdown_map<int, Counted> t;
+    Counted::reset();
+    t[1].v = 3;
+    t.try_emplace(2, 4);
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    sjtu::flat_map<int, Counted> f;
+    Counted::reset();
+    f[1].v = 3;
+    f.try_emplace(2, 4);
+    CHECK(Counted::copies == 0 && Counted::moves == 0);
+    return 0;
+}
+
+int main() {
+    if(TestMoveOnly() || TestNoDefault() || TestOperatorBracketMiss()) return 1;
+    puts("map_emplace_test: ok");
+    return 0;
+}
@@ -0,0 +1,130 @@
+////map 镜像的测试：写出后映射打开，遍历与查找与 std::map 对照；以及文件头被篡改
+////（类型不符、偏移越界或不按元素对齐）时打开失败。
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include "map_image.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+struct alignas(16) Vec {
+    double x, y;
+};
+
+typedef sjtu::map<long long, Vec> map_type;
+typedef sjtu::mapped_map<long long, Vec> image_type;
+
+static std::string TempPath(const char *name) {
+    return std::string("/tmp/") + name + "." + std::to_string(getpid());
+}
+
+//把文件头 offset 处的 8 字节改成 value
+static void Patch(const std::string &path, size_t offset, unsigned long long value) {
+    FILE *f = fopen(path.c_str(), "r+b");
+    fseek(f, (long) offset, SEEK_SET);
+    fwrite(&value, sizeof(value), 1, f);
+    fclose(f);
+}
+
+template<class M>
+static bool OpenFails(const std::string &path) {
+    try{
+        M m(path.c_str());
+    }catch(sjtu::runtime_error &){
+        return true;
+    }
+    return false;
+}
+
+static int TestRoundTrip() {
+    std::string path = TempPath("map_image_test");
+    map_type m;
+    std::map<long long, Vec> ref;
+    std::mt19937_64 rng(3);
+    for(int i = 0; i < 50000; ++i){
+        long long k = (long long) (rng() % 1000000) - 500000;
+        Vec v{(double) i, (double) k};
+        if(m.insert(map_type::value_type(k, v)).second) ref[k] = v;
+    }
+    sjtu::write_image(m, path.c_str());
+    {
+        image_type img(path.c_str());
+        CHECK(img.size() == ref.size());
+        auto it = ref.begin();
+        for(auto p = img.cbegin(); p != img.cend(); ++p, ++it){
+            CHECK(reinterpret_cast<size_t>(p) % alignof(Vec) == 0);
+            CHECK(p->first == it->first && p->second.x == it->second.x && p->second.y == it->second.y);
+        }
+        for(int i = 0; i < 10000; ++i){
+            long long k = (long long) (rng() % 1000000) - 500000;
+            CHECK(img.count(k) == ref.count(k));
+            if(ref.count(k)) CHECK(img.at(k).x == ref[k].x);
+            auto lb = img.lower_bound(k);
+            auto rlb = ref.lower_bound(k);
+            CHECK((lb == img.cend()) == (rlb == ref.end()));
+            if(rlb != ref.end()) CHECK(lb->first == rlb->first);
+        }
+        CHECK((OpenFails<sjtu::mapped_map<long long, double>>(path))); //类型不符
+    }
+    //写入的键不递增时拒绝
+    {
+        sjtu::map_image_writer<int, int> w(path.c_str());
+        w.push(1, 1);
+        bool thrown = false;
+        try{
+            w.push(1, 2);
+        }catch(sjtu::runtime_error &){
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+    //空表
+    sjtu::write_image(map_type(), path.c_str());
+    {
+        image_type img(path.c_str());
+        CHECK(img.empty() && img.cbegin() == img.cend() && !img.find(1));
+    }
+    unlink(path.c_str());
+    return 0;
+}
+
+static int TestCorruptHeader() {
+    std::string path = TempPath("map_image_test");
+    map_type m;
+    for(long long i = 0; i < 100; ++i) m.insert(map_type::value_type(i, Vec{1, 2}));
+    const size_t DataOffset = offsetof(sjtu::image_header, data_offset), Count = offsetof(sjtu::image_header, count);
+    //data_offset 不按元素对齐（元素个数相应减一，数组仍在文件范围内）
+    sjtu::write_image(m, path.c_str());
+    Patch(path, DataOffset, sjtu::image_header::HeaderBytes + 8);
+    Patch(path, Count, 99);
+    CHECK(OpenFails<image_type>(path));
+    //按元素对齐的偏移仍能打开：前移一个元素，原来的第 0 个元素变成第 1 个
+    static_assert(sizeof(map_type::value_type) == 32, "test assumes 32-byte elements");
+    sjtu::write_image(m, path.c_str());
+    Patch(path, DataOffset, sjtu::image_header::HeaderBytes - 32);
+    Patch(path, Count, 101);
+    {
+        image_type img(path.c_str());
+        CHECK(img.size() == 101 && img.cbegin()[1].first == 0);
+    }
+    //元素个数超出文件
+    sjtu::write_image(m, path.c_str());
+    Patch(path, Count, 101);
+    CHECK(OpenFails<image_type>(path));
+    //偏移越界
+    sjtu::write_image(m, path.c_str());
+    Patch(path, DataOffset, 1ull << 40);
+    CHECK(OpenFails<image_type>(path));
+    unlink(path.c_str());
+    return 0;
+}
+
+int main() {
+    if(TestRoundTrip()) return 1;
+    if(TestCorruptHeader()) return 1;
+    printf("map_image_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+////map_parallel.hpp 的测试：build / union / intersection / difference 在 1、2、4、8 个线程下与 std::set 对照，
+////结果逐个检查红黑树性质（根为黑、无红红相连、各路径黑高相同、父指针正确）；
+////以及批量算法结束后此前的迭代器视为失效。规模超过 Grain，确实会拆成并行任务。
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+#include "map.hpp"
+#include "map_parallel.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::map<int, int> map_type;
+typedef map_type::RedBlackNode node_type;
+
+//返回 t 的黑高，不满足红黑树性质时返回 -1；count 累加结点数
+static int Verify(const node_type *t, const node_type *parent, size_t &count) {
+    if(!t) return 0;
+    if(t->parent() != parent) return -1;
+    bool red = t->color() == map_type::RED;
+    for(int d = 0; d < 2; ++d)
+        if(red && t->son[d] && t->son[d]->color() == map_type::RED) return -1;
+    if(t->son[0] && !(t->son[0]->data()->first < t->data()->first)) return -1;
+    if(t->son[1] && !(t->data()->first < t->son[1]->data()->first)) return -1;
+    ++count;
+    int hl = Verify(t->son[0], t, count), hr = Verify(t->son[1], t, count);
+    if(hl < 0 || hl != hr) return -1;
+    return hl + (red ? 0 : 1);
+}
+
+static bool Same(map_type &m, const std::set<int> &ref) {
+    const node_type *root = m.Tree.getRoot();
+    size_t count = 0;
+    if(root && root->color() == map_type::RED) return false;
+    if(Verify(root, nullptr, count) < 0 || count != ref.size() || m.size() != ref.size()) return false;
+    auto it = ref.begin();
+    for(auto p = m.cbegin(); p != m.cend(); ++p, ++it)
+        if(p->first != *it || p->second != *it * 2) return false;
+    return true;
+}
+
+static void Fill(map_type &m, std::set<int> &ref, std::mt19937 &rng, size_t n, int range) {
+    for(size_t i = 0; i < n; ++i){
+        int k = (int) (rng() % range);
+        m.insert(map_type::value_type(k, k * 2));
+        ref.insert(k);
+    }
+}
+
+static int TestBuild(sjtu::thread_pool &pool) {
+    for(size_t n : {0, 1, 2, 3, 7, 100, 40000}){
+        std::vector<sjtu::pair<int, int>> sorted;
+        for(size_t i = 0; i < n; ++i) sorted.emplace_back((int) i * 3, (int) i * 6);
+        map_type m;
+        m.insert(map_type::value_type(-1, -2));
+        sjtu::parallel_build(pool, m, sorted.begin(), sorted.end());
+        std::set<int> ref;
+        for(size_t i = 0; i < n; ++i) ref.insert((int) i * 3);
+        CHECK(Same(m, ref));
+    }
+    //不是严格递增时 m 保持不变
+    std::vector<sjtu::pair<int, int>> bad;
+    for(int i = 0; i < 40000; ++i) bad.emplace_back(i == 30000 ? 0 : i, i * 2);
+    map_type m;
+    m.insert(map_type::value_type(5, 10));
+    bool thrown = false;
+    try{
+        sjtu::parallel_build(pool, m, bad.begin(), bad.end());
+    }catch(sjtu::runtime_error &){
+        thrown = true;
+    }
+    CHECK(thrown && Same(m, std::set<int>{5}));
+    return 0;
+}
+
+static int TestSetOps(sjtu::thread_pool &pool) {
+    std::mt19937 rng((unsigned) pool.size());
+    //两侧规模悬殊时 join 要沿较高一棵下降很多层
+    const size_t Sizes[][2] = {{0, 0}, {0, 500}, {500, 0}, {1, 40000}, {40000, 1}, {30000, 30000}, {60000, 2000}, {300, 50000}};
+    for(auto &sz : Sizes){
+        for(int range : {1000000, 80000}){
+            map_type a, b;
+            std::set<int> ra, rb;
+            Fill(a, ra, rng, sz[0], range);
+            Fill(b, rb, rng, sz[1], range);
+
+            map_type u(a), v(b);
+            sjtu::parallel_union(pool, u, v);
+            std::set<int> ru(ra);
+            ru.insert(rb.begin(), rb.end());
+            CHECK(Same(u, ru) && v.empty() && v.Tree.getRoot() == nullptr);
+
+            map_type x(a);
+            sjtu::parallel_intersection(pool, x, b);
+            std::set<int> rx;
+            for(int k : ra) if(rb.count(k)) rx.insert(k);
+            CHECK(Same(x, rx) && Same(b, rb));
+
+            map_type d(a);
+            sjtu::parallel_difference(pool, d, b);
+            std::set<int> rd;
+            for(int k : ra) if(!rb.count(k)) rd.insert(k);
+            CHECK(Same(d, rd) && Same(b, rb));
+
+            //结果可以继续当普通 map 使用
+            d.insert(map_type::value_type(-7, -14));
+            rd.insert(-7);
+            if(!rd.empty()){
+                int k = *rd.rbegin();
+                d.erase(d.find(k));
+                rd.erase(k);
+            }
+            CHECK(Same(d, rd));
+        }
+    }
+    return 0;
+}
+
+//批量算法与 clear 一样使此前的迭代器失效
+static int TestStaleIterators(sjtu::thread_pool &pool) {
+#if SJTU_CHECKED_ITERATORS
+    map_type a, b;
+    for(int i = 0; i < 100; ++i){
+        a.insert(map_type::value_type(i * 2, i * 4));
+        b.insert(map_type::value_type(i * 3, i * 6));
+    }
+    map_type::iterator ia = a.begin(), ib = b.begin();
+    sjtu::parallel_union(pool, a, b);
+    int thrown = 0;
+    try{ ++ia; }catch(sjtu::invalid_iterator &){ ++thrown; }
+    try{ ++ib; }catch(sjtu::invalid_iterator &){ ++thrown; }
+    CHECK(thrown == 2);
+    ia = a.begin();
+    sjtu::parallel_intersection(pool, a, b);
+    try{ ++ia; }catch(sjtu::invalid_iterator &){ ++thrown; }
+    ia = a.begin();
+    sjtu::parallel_difference(pool, a, b);
+    try{ ++ia; }catch(sjtu::invalid_iterator &){ ++thrown; }
+    CHECK(thrown == 4);
+    b.insert(map_type::value_type(1, 2));
+    ib = b.begin();
+    sjtu::parallel_intersection(pool, a, b);
+    ++ib; //b 只读，迭代器仍然有效
+#endif
+    return 0;
+}
+
+int main() {
+    for(size_t t : {1, 2, 4, 8}){
+        sjtu::thread_pool pool(t);
+        if(TestBuild(pool)) return 1;
+        if(TestSetOps(pool)) return 1;
+        if(TestStaleIterators(pool)) return 1;
+    }
+    printf("map_parallel_test: ok\n");
+    return 0;
+}
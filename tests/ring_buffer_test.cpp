@@ -0,0 +1,199 @@
+////spsc_ring_buffer / mpmc_ring_buffer 的测试：单线程下与 std::deque 对照（容量取整、满、空、绕圈）；
+////一个生产者一个消费者时顺序不变，多生产者多消费者时每个元素恰好被取出一次；
+////以及拷贝元素时抛出异常，队列不变、不泄漏。
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ring_buffer.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+template<class Q>
+static int Differential(Q &q, size_t cap) {
+    std::deque<std::string> ref;
+    std::mt19937 rng(19);
+    CHECK(q.capacity() == cap && q.empty());
+    for(int step = 0; step < 50000; ++step){
+        //偏向一端，队列会反复满和空
+        bool push = (step / 1000) & 1 ? rng() % 4 != 0 : rng() % 4 == 0;
+        if(push){
+            std::string v = std::to_string(step);
+            bool ok = q.try_push(v);
+            CHECK(ok == (ref.size() < cap));
+            if(ok) ref.push_back(v);
+            else{
+                //满时右值不被移走
+                ok = q.try_push(std::move(v));
+                CHECK(!ok && v == std::to_string(step));
+            }
+        }
+        else{
+            std::string out = "unchanged";
+            bool ok = q.try_pop(out);
+            CHECK(ok == !ref.empty());
+            if(ok){
+                CHECK(out == ref.front());
+                ref.pop_front();
+            }
+            else CHECK(out == "unchanged");
+        }
+        CHECK(q.size() == ref.size());
+    }
+    return 0;
+}
+
+static int TestSingleThread() {
+    for(size_t cap : {1, 2, 5, 64}){
+        sjtu::spsc_ring_buffer<std::string> q(cap);
+        size_t rounded = 1;
+        while(rounded < cap) rounded <<= 1;
+        if(Differential(q, rounded)) return 1;
+        //清空后再放一个，留在队列里的元素由析构函数释放
+        std::string tmp;
+        while(q.try_pop(tmp)) {}
+        q.push("tail");
+        CHECK(q.front() == "tail" && q.size() == 1);
+    }
+    for(size_t cap : {1, 2, 5, 64}){
+        sjtu::mpmc_ring_buffer<std::string> q(cap);
+        size_t rounded = 2;
+        while(rounded < cap) rounded <<= 1;
+        if(Differential(q, rounded)) return 1;
+        std::string tmp;
+        while(q.try_pop(tmp)) {}
+        q.push(std::string("tail"));
+        CHECK(q.size() == 1);
+    }
+    sjtu::spsc_ring_buffer<int> empty(4);
+    bool thrown = false;
+    try{
+        empty.front();
+    }catch(sjtu::container_is_empty &){
+        thrown = true;
+    }
+    CHECK(thrown);
+    int zero = 0;
+    try{
+        sjtu::spsc_ring_buffer<int> bad(0);
+    }catch(sjtu::runtime_error &){
+        ++zero;
+    }
+    try{
+        sjtu::mpmc_ring_buffer<int> bad(0);
+    }catch(sjtu::runtime_error &){
+        ++zero;
+    }
+    CHECK(zero == 2);
+    return 0;
+}
+
+static int TestSpscThreads() {
+    const int N = 200000;
+    sjtu::spsc_ring_buffer<int> q(64);
+    std::thread producer([&q]{
+        for(int i = 0; i < N; ++i) q.push(i);
+    });
+    bool ordered = true;
+    for(int i = 0; i < N; ++i){
+        int x;
+        q.pop(x);
+        if(x != i) ordered = false;
+    }
+    producer.join();
+    CHECK(ordered && q.empty());
+    return 0;
+}
+
+static int TestMpmcThreads() {
+    const int Producers = 4, Consumers = 4, PerProducer = 50000;
+    sjtu::mpmc_ring_buffer<long long> q(128);
+    std::vector<std::atomic<int>> seen(Producers * PerProducer);
+    for(auto &s : seen) s.store(0);
+    std::atomic<int> left(Producers * PerProducer);
+    std::vector<std::thread> threads;
+    for(int p = 0; p < Producers; ++p)
+        threads.emplace_back([&q, p]{
+            for(int i = 0; i < PerProducer; ++i) q.push((long long) p * PerProducer + i);
+        });
+    std::vector<std::vector<long long>> got(Consumers);
+    for(int c = 0; c < Consumers; ++c)
+        threads.emplace_back([&, c]{
+            long long x;
+            while(left.load() > 0){
+                if(!q.try_pop(x)){ std::this_thread::yield(); continue; }
+                left.fetch_sub(1);
+                seen[x].fetch_add(1);
+                got[c].push_back(x);
+            }
+        });
+    for(auto &t : threads) t.join();
+    for(auto &s : seen) CHECK(s.load() == 1);
+    //同一个生产者的元素在每个消费者那里仍按生产顺序出现
+    for(auto &g : got){
+        std::vector<long long> last(Producers, -1);
+        for(long long x : g){
+            CHECK(x > last[x / PerProducer]);
+            last[x / PerProducer] = x;
+        }
+    }
+    CHECK(q.empty());
+    return 0;
+}
+
+//拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）
+struct Thrower {
+    static int countdown;
+    std::string s;
+    Thrower() {}
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+    Thrower(Thrower &&o) noexcept : s(std::move(o.s)) {}
+    Thrower &operator=(const Thrower &) = default;
+    Thrower &operator=(Thrower &&) noexcept = default;
+};
+int Thrower::countdown = -1;
+
+template<class Q>
+static int ThrowingCopy(Q &q) {
+    for(int i = 0; i < 3; ++i) q.push(Thrower(i));
+    Thrower v(100);
+    Thrower::countdown = 0;
+    bool thrown = false;
+    try{
+        q.try_push(v);
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && q.size() == 3);
+    //抛出之后队列照常工作：依次取出原来的三个，再放入新的
+    for(int i = 0; i < 3; ++i){
+        Thrower out;
+        CHECK(q.try_pop(out) && out.s == Thrower(i).s);
+    }
+    CHECK(q.try_push(v) && q.size() == 1);
+    return 0;
+}
+
+static int TestThrowingCopy() {
+    sjtu::spsc_ring_buffer<Thrower> a(4);
+    if(ThrowingCopy(a)) return 1;
+    sjtu::mpmc_ring_buffer<Thrower> b(4);
+    if(ThrowingCopy(b)) return 1;
+    return 0;
+}
+
+int main() {
+    if(TestSingleThread()) return 1;
+    if(TestSpscThreads()) return 1;
+    if(TestMpmcThreads()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("ring_buffer_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,94 @@
+////soa_vector 的测试：按行追加、按行与按列读取与 std::vector<std::tuple> 对照，
+////push_back 每个字段只拷贝一次，以及某一列拷贝抛出异常时各列回滚到相同长度。
+#include <cstdio>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "soa_vector.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+//记录拷贝次数，拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）
+struct Counted {
+    static int copies, countdown;
+    std::string s;
+    explicit Counted(const std::string &x) : s(x) {}
+    Counted(const Counted &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+        copies++;
+    }
+    Counted &operator=(const Counted &o) {
+        s = o.s;
+        return *this;
+    }
+};
+int Counted::copies = 0, Counted::countdown = -1;
+
+static int TestDifferential() {
+    sjtu::soa_vector<int, std::string, double> v;
+    std::vector<std::tuple<int, std::string, double>> ref;
+    std::mt19937 rng(2);
+    for(int step = 0; step < 50000; ++step){
+        int op = (int) (rng() % 4);
+        if(op < 2){
+            int a = (int) rng();
+            std::string b = std::to_string(rng() % 100000);
+            double c = a * 0.25;
+            if(op == 0) v.push_back(a, b, c);
+            else v.push_back(std::make_tuple(a, b, c));
+            ref.emplace_back(a, b, c);
+        }
+        else if(op == 2 && !ref.empty()){
+            v.pop_back();
+            ref.pop_back();
+        }
+        else if(!ref.empty()){
+            size_t pos = rng() % ref.size();
+            std::get<2>(v[pos]) += 1;
+            std::get<2>(ref[pos]) += 1;
+            v.get<1>(pos) += "x";
+            std::get<1>(ref[pos]) += "x";
+        }
+        CHECK(v.size() == ref.size());
+        CHECK(v.column<0>().size() == ref.size() && v.column<2>().size() == ref.size());
+    }
+    size_t i = 0;
+    for(auto it = v.cbegin(); it != v.cend(); ++it, ++i) CHECK(*it == ref[i]);
+    CHECK(i == ref.size());
+    const int *col = v.column_data<0>();
+    for(i = 0; i < ref.size(); ++i) CHECK(col[i] == std::get<0>(ref[i]) && v.at(i) == ref[i]);
+    v.clear();
+    CHECK(v.empty() && v.begin() == v.end());
+    return 0;
+}
+
+static int TestCopiesAndThrow() {
+    sjtu::soa_vector<Counted, int, Counted> v;
+    v.reserve(16); //避免扩容时的拷贝计入
+    Counted a("a"), b("b");
+    Counted::copies = 0;
+    v.push_back(a, 1, b);
+    CHECK(Counted::copies == 2); //每个字段直接拷进自己的列
+    //第三列拷贝抛出：前两列撤销，各列长度一致
+    Counted::countdown = 1;
+    bool thrown = false;
+    try{
+        v.push_back(a, 2, b);
+    }catch(int){
+        thrown = true;
+    }
+    Counted::countdown = -1;
+    CHECK(thrown && v.size() == 1);
+    CHECK(v.column<0>().size() == 1 && v.column<1>().size() == 1 && v.column<2>().size() == 1);
+    v.push_back(b, 3, a);
+    CHECK(v.size() == 2 && v.get<0>(1).s == "b" && v.get<1>(1) == 3 && v.get<2>(1).s == "a");
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestCopiesAndThrow()) return 1;
+    printf("soa_vector_test: ok\n");
+    return 0;
+}
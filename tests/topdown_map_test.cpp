@@ -0,0 +1,224 @@
+////topdown_map 的测试：插入、删除、结点句柄、merge、find_batch 与 std::map 对照；
+////插入删除其他元素后此前拿到的迭代器仍指向原元素、++ / -- 走到正确的邻居；
+////以及拷贝元素时抛出异常，insert 与拷贝构造都不改变原表、不泄漏。
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "topdown_map.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+typedef sjtu::topdown_map<int, std::string> map_type;
+
+template<class M, class R>
+static bool Same(M &m, const R &ref) {
+    if(m.size() != ref.size()) return false;
+    auto it = ref.begin();
+    for(auto p = m.cbegin(); p != m.cend(); ++p, ++it)
+        if(p->first != it->first || p->second != it->second) return false;
+    //反向遍历
+    auto rit = ref.rbegin();
+    for(auto p = m.cend(); p != m.cbegin(); ++rit){
+        --p;
+        if(p->first != rit->first) return false;
+    }
+    return true;
+}
+
+static int TestDifferential() {
+    map_type m;
+    std::map<int, std::string> ref;
+    std::mt19937 rng(7);
+    for(int step = 0; step < 30000; ++step){
+        int k = (int) (rng() % 2000), op = (int) (rng() % 7);
+        std::string v = std::to_string(step);
+        if(op < 2){
+            auto res = m.insert(map_type::value_type(k, v));
+            CHECK(res.second == !ref.count(k));
+            if(res.second) ref[k] = v;
+            CHECK(res.first->first == k && res.first->second == ref[k]);
+        }
+        else if(op == 2){
+            auto res = m.try_emplace(k, v);
+            CHECK(res.second == !ref.count(k) && res.first->first == k);
+            if(res.second) ref[k] = v;
+        }
+        else if(op == 3){
+            auto it = m.find(k);
+            CHECK((it == m.end()) == !ref.count(k));
+            if(it != m.end()){
+                m.erase(it);
+                ref.erase(k);
+            }
+        }
+        else if(op == 4){
+            map_type::node_type nh = m.extract(k);
+            CHECK(nh.empty() == !ref.count(k));
+            if(nh){
+                nh.mapped() += "!";
+                auto res = m.insert(std::move(nh));
+                CHECK(res.inserted && res.position->first == k && res.node.empty());
+                ref[k] += "!";
+            }
+        }
+        else if(op == 5){
+            m[k] += "+";
+            ref[k] += "+";
+        }
+        else if(step % 128 == 0){
+            map_type other;
+            std::map<int, std::string> otherRef;
+            for(int i = 0; i < 200; ++i){
+                int key = (int) (rng() % 2000);
+                if(other.insert(map_type::value_type(key, "o")).second) otherRef[key] = "o";
+            }
+            m.merge(other);
+            for(auto it = otherRef.begin(); it != otherRef.end();){
+                if(ref.insert(*it).second) it = otherRef.erase(it);
+                else ++it;
+            }
+            CHECK(Same(other, otherRef));
+        }
+        CHECK(m.size() == ref.size());
+    }
+    CHECK(Same(m, ref));
+    int query[100];
+    map_type::iterator out[100];
+    map_type::const_iterator cout_[100];
+    for(int i = 0; i < 100; ++i) query[i] = (int) (rng() % 2000);
+    m.find_batch(query, 100, out);
+    static_cast<const map_type &>(m).find_batch(query, 100, cout_);
+    for(int i = 0; i < 100; ++i) CHECK(out[i] == m.find(query[i]) && cout_[i] == out[i]);
+    map_type copy(m), assigned;
+    assigned = m;
+    CHECK(Same(copy, ref) && Same(assigned, ref));
+    return 0;
+}
+
+//迭代器只记结点，插入删除别的元素后仍然有效
+static int TestStableIterators() {
+    map_type m;
+    std::map<int, std::string> ref;
+    std::mt19937 rng(11);
+    for(int i = 0; i < 4000; i += 2){
+        m.insert(map_type::value_type(i, std::to_string(i)));
+        ref[i] = std::to_string(i);
+    }
+    std::vector<map_type::iterator> held;
+    std::vector<int> heldKeys;
+    for(int i = 0; i < 4000; i += 40){
+        held.push_back(m.find(i));
+        heldKeys.push_back(i);
+    }
+    for(int step = 0; step < 20000; ++step){
+        int k = (int) (rng() % 4000);
+        if(k % 40 == 0) continue; //不动被持有的元素
+        if(rng() % 2){
+            m.insert(map_type::value_type(k, std::to_string(k)));
+            ref.insert(std::make_pair(k, std::to_string(k)));
+        }
+        else{
+            m.extract(k);
+            ref.erase(k);
+        }
+        if(step % 500) continue;
+        for(size_t i = 0; i < held.size(); ++i){
+            map_type::iterator it = held[i];
+            CHECK(it->first == heldKeys[i]);
+            auto r = ref.find(heldKeys[i]);
+            ++it;
+            ++r;
+            CHECK((it == m.end()) == (r == ref.end()));
+            if(r != ref.end()) CHECK(it->first == r->first);
+            it = held[i];
+            if(it != m.begin()){
+                --it;
+                r = ref.find(heldKeys[i]);
+                --r;
+                CHECK(it->first == r->first);
+            }
+        }
+    }
+    CHECK(Same(m, ref));
+    //越过两端
+    bool thrown = false;
+    try{
+        --m.begin();
+    }catch(sjtu::invalid_iterator &){
+        thrown = true;
+    }
+    CHECK(thrown);
+    thrown = false;
+    try{
+        ++m.end();
+    }catch(sjtu::invalid_iterator &){
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK((--m.end())->first == ref.rbegin()->first);
+    return 0;
+}
+
+//拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）
+struct Thrower {
+    static int countdown;
+    std::string s;
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)) {}
+    Thrower(const Thrower &o) : s(o.s) {
+        if(countdown >= 0 && countdown-- == 0) throw 1;
+    }
+};
+int Thrower::countdown = -1;
+
+static int TestThrowingCopy() {
+    typedef sjtu::topdown_map<int, Thrower> throw_map;
+    throw_map m;
+    for(int i = 0; i < 200; ++i) m.insert(throw_map::value_type(i * 2, Thrower(i)));
+    //插入时拷贝抛出：表不变
+    Thrower::countdown = 0;
+    bool thrown = false;
+    try{
+        m.insert(throw_map::value_type(1, Thrower(-1)));
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && m.size() == 200 && m.count(1) == 0);
+    //拷贝构造中途抛出：已拷贝的结点全部释放
+    for(int n : {0, 1, 57, 199}){
+        Thrower::countdown = n;
+        thrown = false;
+        try{
+            throw_map copy(m);
+        }catch(int){
+            thrown = true;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown);
+    }
+    //赋值中途抛出：目标保持原状
+    throw_map target;
+    target.insert(throw_map::value_type(-5, Thrower(5)));
+    Thrower::countdown = 100;
+    thrown = false;
+    try{
+        target = m;
+    }catch(int){
+        thrown = true;
+    }
+    Thrower::countdown = -1;
+    CHECK(thrown && target.size() == 1 && target.at(-5).s == Thrower(5).s);
+    int expect = 0;
+    for(auto it = m.cbegin(); it != m.cend(); ++it, expect += 2) CHECK(it->first == expect);
+    return 0;
+}
+
+int main() {
+    if(TestDifferential()) return 1;
+    if(TestStableIterators()) return 1;
+    if(TestThrowingCopy()) return 1;
+    printf("topdown_map_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,45 @@
+////vector 加固模式的测试：重新分配或结构修改之后，旧迭代器的解引用、移动与相减
+////（包括 const_iterator 与 iterator 混合相减时的右操作数）都抛出 invalid_iterator。
+#define SJTU_VECTOR_HARDENED 1
+#include <cstdio>
+#include "vector.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+template<class F>
+static bool Throws(F f) {
+    try{
+        f();
+    }catch(sjtu::invalid_iterator &){
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    sjtu::vector<int> v;
+    for(int i = 0; i < 8; ++i) v.push_back(i);
+    sjtu::vector<int>::iterator it = v.begin() + 3;
+    sjtu::vector<int>::const_iterator cit = v.cbegin() + 5;
+    CHECK(*it == 3 && *cit == 5 && cit - it == 2);
+    CHECK(Throws([&]{ *(v.begin() + 8); }));
+    sjtu::vector<int>::iterator stale = v.begin();
+    sjtu::vector<int>::const_iterator cstale = v.cbegin();
+    v.insert(v.begin(), -1); //结构修改使旧迭代器失效
+    sjtu::vector<int>::iterator fresh = v.begin();
+    sjtu::vector<int>::const_iterator cfresh = v.cbegin();
+    CHECK(Throws([&]{ *stale; }));
+    CHECK(Throws([&]{ ++stale; }));
+    CHECK(Throws([&]{ *cstale; }));
+    CHECK(Throws([&]{ fresh - stale; }));
+    CHECK(Throws([&]{ stale - fresh; }));
+    CHECK(Throws([&]{ cstale - fresh; }));
+    CHECK(Throws([&]{ cfresh - stale; })); //右操作数失效也要检查
+    CHECK(cfresh - fresh == 0 && *(cfresh + 1) == 0);
+    //不同 vector 的迭代器相减
+    sjtu::vector<int> w;
+    w.push_back(1);
+    CHECK(Throws([&]{ v.cbegin() - w.begin(); }));
+    printf("vector_hardened_test: ok\n");
+    return 0;
+}
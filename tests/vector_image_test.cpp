@@ -0,0 +1,71 @@
+////vector 镜像的测试：写出后映射打开与原 vector 逐个对照；以及文件头被篡改
+////（类型不符、元素个数超出文件、偏移不按元素对齐）时打开失败。
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include "vector_image.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+static std::string TempPath(const char *name) {
+    return std::string("/tmp/") + name + "." + std::to_string(getpid());
+}
+
+//把文件头 offset 处的 8 字节改成 value
+static void Patch(const std::string &path, size_t offset, unsigned long long value) {
+    FILE *f = fopen(path.c_str(), "r+b");
+    fseek(f, (long) offset, SEEK_SET);
+    fwrite(&value, sizeof(value), 1, f);
+    fclose(f);
+}
+
+template<class M>
+static bool OpenFails(const std::string &path) {
+    try{
+        M m(path.c_str());
+    }catch(sjtu::runtime_error &){
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    std::string path = TempPath("vector_image_test");
+    sjtu::vector<double> v;
+    for(int i = 0; i < 100000; ++i) v.push_back(i * 0.5);
+    sjtu::write_image(v, path.c_str());
+    {
+        sjtu::mapped_vector<double> img(path.c_str());
+        CHECK(img.size() == v.size() && img.front() == 0 && img.back() == v.back());
+        for(size_t i = 0; i < v.size(); ++i) CHECK(img[i] == v[i]);
+        bool thrown = false;
+        try{
+            img.at(v.size());
+        }catch(sjtu::index_out_of_bound &){
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+    CHECK(OpenFails<sjtu::mapped_vector<long long>>(path) == false); //大小相同的类型无法区分
+    CHECK(OpenFails<sjtu::mapped_vector<float>>(path));
+    const size_t DataOffset = offsetof(sjtu::image_header, data_offset), Count = offsetof(sjtu::image_header, count);
+    Patch(path, Count, v.size() + 1);
+    CHECK(OpenFails<sjtu::mapped_vector<double>>(path));
+    Patch(path, Count, v.size() - 1);
+    Patch(path, DataOffset, sjtu::image_header::HeaderBytes + 4);
+    CHECK(OpenFails<sjtu::mapped_vector<double>>(path));
+    Patch(path, DataOffset, sjtu::image_header::HeaderBytes + 8);
+    {
+        sjtu::mapped_vector<double> img(path.c_str());
+        CHECK(img.size() == v.size() - 1 && img[0] == v[1]);
+    }
+    sjtu::write_image(sjtu::vector<double>(), path.c_str());
+    {
+        sjtu::mapped_vector<double> img(path.c_str());
+        CHECK(img.empty());
+    }
+    unlink(path.c_str());
+    printf("vector_image_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,219 @@
+////parallel.hpp 的测试：for_each / transform / reduce / scan / partition / sort / reserve 在 1、2、4、8 个线程下
+////与串行的 std 算法对照，规模覆盖空、不足一块、恰好整块与多块；sort 与 partition 检查稳定性，
+////浮点 reduce 检查结果与线程数无关；以及拷贝元素时抛出异常，异常传回调用方且不泄漏。
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "vector.hpp"
+#include "parallel.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+static const size_t Sizes[] = {0, 1, 33, 1000, sjtu::parallel_detail::Grain, sjtu::parallel_detail::Grain * 3 + 17, 200000};
+
+template<class T>
+static bool Same(const sjtu::vector<T> &v, const std::vector<T> &ref) {
+    if(v.size() != ref.size()) return false;
+    for(size_t i = 0; i < ref.size(); ++i)
+        if(!(v[i] == ref[i])) return false;
+    return true;
+}
+
+static void Fill(sjtu::vector<long long> &v, std::vector<long long> &ref, size_t n, std::mt19937 &rng) {
+    v.clear();
+    ref.clear();
+    for(size_t i = 0; i < n; ++i){
+        long long x = (long long) (rng() % 1000) - 500;
+        v.push_back(x);
+        ref.push_back(x);
+    }
+}
+
+static int TestElementwise(sjtu::thread_pool &pool) {
+    std::mt19937 rng(23);
+    sjtu::vector<long long> v;
+    std::vector<long long> ref;
+    for(size_t n : Sizes){
+        Fill(v, ref, n, rng);
+        sjtu::parallel_for_each(pool, v, [](long long &x){ x = x * 3 + 1; });
+        for(auto &x : ref) x = x * 3 + 1;
+        CHECK(Same(v, ref));
+        sjtu::parallel_transform(pool, v, [](long long x){ return x - 7; });
+        for(auto &x : ref) x -= 7;
+        CHECK(Same(v, ref));
+        sjtu::vector<double> out;
+        for(size_t i = 0; i < n + 5; ++i) out.push_back(-1);
+        sjtu::parallel_transform(pool, v, out, [](long long x){ return x * 0.5; });
+        for(size_t i = 0; i < n; ++i) CHECK(out[i] == ref[i] * 0.5);
+        for(size_t i = n; i < n + 5; ++i) CHECK(out[i] == -1);
+    }
+    sjtu::vector<double> shorter;
+    bool thrown = false;
+    try{
+        sjtu::parallel_transform(pool, v, shorter, [](long long x){ return (double) x; });
+    }catch(sjtu::index_out_of_bound &){
+        thrown = true;
+    }
+    CHECK(thrown == !v.empty());
+    return 0;
+}
+
+static int TestReduceScan(sjtu::thread_pool &pool) {
+    std::mt19937 rng(29);
+    sjtu::vector<long long> v;
+    std::vector<long long> ref;
+    for(size_t n : Sizes){
+        Fill(v, ref, n, rng);
+        CHECK(sjtu::parallel_reduce(pool, v, 10LL, [](long long a, long long b){ return a + b; })
+              == std::accumulate(ref.begin(), ref.end(), 10LL));
+        long long squares = 0;
+        for(long long x : ref) squares += x * x;
+        CHECK(sjtu::parallel_reduce(pool, v, 0LL, [](long long acc, const long long &x){ return acc + x * x; },
+                                    [](long long a, long long b){ return a + b; }) == squares);
+
+        sjtu::vector<long long> w(v);
+        std::vector<long long> expect(ref.size());
+        sjtu::parallel_inclusive_scan(pool, w, [](long long a, long long b){ return a + b; });
+        std::partial_sum(ref.begin(), ref.end(), expect.begin());
+        CHECK(Same(w, expect));
+
+        w = v;
+        sjtu::parallel_exclusive_scan(pool, w, 5LL, [](long long a, long long b){ return a + b; });
+        long long acc = 5;
+        for(size_t i = 0; i < ref.size(); ++i){
+            expect[i] = acc;
+            acc += ref[i];
+        }
+        CHECK(Same(w, expect));
+    }
+    return 0;
+}
+
+//分块方式与线程数无关，浮点求和在不同线程数下逐位相同
+static int TestDeterministic(sjtu::thread_pool &pool, double &firstSum) {
+    std::mt19937 rng(31);
+    sjtu::vector<double> v;
+    for(int i = 0; i < 150000; ++i) v.push_back((double) rng() / 3e7 - 71.5);
+    double sum = sjtu::parallel_reduce(pool, v, 0.0, [](double a, double b){ return a + b; });
+    if(pool.size() == 1) firstSum = sum;
+    CHECK(sum == firstSum);
+    return 0;
+}
+
+static int TestPartitionSort(sjtu::thread_pool &pool) {
+    std::mt19937 rng(37);
+    for(size_t n : Sizes){
+        //键值重复很多，用第二维记录原位置检查稳定性
+        sjtu::vector<std::pair<int, int>> v;
+        std::vector<std::pair<int, int>> ref;
+        for(size_t i = 0; i < n; ++i){
+            std::pair<int, int> x((int) (rng() % 50), (int) i);
+            v.push_back(x);
+            ref.push_back(x);
+        }
+        sjtu::vector<std::pair<int, int>> w(v);
+        auto byKey = [](const std::pair<int, int> &a, const std::pair<int, int> &b){ return a.first < b.first; };
+        sjtu::parallel_sort(pool, w, byKey);
+        std::vector<std::pair<int, int>> expect(ref);
+        std::stable_sort(expect.begin(), expect.end(), byKey);
+        CHECK(Same(w, expect));
+
+        w = v;
+        auto even = [](const std::pair<int, int> &x){ return x.first % 2 == 0; };
+        size_t good = sjtu::parallel_partition(pool, w, even);
+        expect = ref;
+        auto mid = std::stable_partition(expect.begin(), expect.end(), even);
+        CHECK(good == (size_t) (mid - expect.begin()) && Same(w, expect));
+
+        sjtu::vector<std::string> s;
+        std::vector<std::string> sref;
+        for(size_t i = 0; i < n && i < 5000; ++i){
+            s.push_back(std::to_string(rng() % 100000));
+            sref.push_back(s.back());
+        }
+        sjtu::parallel_sort(pool, s);
+        std::stable_sort(sref.begin(), sref.end());
+        CHECK(Same(s, sref));
+    }
+    return 0;
+}
+
+static int TestReserve(sjtu::thread_pool &pool) {
+    sjtu::vector<int> v;
+    for(int i = 0; i < 100; ++i) v.push_back(i);
+    sjtu::parallel_reserve(pool, v, 300000);
+    CHECK(v.capacity() >= 300000 && v.size() == 100);
+    for(int i = 0; i < 100; ++i) CHECK(v[i] == i);
+    for(int i = 100; i < 300000; ++i) v.push_back(i);
+    CHECK(v[299999] == 299999);
+    sjtu::parallel_reserve(pool, v, 10);
+    CHECK(v.size() == 300000);
+    return 0;
+}
+
+//拷贝到第 countdown 次时抛出异常（countdown 为负表示不抛）；多线程同时拷贝，计数用原子变量
+struct Thrower {
+    static std::atomic<int> countdown;
+    std::string s;
+    int key = 0;
+    Thrower() {}
+    explicit Thrower(int x) : s(std::string(32, 't') + std::to_string(x)), key(x) {}
+    Thrower(const Thrower &o) : s(o.s), key(o.key) {
+        if(countdown.load() >= 0 && countdown.fetch_sub(1) == 0) throw 1;
+    }
+    Thrower &operator=(const Thrower &o) = default;
+    bool operator<(const Thrower &o) const { return key < o.key; }
+};
+std::atomic<int> Thrower::countdown(-1);
+
+static int TestThrowingCopy(sjtu::thread_pool &pool) {
+    sjtu::vector<Thrower> v;
+    std::mt19937 rng(41);
+    for(int i = 0; i < 40000; ++i) v.push_back(Thrower((int) (rng() % 1000)));
+    for(int n : {0, 100, 39999}){
+        int thrown = 0;
+        Thrower::countdown = n;
+        try{
+            sjtu::parallel_sort(pool, v);
+        }catch(int){
+            ++thrown;
+        }
+        Thrower::countdown = n;
+        try{
+            sjtu::parallel_partition(pool, v, [](const Thrower &x){ return x.key % 3 == 0; });
+        }catch(int){
+            ++thrown;
+        }
+        Thrower::countdown = -1;
+        CHECK(thrown == 2 && v.size() == 40000);
+    }
+    //抛出后元素仍可正常使用
+    sjtu::parallel_sort(pool, v);
+    for(size_t i = 1; i < v.size(); ++i) CHECK(!(v[i] < v[i - 1]));
+    return 0;
+}
+
+int main() {
+    double firstSum = 0;
+    for(size_t t : {1, 2, 4, 8}){
+        sjtu::thread_pool pool(t);
+        if(TestElementwise(pool)) return 1;
+        if(TestReduceScan(pool)) return 1;
+        if(TestDeterministic(pool, firstSum)) return 1;
+        if(TestPartitionSort(pool)) return 1;
+        if(TestReserve(pool)) return 1;
+        if(TestThrowingCopy(pool)) return 1;
+    }
+    //不传线程池的重载使用全局线程池
+    sjtu::vector<long long> v;
+    for(int i = 0; i < 50000; ++i) v.push_back(i);
+    sjtu::parallel_sort(v, [](long long a, long long b){ return a > b; });
+    CHECK(v[0] == 49999 && sjtu::parallel_reduce(v, 0LL, [](long long a, long long b){ return a + b; }) == 49999LL * 50000 / 2);
+    printf("vector_parallel_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,79 @@
+////vector 的测试：容量为 0 的 vector 不申请内存且可以正常增长，
+////以及随机的 push_back / insert / erase / pop_back 与 std::vector 对照。
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "vector.hpp"
+
+#define CHECK(cond) do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } }while(0)
+
+static int TestZeroCapacity() {
+    sjtu::vector<std::string> v(0);
+    CHECK(v.data() == nullptr && v.capacity() == 0 && v.empty() && v.begin() == v.end());
+    v.reserve(0);
+    CHECK(v.data() == nullptr);
+    sjtu::vector<std::string> copy(v), assigned;
+    assigned = v;
+    CHECK(copy.data() == nullptr && assigned.data() == nullptr && assigned.capacity() == 0);
+    for(int i = 0; i < 100; ++i) v.push_back(std::to_string(i));
+    CHECK(v.size() == 100 && v.capacity() >= 100);
+    for(int i = 0; i < 100; ++i) CHECK(v[i] == std::to_string(i));
+    sjtu::vector<int> a(0), b(0);
+    a.insert(a.begin(), 1);
+    b.insert(0, 2);
+    CHECK(a.size() == 1 && a[0] == 1 && b.size() == 1 && b[0] == 2);
+    sjtu::vector<int> one(1);
+    one.push_back(7);
+    one.push_back(8);
+    CHECK(one.size() == 2 && one[1] == 8);
+    sjtu::vector<int> r(0);
+    r.reserve(5);
+    CHECK(r.capacity() >= 5);
+    return 0;
+}
+
+static int TestDifferential() {
+    //insert / erase 对元素做赋值移动，这里用平凡类型
+    sjtu::vector<int> v(0);
+    std::vector<int> ref;
+    std::mt19937 rng(1);
+    for(int step = 0; step < 20000; ++step){
+        int op = (int) (rng() % 6);
+        int s = (int) (rng() % 1000);
+        if(op < 2){
+            v.push_back(s);
+            ref.push_back(s);
+        }
+        else if(op == 2){
+            size_t pos = rng() % (ref.size() + 1);
+            v.insert(pos, s);
+            ref.insert(ref.begin() + pos, s);
+        }
+        else if(op == 3 && !ref.empty()){
+            size_t pos = rng() % ref.size();
+            v.erase(v.begin() + pos);
+            ref.erase(ref.begin() + pos);
+        }
+        else if(op == 4 && !ref.empty()){
+            v.pop_back();
+            ref.pop_back();
+        }
+        else if(op == 5 && rng() % 100 == 0){
+            sjtu::vector<int> copy(v);
+            v = copy;
+        }
+        CHECK(v.size() == ref.size() && v.capacity() >= v.size());
+        if(step % 1000 == 0)
+            for(size_t i = 0; i < ref.size(); ++i) CHECK(v[i] == ref[i]);
+    }
+    for(size_t i = 0; i < ref.size(); ++i) CHECK(v[i] == ref[i]);
+    return 0;
+}
+
+int main() {
+    if(TestZeroCapacity()) return 1;
+    if(TestDifferential()) return 1;
+    printf("vector_test: ok\n");
+    return 0;
+}
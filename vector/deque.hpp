@@ -0,0 +1,375 @@
+////分块的双端队列
+////元素存放在固定大小的块中，块指针放在一个环形的块表里。
+////两端插入删除都是 O(1)：只在端点的块用完时分配或释放一个块，
+////块表满时只拷贝块指针，元素本身从不移动，因此已有元素的地址在两端增长时保持不变。
+#ifndef SJTU_DEQUE_HPP
+#define SJTU_DEQUE_HPP
+
+#include "exceptions.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <iterator>
+
+namespace sjtu
+{
+    template<typename T>
+    class deque
+    {
+    private:
+        //每块约 4KB，至少 16 个元素
+        static const size_t ChunkSize = sizeof(T) * 16 > 4096 ? 16 : 4096 / sizeof(T);
+
+        T **chunks; //环形块表，容量为 2 的幂
+        size_t mapCap;
+        size_t first; //第一个块在块表中的下标
+        size_t chunkNum;
+        size_t head; //第一个元素在第一个块内的偏移
+        size_t num;
+        T *spare; //最近释放的一个块，在同一端反复进出时避免频繁分配
+
+        T *Chunk(size_t k) const {
+            return chunks[(first + k) & (mapCap - 1)];
+        }
+        T *Address(size_t pos) const {
+            size_t g = head + pos;
+            return Chunk(g / ChunkSize) + g % ChunkSize;
+        }
+        T *NewChunk() {
+            T *res = spare;
+            spare = nullptr;
+            if(!res){
+                res = (T*)malloc(ChunkSize * sizeof(T));
+                if(!res) throw std::bad_alloc();
+            }
+            return res;
+        }
+        void DelChunk(T *p) {
+            if(spare) free(spare);
+            spare = p;
+        }
+        //块表已满时扩容一倍，按逻辑顺序重排到新表开头
+        void GrowMap() {
+            if(chunkNum < mapCap) return;
+            T **tmp = (T**)malloc(mapCap * 2 * sizeof(T*));
+            if(!tmp) throw std::bad_alloc();
+            for(size_t i = 0; i < chunkNum; ++i) tmp[i] = Chunk(i);
+            free(chunks);
+            chunks = tmp;
+            mapCap *= 2;
+            first = 0;
+        }
+        void Init() {
+            mapCap = 8;
+            chunks = (T**)malloc(mapCap * sizeof(T*));
+            if(!chunks) throw std::bad_alloc();
+            first = chunkNum = head = num = 0;
+            spare = nullptr;
+        }
+        void Release() {
+            clear();
+            for(size_t i = 0; i < chunkNum; ++i) free(Chunk(i));
+            if(spare) free(spare);
+            free(chunks);
+        }
+
+    public:
+        class const_iterator;
+        class iterator
+        {
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+            using iterator_category = std::random_access_iterator_tag;
+
+        private:
+            size_t pos;
+            deque* from;
+            friend class deque;
+            friend class const_iterator;
+
+        public:
+            iterator() : pos(0), from(nullptr) {}
+            iterator(size_t tmp_pos, deque* tmp_from) : pos(tmp_pos), from(tmp_from) {}
+            iterator operator+(const int &n) const {
+                return iterator(pos + n, from);
+            }
+            iterator operator-(const int &n) const {
+                return iterator(pos - n, from);
+            }
+            // if these two iterators point to different deques, throw invaild_iterator.
+            int operator-(const iterator &rhs) const {
+                if(from != rhs.from) throw invalid_iterator();
+                return (int)pos - (int)rhs.pos;
+            }
+            iterator& operator+=(const int &n) {
+                pos += n;
+                return *this;
+            }
+            iterator& operator-=(const int &n) {
+                pos -= n;
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator tmp(*this);
+                pos++;
+                return tmp;
+            }
+            iterator& operator++() {
+                pos++;
+                return *this;
+            }
+            iterator operator--(int) {
+                iterator tmp(*this);
+                pos--;
+                return tmp;
+            }
+            iterator& operator--() {
+                pos--;
+                return *this;
+            }
+            T& operator*() const {
+                if(!from || pos >= from->num) throw invalid_iterator();
+                return *from->Address(pos);
+            }
+            T* operator->() const {
+                return &**this;
+            }
+            T& operator[](const int &n) const {
+                return *(*this + n);
+            }
+            bool operator==(const iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator==(const const_iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator<(const iterator &rhs) const {
+                return pos < rhs.pos;
+            }
+        };
+        class const_iterator
+        {
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = const T*;
+            using reference = const T&;
+            using iterator_category = std::random_access_iterator_tag;
+
+        private:
+            size_t pos;
+            const deque* from;
+            friend class deque;
+            friend class iterator;
+
+        public:
+            const_iterator() : pos(0), from(nullptr) {}
+            const_iterator(size_t tmp_pos, const deque* tmp_from) : pos(tmp_pos), from(tmp_from) {}
+            const_iterator(const iterator &rhs) : pos(rhs.pos), from(rhs.from) {}
+            const_iterator operator+(const int &n) const {
+                return const_iterator(pos + n, from);
+            }
+            const_iterator operator-(const int &n) const {
+                return const_iterator(pos - n, from);
+            }
+            int operator-(const const_iterator &rhs) const {
+                if(from != rhs.from) throw invalid_iterator();
+                return (int)pos - (int)rhs.pos;
+            }
+            const_iterator& operator+=(const int &n) {
+                pos += n;
+                return *this;
+            }
+            const_iterator& operator-=(const int &n) {
+                pos -= n;
+                return *this;
+            }
+            const_iterator operator++(int) {
+                const_iterator tmp(*this);
+                pos++;
+                return tmp;
+            }
+            const_iterator& operator++() {
+                pos++;
+                return *this;
+            }
+            const_iterator operator--(int) {
+                const_iterator tmp(*this);
+                pos--;
+                return tmp;
+            }
+            const_iterator& operator--() {
+                pos--;
+                return *this;
+            }
+            const T& operator*() const {
+                if(!from || pos >= from->num) throw invalid_iterator();
+                return *from->Address(pos);
+            }
+            const T* operator->() const {
+                return &**this;
+            }
+            const T& operator[](const int &n) const {
+                return *(*this + n);
+            }
+            bool operator==(const iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator==(const const_iterator &rhs) const {
+                return from == rhs.from && pos == rhs.pos;
+            }
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator<(const const_iterator &rhs) const {
+                return pos < rhs.pos;
+            }
+        };
+
+        deque() {
+            Init();
+        }
+        deque(const deque &other) {
+            Init();
+            try{
+                for(size_t i = 0; i < other.num; ++i) push_back(other[i]);
+            }catch(...){
+                Release();
+                throw;
+            }
+        }
+        ~deque() {
+            Release();
+        }
+        deque &operator=(const deque &other) {
+            if(&other != this){
+                clear();
+                for(size_t i = 0; i < other.num; ++i) push_back(other[i]);
+            }
+            return *this;
+        }
+        /**
+         * access specified element with bounds checking
+         * throw index_out_of_bound if pos is not in [0, size)
+         */
+        T & at(const size_t &pos) {
+            if(pos >= num) throw index_out_of_bound();
+            return *Address(pos);
+        }
+        const T & at(const size_t &pos) const {
+            if(pos >= num) throw index_out_of_bound();
+            return *Address(pos);
+        }
+        T & operator[](const size_t &pos) {
+            if(pos >= num) throw index_out_of_bound();
+            return *Address(pos);
+        }
+        const T & operator[](const size_t &pos) const {
+            if(pos >= num) throw index_out_of_bound();
+            return *Address(pos);
+        }
+        /**
+         * throw container_is_empty if size == 0
+         */
+        const T & front() const {
+            if(!num) throw container_is_empty();
+            return *Address(0);
+        }
+        const T & back() const {
+            if(!num) throw container_is_empty();
+            return *Address(num - 1);
+        }
+        iterator begin() { return iterator(0, this); }
+        const_iterator cbegin() const { return const_iterator(0, this); }
+        iterator end() { return iterator(num, this); }
+        const_iterator cend() const { return const_iterator(num, this); }
+        bool empty() const { return !num; }
+        size_t size() const { return num; }
+        /**
+         * 清空元素，保留块表和已分配的块
+         */
+        void clear() {
+            while(num) pop_back();
+        }
+        void push_back(const T &value) {
+            size_t g = head + num;
+            if(g == chunkNum * ChunkSize){
+                //先在新块里构造，成功后再挂到表尾，构造抛异常时结构不变
+                GrowMap();
+                T *c = NewChunk();
+                try{
+                    new (c) T(value);
+                }catch(...){
+                    DelChunk(c);
+                    throw;
+                }
+                chunks[(first + chunkNum) & (mapCap - 1)] = c;
+                chunkNum++;
+            }
+            else new (Address(num)) T(value);
+            num++;
+        }
+        void push_front(const T &value) {
+            if(head == 0){
+                GrowMap();
+                T *c = NewChunk();
+                try{
+                    new (c + ChunkSize - 1) T(value);
+                }catch(...){
+                    DelChunk(c);
+                    throw;
+                }
+                first = (first + mapCap - 1) & (mapCap - 1);
+                chunks[first] = c;
+                chunkNum++;
+                head = ChunkSize;
+            }
+            else new (Chunk(0) + head - 1) T(value);
+            head--;
+            num++;
+        }
+        /**
+         * throw container_is_empty if size == 0
+         */
+        void pop_back() {
+            if(!num) throw container_is_empty();
+            Address(num - 1)->~T();
+            num--;
+            //末尾的块空了就归还
+            if(chunkNum && head + num <= (chunkNum - 1) * ChunkSize){
+                chunkNum--;
+                DelChunk(Chunk(chunkNum));
+                if(!chunkNum) head = 0;
+            }
+        }
+        void pop_front() {
+            if(!num) throw container_is_empty();
+            Address(0)->~T();
+            head++;
+            num--;
+            if(head == ChunkSize || !num){
+                //第一个块空了就归还；队列清空时所有元素都在这个块里
+                DelChunk(Chunk(0));
+                first = (first + 1) & (mapCap - 1);
+                chunkNum--;
+                head = 0;
+            }
+        }
+    };
+
+}
+
+#endif
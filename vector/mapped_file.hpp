@@ -0,0 +1,218 @@
+////容器二进制镜像的公共部分：文件头、只读内存映射、顺序写入器（仅支持 POSIX）
+////镜像只适用于可平凡复制（trivially copyable）的元素，文件内容即内存布局，
+////打开时用 mmap 映射后直接在文件上查找、遍历，不需要反序列化。
+////镜像按写入方机器的字节序与对齐保存，只能在同构的机器之间使用。
+#ifndef SJTU_MAPPED_FILE_HPP
+#define SJTU_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    enum image_kind { VECTOR_IMAGE = 1, MAP_IMAGE = 2, LINKED_HASHMAP_IMAGE = 3 };
+
+    struct image_header {
+        char magic[8]; //"SJTUIMG"
+        unsigned int version;
+        unsigned int kind; //image_kind
+        unsigned long long key_size, mapped_size, elem_size; //用于打开时校验类型
+        unsigned long long count; //元素个数
+        unsigned long long data_offset; //元素数组的起始偏移
+        unsigned long long index_offset, index_slots; //哈希索引（仅 linked_hashmap）
+        static const unsigned long long HeaderBytes = 128; //文件头占用的字节数，元素数组从这里开始
+        static const unsigned int Version = 1;
+
+        void init(image_kind k, unsigned long long keySize, unsigned long long mappedSize, unsigned long long elemSize){
+            memset(this, 0, sizeof(image_header));
+            memcpy(magic, "SJTUIMG", 8);
+            version = Version;
+            kind = k;
+            key_size = keySize;
+            mapped_size = mappedSize;
+            elem_size = elemSize;
+            data_offset = HeaderBytes;
+        }
+        bool match(image_kind k, unsigned long long keySize, unsigned long long mappedSize, unsigned long long elemSize) const {
+            return !memcmp(magic, "SJTUIMG", 8) && version == Version && kind == (unsigned int) k &&
+                   key_size == keySize && mapped_size == mappedSize && elem_size == elemSize;
+        }
+    };
+
+    static_assert(sizeof(image_header) <= image_header::HeaderBytes, "image header too large");
+
+    /**
+     * 只读映射整个文件，析构时解除映射
+     */
+    class mapped_file {
+    private:
+        void *addr = nullptr;
+        size_t len = 0;
+    public:
+        mapped_file() {}
+        explicit mapped_file(const char *path) {
+            open(path);
+        }
+        mapped_file(const mapped_file &) = delete;
+        mapped_file &operator = (const mapped_file &) = delete;
+        ~mapped_file() {
+            close();
+        }
+        void open(const char *path) {
+            close();
+            int fd = ::open(path, O_RDONLY);
+            if(fd < 0) throw runtime_error();
+            struct stat st;
+            if(fstat(fd, &st) != 0 || st.st_size < (off_t) image_header::HeaderBytes){
+                ::close(fd);
+                throw runtime_error();
+            }
+            len = (size_t) st.st_size;
+            addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd); //映射建立后文件描述符不再需要
+            if(addr == MAP_FAILED){
+                addr = nullptr;
+                len = 0;
+                throw runtime_error();
+            }
+        }
+        void close() {
+            if(addr) munmap(addr, len);
+            addr = nullptr;
+            len = 0;
+        }
+        /**
+         * 校验文件头，并检查 [data_offset, data_offset + count * elem_size) 与索引区都在文件范围内，
+         * 且 data_offset 是 elemAlign 的倍数（映射的起始地址按页对齐，偏移对齐即地址对齐）
+         */
+        const image_header &header(image_kind k, unsigned long long keySize, unsigned long long mappedSize, unsigned long long elemSize,
+                                   size_t elemAlign) const {
+            if(!addr) throw runtime_error();
+            const image_header &h = *static_cast<const image_header *>(addr);
+            if(!h.match(k, keySize, mappedSize, elemSize) || h.data_offset > len || h.data_offset % elemAlign ||
+               (len - h.data_offset) / elemSize < h.count)
+                throw runtime_error();
+            if(h.index_slots && (h.index_offset > len || (len - h.index_offset) / (2 * sizeof(unsigned long long)) < h.index_slots))
+                throw runtime_error();
+            return h;
+        }
+        const char *data() const {
+            return static_cast<const char *>(addr);
+        }
+        size_t size() const {
+            return len;
+        }
+        /**
+         * 提示内核访问模式，例如顺序扫描时传入 MADV_SEQUENTIAL
+         */
+        void advise(int advice) const {
+            if(addr) madvise(addr, len, advice);
+        }
+    };
+
+    /**
+     * 带缓冲的顺序写入器：先写占位文件头，元素顺序追加，finish 时回填文件头。
+     * 内存占用只有缓冲区大小，可以写出比内存更大的镜像。
+     * 只有 finish 成功才会写入有效的文件头；未 finish 就析构时删除文件，不留下残缺的镜像。
+     */
+    class image_writer {
+    private:
+        int fd = -1;
+        std::string path;
+        unsigned long long written = 0; //已交给缓冲区的总字节数（即当前文件偏移）
+        size_t used = 0;
+        static const size_t BufferSize = 1 << 20;
+        char *buf = nullptr;
+
+        void WriteAll(const char *p, size_t n) {
+            while(n){
+                ssize_t res = ::write(fd, p, n);
+                if(res < 0) throw runtime_error();
+                p += res;
+                n -= (size_t) res;
+            }
+        }
+    public:
+        image_header header;
+
+        image_writer() {}
+        image_writer(const image_writer &) = delete;
+        image_writer &operator = (const image_writer &) = delete;
+        ~image_writer() {
+            abandon();
+            delete []buf;
+        }
+        void open(const char *file) {
+            fd = ::open(file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if(fd < 0) throw runtime_error();
+            path = file;
+            buf = new char[BufferSize];
+            char zero[image_header::HeaderBytes] = {};
+            write(zero, sizeof(zero));
+        }
+        bool is_open() const {
+            return fd >= 0;
+        }
+        void write(const void *src, size_t n) {
+            const char *p = static_cast<const char *>(src);
+            written += n;
+            if(used + n > BufferSize){
+                flush();
+                if(n >= BufferSize){
+                    WriteAll(p, n);
+                    return;
+                }
+            }
+            memcpy(buf + used, p, n);
+            used += n;
+        }
+        void flush() {
+            WriteAll(buf, used);
+            used = 0;
+        }
+        unsigned long long offset() const {
+            return written;
+        }
+        //补零到 align 字节对齐
+        void pad(unsigned long long align) {
+            static const char zero[64] = {};
+            while(written % align)
+                write(zero, (size_t) (align - written % align < 64 ? align - written % align : 64));
+        }
+        int descriptor() const {
+            return fd;
+        }
+        /**
+         * 回填文件头并关闭文件
+         */
+        void finish() {
+            flush();
+            if(pwrite(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header))
+                throw runtime_error();
+            if(::close(fd) != 0){
+                fd = -1;
+                ::unlink(path.c_str()); //关闭失败时数据可能没有落盘，不能留下看似有效的镜像
+                throw runtime_error();
+            }
+            fd = -1;
+        }
+        /**
+         * 放弃写入：关闭并删除文件
+         */
+        void abandon() {
+            if(fd < 0) return;
+            ::close(fd);
+            fd = -1;
+            ::unlink(path.c_str());
+        }
+    };
+
+}
+
+#endif
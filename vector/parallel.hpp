@@ -0,0 +1,453 @@
+////sjtu::vector 上的并行算法，基于 thread_pool.hpp 的工作窃取线程池
+////所有算法都按固定的块大小 Grain 切分，切分方式与线程数无关，
+////因此 reduce / scan 对浮点数等非严格结合的运算也能在不同线程数下得到相同结果；
+////sort 是稳定排序，partition 是稳定划分，结果唯一确定。
+////不传线程池的重载使用 thread_pool::global()。
+#ifndef SJTU_PARALLEL_HPP
+#define SJTU_PARALLEL_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <functional>
+#include "vector.hpp"
+#include "thread_pool.hpp"
+
+namespace sjtu {
+
+    namespace parallel_detail {
+        const size_t Grain = 1 << 14; //每个任务处理的元素个数
+        const size_t SortRun = 32; //排序时先用插入排序排好的初始段长度
+
+        inline size_t Blocks(size_t n) {
+            return (n + Grain - 1) / Grain;
+        }
+
+        //未初始化的临时数组，拷贝构造出 n 个元素，析构时逐个销毁
+        template<class T>
+        struct Buffer {
+            T *array;
+            size_t constructed = 0;
+            explicit Buffer(size_t n) {
+                array = (T *) malloc(n * sizeof(T));
+                if(n && !array) throw std::bad_alloc();
+            }
+            Buffer(const Buffer &) = delete;
+            Buffer &operator = (const Buffer &) = delete;
+            ~Buffer() {
+                for(size_t i = 0; i < constructed; ++i) array[i].~T();
+                free(array);
+            }
+        };
+
+        /**
+         * 在线程池里并行地往 Buffer 里拷贝构造时，记录哪些块已经整块构造完毕。
+         * 某块的拷贝抛出异常时该块自己销毁已构造的部分，其他块可能已经完成，
+         * 由调用方在 pool.run 抛出后按 done 逐块销毁，再重新抛出
+         */
+        struct BlockFlags {
+            unsigned char *done;
+            explicit BlockFlags(size_t blocks) {
+                done = (unsigned char *) calloc(blocks ? blocks : 1, 1);
+                if(!done) throw std::bad_alloc();
+            }
+            BlockFlags(const BlockFlags &) = delete;
+            BlockFlags &operator = (const BlockFlags &) = delete;
+            ~BlockFlags() {
+                free(done);
+            }
+        };
+
+        template<class T, class Compare>
+        void InsertionSort(T *first, T *last, Compare &comp) {
+            for(T *i = first + 1; i < last; ++i){
+                if(!comp(*i, *(i - 1))) continue;
+                T tmp(*i);
+                T *j = i;
+                for(; j > first && comp(tmp, *(j - 1)); --j) *j = *(j - 1);
+                *j = tmp;
+            }
+        }
+
+        /**
+         * 归并路径划分：a、b 稳定归并后的前 d 个元素中有多少个来自 a
+         */
+        template<class T, class Compare>
+        size_t MergeSplit(const T *a, size_t na, const T *b, size_t nb, size_t d, Compare &comp) {
+            size_t lo = d > nb ? d - nb : 0, hi = d < na ? d : na;
+            while(lo < hi){
+                size_t mid = (lo + hi) >> 1;
+                if(comp(b[d - mid - 1], a[mid])) hi = mid;
+                else lo = mid + 1;
+            }
+            return lo;
+        }
+
+        //相等时先取 a，保证稳定
+        template<class T, class Compare>
+        void MergeRange(const T *a, const T *aEnd, const T *b, const T *bEnd, T *out, Compare &comp) {
+            while(a != aEnd && b != bEnd)
+                *out++ = comp(*b, *a) ? *b++ : *a++;
+            while(a != aEnd) *out++ = *a++;
+            while(b != bEnd) *out++ = *b++;
+        }
+    }
+
+    /**
+     * 对每个元素调用 f(T &)
+     */
+    template<class T, class F>
+    void parallel_for_each(thread_pool &pool, vector<T> &v, F f) {
+        T *array = v.data();
+        size_t n = v.size();
+        pool.run(parallel_detail::Blocks(n), [&](size_t blk){
+            size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+            for(size_t i = l; i < r; ++i) f(array[i]);
+        });
+    }
+
+    /**
+     * out[i] = f(in[i])，out 的长度不能小于 in，否则抛出 index_out_of_bound
+     */
+    template<class T, class U, class F>
+    void parallel_transform(thread_pool &pool, const vector<T> &in, vector<U> &out, F f) {
+        if(out.size() < in.size()) throw index_out_of_bound();
+        const T *src = in.data();
+        U *dst = out.data();
+        size_t n = in.size();
+        pool.run(parallel_detail::Blocks(n), [&](size_t blk){
+            size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+            for(size_t i = l; i < r; ++i) dst[i] = f(src[i]);
+        });
+    }
+
+    /**
+     * 原地变换 v[i] = f(v[i])
+     */
+    template<class T, class F>
+    void parallel_transform(thread_pool &pool, vector<T> &v, F f) {
+        parallel_for_each(pool, v, [&](T &x){ x = f(x); });
+    }
+
+    /**
+     * 以 init 为初值用 op 归约。op 须满足结合律，且能作用于 (U, U)，元素先转换成 U 再参与运算：
+     * 每块从块内第一个元素开始从左到右折叠，再从 init 开始按块的顺序折叠各块的结果。
+     * 块内与块间的运算不同时（例如对平方求和），使用带 identity 与 combine 的重载
+     */
+    template<class T, class U, class BinaryOp>
+    U parallel_reduce(thread_pool &pool, const vector<T> &v, U init, BinaryOp op) {
+        const T *array = v.data();
+        size_t n = v.size(), blocks = parallel_detail::Blocks(n);
+        if(blocks <= 1){
+            if(!n) return init;
+            U acc(array[0]);
+            for(size_t i = 1; i < n; ++i) acc = op(acc, array[i]);
+            return op(init, acc);
+        }
+        parallel_detail::Buffer<U> partial(blocks);
+        parallel_detail::BlockFlags built(blocks);
+        try{
+            pool.run(blocks, [&](size_t blk){
+                size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+                U acc(array[l]);
+                for(size_t i = l + 1; i < r; ++i) acc = op(acc, array[i]);
+                new(partial.array + blk) U(acc);
+                built.done[blk] = 1;
+            });
+        }catch(...){
+            for(size_t i = 0; i < blocks; ++i)
+                if(built.done[i]) partial.array[i].~U();
+            throw;
+        }
+        partial.constructed = blocks;
+        for(size_t i = 0; i < blocks; ++i) init = op(init, partial.array[i]);
+        return init;
+    }
+
+    /**
+     * 每块从 identity 开始用 fold(U, const T &) 折叠，再从 identity 开始按块的顺序用 combine(U, U) 合并。
+     * identity 须是 combine 的单位元，combine 须满足结合律；fold 不必能作用于 (U, U)
+     */
+    template<class T, class U, class Fold, class Combine>
+    U parallel_reduce(thread_pool &pool, const vector<T> &v, U identity, Fold fold, Combine combine) {
+        const T *array = v.data();
+        size_t n = v.size(), blocks = parallel_detail::Blocks(n);
+        if(blocks <= 1){
+            U acc(identity);
+            for(size_t i = 0; i < n; ++i) acc = fold(acc, array[i]);
+            return combine(identity, acc);
+        }
+        parallel_detail::Buffer<U> partial(blocks);
+        parallel_detail::BlockFlags built(blocks);
+        try{
+            pool.run(blocks, [&](size_t blk){
+                size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+                U acc(identity);
+                for(size_t i = l; i < r; ++i) acc = fold(acc, array[i]);
+                new(partial.array + blk) U(acc);
+                built.done[blk] = 1;
+            });
+        }catch(...){
+            for(size_t i = 0; i < blocks; ++i)
+                if(built.done[i]) partial.array[i].~U();
+            throw;
+        }
+        partial.constructed = blocks;
+        U res(identity);
+        for(size_t i = 0; i < blocks; ++i) res = combine(res, partial.array[i]);
+        return res;
+    }
+
+    /**
+     * 原地包含式前缀和：v[i] = v[0] op v[1] op ... op v[i]
+     */
+    template<class T, class BinaryOp>
+    void parallel_inclusive_scan(thread_pool &pool, vector<T> &v, BinaryOp op) {
+        T *array = v.data();
+        size_t n = v.size(), blocks = parallel_detail::Blocks(n);
+        if(!n) return;
+        //第一遍：各块独立做块内前缀和
+        pool.run(blocks, [&](size_t blk){
+            size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+            for(size_t i = l + 1; i < r; ++i) array[i] = op(array[i - 1], array[i]);
+        });
+        if(blocks <= 1) return;
+        //串行求出每块之前所有元素的总和，块数很少。carry.array[k] 对应第 k + 1 块
+        parallel_detail::Buffer<T> carry(blocks - 1);
+        for(size_t blk = 1; blk < blocks; ++blk){
+            const T &tail = array[blk * parallel_detail::Grain - 1];
+            if(blk == 1) new(carry.array) T(tail);
+            else new(carry.array + blk - 1) T(op(carry.array[blk - 2], tail));
+            carry.constructed = blk;
+        }
+        //第二遍：把前缀加到各块上
+        pool.run(blocks - 1, [&](size_t k){
+            size_t blk = k + 1;
+            size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+            for(size_t i = l; i < r; ++i) array[i] = op(carry.array[k], array[i]);
+        });
+    }
+
+    /**
+     * 原地排除式前缀和：v[0] = init，v[i] = init op v[0] op ... op v[i - 1]
+     */
+    template<class T, class BinaryOp>
+    void parallel_exclusive_scan(thread_pool &pool, vector<T> &v, T init, BinaryOp op) {
+        T *array = v.data();
+        size_t n = v.size(), blocks = parallel_detail::Blocks(n);
+        if(!n) return;
+        //先保存每块的最后一个元素，再整体右移一位做包含式前缀和
+        parallel_detail::Buffer<T> last(blocks);
+        for(size_t blk = 0; blk < blocks; ++blk){
+            size_t r = (blk + 1) * parallel_detail::Grain < n ? (blk + 1) * parallel_detail::Grain : n;
+            new(last.array + blk) T(array[r - 1]);
+            last.constructed = blk + 1;
+        }
+        pool.run(blocks, [&](size_t blk){
+            size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+            for(size_t i = r - 1; i > l; --i) array[i] = array[i - 1];
+        });
+        for(size_t blk = 1; blk < blocks; ++blk)
+            array[blk * parallel_detail::Grain] = last.array[blk - 1];
+        array[0] = init;
+        parallel_inclusive_scan(pool, v, op);
+    }
+
+    /**
+     * 稳定划分：满足 pred 的元素移到前面，两部分内部保持原有相对顺序，返回满足 pred 的元素个数
+     */
+    template<class T, class Predicate>
+    size_t parallel_partition(thread_pool &pool, vector<T> &v, Predicate pred) {
+        T *array = v.data();
+        size_t n = v.size(), blocks = parallel_detail::Blocks(n);
+        if(!n) return 0;
+        size_t *good = new size_t[blocks + 1];
+        unsigned char *flag = (unsigned char *) malloc(n);
+        try{
+            if(!flag) throw std::bad_alloc();
+            pool.run(blocks, [&](size_t blk){
+                size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n, cnt = 0;
+                for(size_t i = l; i < r; ++i){
+                    flag[i] = pred(array[i]) ? 1 : 0; //每个元素只调用一次 pred
+                    cnt += flag[i];
+                }
+                good[blk + 1] = cnt;
+            });
+            good[0] = 0;
+            for(size_t blk = 0; blk < blocks; ++blk) good[blk + 1] += good[blk];
+            size_t total = good[blocks];
+            //先拷贝到临时数组的目标位置，再整体拷回。
+            //第 blk 块满足 pred 的元素放在 [good[blk], good[blk + 1])，其余的从 total + l - good[blk] 开始连续存放
+            parallel_detail::Buffer<T> tmp(n);
+            parallel_detail::BlockFlags built(blocks);
+            auto destroy = [&](size_t blk, size_t yes, size_t no){
+                size_t l = blk * parallel_detail::Grain;
+                for(size_t i = good[blk]; i < yes; ++i) tmp.array[i].~T();
+                for(size_t i = total + (l - good[blk]); i < no; ++i) tmp.array[i].~T();
+            };
+            try{
+                pool.run(blocks, [&](size_t blk){
+                    size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+                    size_t yes = good[blk], no = total + (l - good[blk]);
+                    try{
+                        for(size_t i = l; i < r; ++i){
+                            new(tmp.array + (flag[i] ? yes : no)) T(array[i]);
+                            ++(flag[i] ? yes : no);
+                        }
+                    }catch(...){
+                        destroy(blk, yes, no);
+                        throw;
+                    }
+                    built.done[blk] = 1;
+                });
+            }catch(...){
+                for(size_t blk = 0; blk < blocks; ++blk){
+                    if(!built.done[blk]) continue;
+                    size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+                    destroy(blk, good[blk + 1], total + (r - good[blk + 1]));
+                }
+                throw;
+            }
+            tmp.constructed = n;
+            pool.run(blocks, [&](size_t blk){
+                size_t l = blk * parallel_detail::Grain, r = l + parallel_detail::Grain < n ? l + parallel_detail::Grain : n;
+                for(size_t i = l; i < r; ++i) array[i] = tmp.array[i];
+            });
+            delete []good;
+            free(flag);
+            return total;
+        }catch(...){
+            delete []good;
+            free(flag);
+            throw;
+        }
+    }
+
+    /**
+     * 稳定的并行归并排序：先把长度为 SortRun 的段插入排序，再自底向上两两归并。
+     * 每一轮按输出位置切成 Grain 大小的任务，用归并路径在两段上定位起点，
+     * 因此最后几轮只剩一两对长段时仍能用满所有线程。
+     */
+    template<class T, class Compare = std::less<T>>
+    void parallel_sort(thread_pool &pool, vector<T> &v, Compare comp = Compare()) {
+        using namespace parallel_detail;
+        T *array = v.data();
+        size_t n = v.size();
+        if(n < 2) return;
+        pool.run(Blocks(n), [&](size_t blk){
+            size_t l = blk * Grain, r = l + Grain < n ? l + Grain : n;
+            for(size_t s = l; s < r; s += SortRun)
+                InsertionSort(array + s, array + (s + SortRun < r ? s + SortRun : r), comp);
+        });
+        if(n <= SortRun) return;
+        Buffer<T> buf(n);
+        BlockFlags built(Blocks(n));
+        try{
+            pool.run(Blocks(n), [&](size_t blk){
+                size_t l = blk * Grain, r = l + Grain < n ? l + Grain : n, i = l;
+                try{
+                    for(; i < r; ++i) new(buf.array + i) T(array[i]);
+                }catch(...){
+                    while(i-- > l) buf.array[i].~T();
+                    throw;
+                }
+                built.done[blk] = 1;
+            });
+        }catch(...){
+            for(size_t blk = 0; blk < Blocks(n); ++blk){
+                if(!built.done[blk]) continue;
+                size_t l = blk * Grain, r = l + Grain < n ? l + Grain : n;
+                for(size_t i = l; i < r; ++i) buf.array[i].~T();
+            }
+            throw;
+        }
+        buf.constructed = n;
+        T *src = array, *dst = buf.array;
+        for(size_t width = SortRun; width < n; width <<= 1){
+            pool.run(Blocks(n), [&](size_t blk){
+                size_t l = blk * Grain, r = l + Grain < n ? l + Grain : n;
+                //[l, r) 可能跨越多对归并段，逐对处理
+                while(l < r){
+                    size_t pairBegin = l / (width * 2) * (width * 2);
+                    size_t mid = pairBegin + width < n ? pairBegin + width : n;
+                    size_t pairEnd = mid + width < n ? mid + width : n;
+                    size_t end = r < pairEnd ? r : pairEnd;
+                    const T *a = src + pairBegin, *b = src + mid;
+                    size_t na = mid - pairBegin, nb = pairEnd - mid;
+                    size_t i0 = MergeSplit(a, na, b, nb, l - pairBegin, comp);
+                    size_t i1 = MergeSplit(a, na, b, nb, end - pairBegin, comp);
+                    MergeRange(a + i0, a + i1, b + (l - pairBegin - i0), b + (end - pairBegin - i1), dst + l, comp);
+                    l = end;
+                }
+            });
+            T *tmp = src; src = dst; dst = tmp;
+        }
+        if(src != array){
+            pool.run(Blocks(n), [&](size_t blk){
+                size_t l = blk * Grain, r = l + Grain < n ? l + Grain : n;
+                for(size_t i = l; i < r; ++i) array[i] = src[i];
+            });
+        }
+    }
+
+    /**
+     * 预留 n 个元素的空间，并按与其它并行算法相同的分块由线程池逐页写一次（first touch），
+     * 让物理页分配在处理对应块的线程所在的 NUMA 结点上。
+     * 工作窃取不保证块与线程一一对应，因此这只是尽力而为；只写入 size() 之后的空闲部分。
+     */
+    template<class T>
+    void parallel_reserve(thread_pool &pool, vector<T> &v, size_t n) {
+        v.reserve(n);
+        char *base = reinterpret_cast<char *>(v.data());
+        size_t from = v.size() * sizeof(T), to = n * sizeof(T);
+        if(from >= to) return;
+        const size_t PageSize = 4096;
+        pool.run(parallel_detail::Blocks(n), [&](size_t blk){
+            size_t l = blk * parallel_detail::Grain * sizeof(T), r = l + parallel_detail::Grain * sizeof(T);
+            if(l < from) l = from;
+            if(r > to) r = to;
+            for(size_t i = l; i < r; i = (i / PageSize + 1) * PageSize)
+                *reinterpret_cast<volatile char *>(base + i) = 0;
+        });
+    }
+
+    template<class T, class F>
+    void parallel_for_each(vector<T> &v, F f) {
+        parallel_for_each(thread_pool::global(), v, f);
+    }
+    template<class T, class U, class F>
+    void parallel_transform(const vector<T> &in, vector<U> &out, F f) {
+        parallel_transform(thread_pool::global(), in, out, f);
+    }
+    template<class T, class U, class BinaryOp>
+    U parallel_reduce(const vector<T> &v, U init, BinaryOp op) {
+        return parallel_reduce(thread_pool::global(), v, init, op);
+    }
+    template<class T, class U, class Fold, class Combine>
+    U parallel_reduce(const vector<T> &v, U identity, Fold fold, Combine combine) {
+        return parallel_reduce(thread_pool::global(), v, identity, fold, combine);
+    }
+    template<class T, class BinaryOp>
+    void parallel_inclusive_scan(vector<T> &v, BinaryOp op) {
+        parallel_inclusive_scan(thread_pool::global(), v, op);
+    }
+    template<class T, class BinaryOp>
+    void parallel_exclusive_scan(vector<T> &v, T init, BinaryOp op) {
+        parallel_exclusive_scan(thread_pool::global(), v, init, op);
+    }
+    template<class T, class Predicate>
+    size_t parallel_partition(vector<T> &v, Predicate pred) {
+        return parallel_partition(thread_pool::global(), v, pred);
+    }
+    template<class T, class Compare = std::less<T>>
+    void parallel_sort(vector<T> &v, Compare comp = Compare()) {
+        parallel_sort(thread_pool::global(), v, comp);
+    }
+    template<class T>
+    void parallel_reserve(vector<T> &v, size_t n) {
+        parallel_reserve(thread_pool::global(), v, n);
+    }
+
+}
+
+#endif
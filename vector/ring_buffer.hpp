@@ -0,0 +1,243 @@
+////有界无锁环形队列
+////spsc_ring_buffer：单生产者单消费者，头尾下标各占一条缓存行，
+////  每一端还缓存对端下标的旧值，只有看起来满 / 空时才去读对端的原子量。
+////mpmc_ring_buffer：多生产者多消费者，Dmitry Vyukov 的有界队列，
+////  每个槽位带一个序号，生产者与消费者各自用 CAS 抢下标。
+////元素存储与 vector 相同：malloc 出未初始化的内存，用 placement new 构造。
+////容量向上取整为 2 的幂；try_push / try_pop 不阻塞，push / pop 自旋等待。
+#ifndef SJTU_RING_BUFFER_HPP
+#define SJTU_RING_BUFFER_HPP
+
+#include "exceptions.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace sjtu
+{
+    namespace ring_buffer_detail {
+        const size_t CacheLine = 64;
+
+        inline size_t RoundUp(size_t n) {
+            size_t res = 1;
+            while(res < n) res <<= 1;
+            return res;
+        }
+    }
+
+    template<typename T>
+    class spsc_ring_buffer
+    {
+    private:
+        size_t cap;
+        T* array;
+        //消费者独占的缓存行
+        alignas(ring_buffer_detail::CacheLine) std::atomic<size_t> head{0};
+        size_t tailCache = 0;
+        //生产者独占的缓存行
+        alignas(ring_buffer_detail::CacheLine) std::atomic<size_t> tail{0};
+        size_t headCache = 0;
+
+        //队列满时不构造，参数保持原样
+        template<class V>
+        bool TryPush(V &&value) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if(t - headCache == cap){
+                headCache = head.load(std::memory_order_acquire);
+                if(t - headCache == cap) return false;
+            }
+            new (array + (t & (cap - 1))) T(std::forward<V>(value));
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+    public:
+        /**
+         * throw runtime_error if capacity == 0
+         */
+        explicit spsc_ring_buffer(size_t capacity) {
+            if(!capacity) throw runtime_error();
+            cap = ring_buffer_detail::RoundUp(capacity);
+            array = (T*)malloc(cap * sizeof(T));
+            if(!array) throw std::bad_alloc();
+        }
+        spsc_ring_buffer(const spsc_ring_buffer &) = delete;
+        spsc_ring_buffer &operator=(const spsc_ring_buffer &) = delete;
+        ~spsc_ring_buffer() {
+            size_t t = tail.load(std::memory_order_relaxed);
+            for(size_t i = head.load(std::memory_order_relaxed); i != t; ++i) array[i & (cap - 1)].~T();
+            free(array);
+        }
+        /**
+         * 仅生产者调用。队列满时返回 false
+         */
+        bool try_push(const T &value) {
+            return TryPush(value);
+        }
+        /**
+         * 仅生产者调用。队列满时返回 false 且 value 不被移动
+         */
+        bool try_push(T &&value) {
+            return TryPush(std::move(value));
+        }
+        /**
+         * 仅消费者调用。队列空时返回 false，否则把队首移到 out
+         */
+        bool try_pop(T &out) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h == tailCache){
+                tailCache = tail.load(std::memory_order_acquire);
+                if(h == tailCache) return false;
+            }
+            T *p = array + (h & (cap - 1));
+            out = std::move(*p);
+            p->~T();
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+        void push(const T &value) {
+            while(!try_push(value)) std::this_thread::yield();
+        }
+        void push(T &&value) {
+            while(!try_push(std::move(value))) std::this_thread::yield();
+        }
+        void pop(T &out) {
+            while(!try_pop(out)) std::this_thread::yield();
+        }
+        /**
+         * 仅消费者调用。throw container_is_empty if size == 0
+         */
+        const T & front() {
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h == tailCache){
+                tailCache = tail.load(std::memory_order_acquire);
+                if(h == tailCache) throw container_is_empty();
+            }
+            return array[h & (cap - 1)];
+        }
+        /**
+         * 并发读写时只是一个近似值
+         */
+        size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+        bool empty() const { return !size(); }
+        size_t capacity() const { return cap; }
+    };
+
+    template<typename T>
+    class mpmc_ring_buffer
+    {
+        //抢到下标之后的步骤不能失败，否则该槽位会永久阻塞后续的生产者 / 消费者
+        static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value,
+                      "mpmc_ring_buffer requires nothrow move construction and assignment");
+    private:
+        struct Cell {
+            std::atomic<size_t> seq;
+            alignas(T) unsigned char buf[sizeof(T)];
+            T *data() { return reinterpret_cast<T*>(buf); }
+        };
+        size_t cap;
+        Cell* cells;
+        alignas(ring_buffer_detail::CacheLine) std::atomic<size_t> enqueuePos{0};
+        alignas(ring_buffer_detail::CacheLine) std::atomic<size_t> dequeuePos{0};
+
+    public:
+        /**
+         * throw runtime_error if capacity == 0
+         */
+        explicit mpmc_ring_buffer(size_t capacity) {
+            if(!capacity) throw runtime_error();
+            cap = ring_buffer_detail::RoundUp(capacity < 2 ? 2 : capacity);
+            cells = (Cell*)malloc(cap * sizeof(Cell));
+            if(!cells) throw std::bad_alloc();
+            for(size_t i = 0; i < cap; ++i) new (&cells[i].seq) std::atomic<size_t>(i);
+        }
+        mpmc_ring_buffer(const mpmc_ring_buffer &) = delete;
+        mpmc_ring_buffer &operator=(const mpmc_ring_buffer &) = delete;
+        ~mpmc_ring_buffer() {
+            size_t e = enqueuePos.load(std::memory_order_relaxed);
+            for(size_t i = dequeuePos.load(std::memory_order_relaxed); i != e; ++i)
+                cells[i & (cap - 1)].data()->~T();
+            free(cells);
+        }
+        /**
+         * 队列满时返回 false
+         */
+        bool try_push(const T &value) {
+            T tmp(value); //可能抛异常的拷贝在抢下标之前完成
+            return try_push(std::move(tmp));
+        }
+        /**
+         * 抢到槽位后直接移动构造进去；队列满时返回 false 且 value 不被移动
+         */
+        bool try_push(T &&value) {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Cell *c;
+            while(true){
+                c = cells + (pos & (cap - 1));
+                size_t seq = c->seq.load(std::memory_order_acquire);
+                //seq == pos：槽位空闲；seq < pos：消费者还没取走上一圈的元素，队列满
+                if(seq == pos){
+                    if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                }
+                else if((ptrdiff_t)(seq - pos) < 0) return false;
+                else pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+            new (c->buf) T(std::move(value));
+            c->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+        /**
+         * 队列空时返回 false，否则把队首移到 out
+         */
+        bool try_pop(T &out) {
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            Cell *c;
+            while(true){
+                c = cells + (pos & (cap - 1));
+                size_t seq = c->seq.load(std::memory_order_acquire);
+                if(seq == pos + 1){
+                    if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                }
+                else if((ptrdiff_t)(seq - (pos + 1)) < 0) return false;
+                else pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+            out = std::move(*c->data());
+            c->data()->~T();
+            //下一圈的生产者看到 pos + cap 才能写入
+            c->seq.store(pos + cap, std::memory_order_release);
+            return true;
+        }
+        /**
+         * 只在进入自旋之前拷贝一次
+         */
+        void push(const T &value) {
+            T tmp(value);
+            push(std::move(tmp));
+        }
+        void push(T &&value) {
+            while(!try_push(std::move(value))) std::this_thread::yield();
+        }
+        void pop(T &out) {
+            while(!try_pop(out)) std::this_thread::yield();
+        }
+        /**
+         * 并发读写时只是一个近似值
+         */
+        size_t size() const {
+            size_t e = enqueuePos.load(std::memory_order_acquire), d = dequeuePos.load(std::memory_order_acquire);
+            return e > d ? e - d : 0;
+        }
+        bool empty() const { return !size(); }
+        size_t capacity() const { return cap; }
+    };
+
+}
+
+#endif
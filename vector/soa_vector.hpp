@@ -0,0 +1,231 @@
+////按列存储（structure of arrays）的容器
+////soa_vector<A, B, C> 把每个字段存进各自的 sjtu::vector，按行追加、按行遍历，
+////按列扫描时只读需要的那几列，每条缓存行都是有用的数据，编译器也容易向量化。
+////行用 std::tuple 的引用表示；各列长度始终相同，因此列只以 const 引用或裸指针形式暴露。
+#ifndef SJTU_SOA_VECTOR_HPP
+#define SJTU_SOA_VECTOR_HPP
+
+#include "vector.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <iterator>
+
+namespace sjtu
+{
+    template<typename... Ts>
+    class soa_vector
+    {
+        static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+    public:
+        typedef std::tuple<Ts...> value_type;
+        typedef std::tuple<Ts&...> reference;
+        typedef std::tuple<const Ts&...> const_reference;
+        template<size_t I>
+        using column_type = typename std::tuple_element<I, value_type>::type;
+
+    private:
+        std::tuple<vector<Ts>...> columns;
+        size_t num = 0;
+        static constexpr size_t ColumnNum = sizeof...(Ts);
+        typedef std::make_index_sequence<sizeof...(Ts)> Indices;
+
+        template<size_t... I>
+        reference Row(size_t pos, std::index_sequence<I...>) {
+            return reference(std::get<I>(columns).data()[pos]...);
+        }
+        template<size_t... I>
+        const_reference Row(size_t pos, std::index_sequence<I...>) const {
+            return const_reference(std::get<I>(columns).data()[pos]...);
+        }
+        //依次追加到各列；第 k 列抛异常时撤销前 k 列，各列长度保持一致。
+        //row 是 value_type 或各字段的 const 引用组成的 tuple，每个字段只拷贝一次
+        template<size_t K, class Tuple>
+        void PushFrom(const Tuple &row) {
+            if constexpr (K < ColumnNum) {
+                std::get<K>(columns).push_back(std::get<K>(row));
+                try{
+                    PushFrom<K + 1, Tuple>(row);
+                }catch(...){
+                    std::get<K>(columns).pop_back();
+                    throw;
+                }
+            }
+        }
+        template<size_t... I>
+        void PopAll(std::index_sequence<I...>) {
+            (std::get<I>(columns).pop_back(), ...);
+        }
+        template<size_t... I>
+        void ClearAll(std::index_sequence<I...>) {
+            (std::get<I>(columns).clear(), ...);
+        }
+        template<size_t... I>
+        void ReserveAll(size_t n, std::index_sequence<I...>) {
+            (std::get<I>(columns).reserve(n), ...);
+        }
+
+    public:
+        class const_iterator;
+        /**
+         * 行迭代器，解引用得到各字段引用组成的 tuple
+         */
+        class iterator
+        {
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = soa_vector::value_type;
+            using reference = soa_vector::reference;
+            using iterator_category = std::input_iterator_tag;
+
+        private:
+            size_t pos;
+            soa_vector* from;
+            friend class const_iterator;
+
+        public:
+            iterator() : pos(0), from(nullptr) {}
+            iterator(size_t tmp_pos, soa_vector* tmp_from) : pos(tmp_pos), from(tmp_from) {}
+            iterator operator+(const int &n) const { return iterator(pos + n, from); }
+            iterator operator-(const int &n) const { return iterator(pos - n, from); }
+            int operator-(const iterator &rhs) const {
+                if(from != rhs.from) throw invalid_iterator();
+                return (int)pos - (int)rhs.pos;
+            }
+            iterator& operator+=(const int &n) { pos += n; return *this; }
+            iterator& operator-=(const int &n) { pos -= n; return *this; }
+            iterator operator++(int) { iterator tmp(*this); pos++; return tmp; }
+            iterator& operator++() { pos++; return *this; }
+            iterator operator--(int) { iterator tmp(*this); pos--; return tmp; }
+            iterator& operator--() { pos--; return *this; }
+            reference operator*() const {
+                if(!from || pos >= from->num) throw invalid_iterator();
+                return from->Row(pos, Indices());
+            }
+            bool operator==(const iterator &rhs) const { return from == rhs.from && pos == rhs.pos; }
+            bool operator==(const const_iterator &rhs) const { return from == rhs.from && pos == rhs.pos; }
+            bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+            bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+        };
+        class const_iterator
+        {
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = soa_vector::value_type;
+            using reference = soa_vector::const_reference;
+            using iterator_category = std::input_iterator_tag;
+
+        private:
+            size_t pos;
+            const soa_vector* from;
+            friend class iterator;
+
+        public:
+            const_iterator() : pos(0), from(nullptr) {}
+            const_iterator(size_t tmp_pos, const soa_vector* tmp_from) : pos(tmp_pos), from(tmp_from) {}
+            const_iterator(const iterator &rhs) : pos(rhs.pos), from(rhs.from) {}
+            const_iterator operator+(const int &n) const { return const_iterator(pos + n, from); }
+            const_iterator operator-(const int &n) const { return const_iterator(pos - n, from); }
+            int operator-(const const_iterator &rhs) const {
+                if(from != rhs.from) throw invalid_iterator();
+                return (int)pos - (int)rhs.pos;
+            }
+            const_iterator& operator+=(const int &n) { pos += n; return *this; }
+            const_iterator& operator-=(const int &n) { pos -= n; return *this; }
+            const_iterator operator++(int) { const_iterator tmp(*this); pos++; return tmp; }
+            const_iterator& operator++() { pos++; return *this; }
+            const_iterator operator--(int) { const_iterator tmp(*this); pos--; return tmp; }
+            const_iterator& operator--() { pos--; return *this; }
+            reference operator*() const {
+                if(!from || pos >= from->num) throw invalid_iterator();
+                return from->Row(pos, Indices());
+            }
+            bool operator==(const iterator &rhs) const { return from == rhs.from && pos == rhs.pos; }
+            bool operator==(const const_iterator &rhs) const { return from == rhs.from && pos == rhs.pos; }
+            bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+            bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+        };
+
+        soa_vector() {}
+
+        /**
+         * 第 pos 行各字段的引用
+         * throw index_out_of_bound if pos is not in [0, size)
+         */
+        reference operator[](const size_t &pos) {
+            if(pos >= num) throw index_out_of_bound();
+            return Row(pos, Indices());
+        }
+        const_reference operator[](const size_t &pos) const {
+            if(pos >= num) throw index_out_of_bound();
+            return Row(pos, Indices());
+        }
+        reference at(const size_t &pos) { return (*this)[pos]; }
+        const_reference at(const size_t &pos) const { return (*this)[pos]; }
+        /**
+         * 第 pos 行的第 I 个字段
+         */
+        template<size_t I>
+        column_type<I> & get(const size_t &pos) {
+            if(pos >= num) throw index_out_of_bound();
+            return std::get<I>(columns).data()[pos];
+        }
+        template<size_t I>
+        const column_type<I> & get(const size_t &pos) const {
+            if(pos >= num) throw index_out_of_bound();
+            return std::get<I>(columns).data()[pos];
+        }
+        /**
+         * 第 I 列，只读；按列扫描时用 column_data 拿到连续数组
+         */
+        template<size_t I>
+        const vector<column_type<I>> & column() const {
+            return std::get<I>(columns);
+        }
+        template<size_t I>
+        column_type<I> * column_data() {
+            return std::get<I>(columns).data();
+        }
+        template<size_t I>
+        const column_type<I> * column_data() const {
+            return std::get<I>(columns).data();
+        }
+
+        iterator begin() { return iterator(0, this); }
+        const_iterator cbegin() const { return const_iterator(0, this); }
+        iterator end() { return iterator(num, this); }
+        const_iterator cend() const { return const_iterator(num, this); }
+        bool empty() const { return !num; }
+        size_t size() const { return num; }
+        void clear() {
+            ClearAll(Indices());
+            num = 0;
+        }
+        void reserve(size_t n) {
+            ReserveAll(n, Indices());
+        }
+        /**
+         * 追加一整行
+         */
+        void push_back(const Ts &... fields) {
+            PushFrom<0>(std::forward_as_tuple(fields...));
+            num++;
+        }
+        void push_back(const value_type &row) {
+            PushFrom<0>(row);
+            num++;
+        }
+        /**
+         * throw container_is_empty if size() == 0
+         */
+        void pop_back() {
+            if(!num) throw container_is_empty();
+            PopAll(Indices());
+            num--;
+        }
+    };
+
+}
+
+#endif
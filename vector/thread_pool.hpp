@@ -0,0 +1,175 @@
+////工作窃取线程池
+////每个工作线程有自己的任务队列，从队尾取自己的任务，空闲时从其它队列的队首窃取。
+////run(n, f) 把 f(0) ... f(n - 1) 作为 n 个任务提交并阻塞到全部完成；
+////等待期间调用线程也会执行任务，因此任务内部可以嵌套调用 run 而不会死锁。
+#ifndef SJTU_THREAD_POOL_HPP
+#define SJTU_THREAD_POOL_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace sjtu {
+
+    class thread_pool {
+    private:
+        struct Group {
+            std::atomic<size_t> remaining;
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+            explicit Group(size_t n) : remaining(n) {}
+        };
+        struct Task {
+            void (*fn)(void *, size_t);
+            void *ctx;
+            size_t index;
+            Group *group;
+        };
+        //每个队列独占缓存行，避免相邻队列的锁互相干扰
+        struct alignas(64) Queue {
+            std::mutex lock;
+            std::deque<Task> tasks;
+        };
+
+        size_t workerNum;
+        std::thread *workers;
+        Queue *queues; //0 .. workerNum - 1 属于工作线程，workerNum 供外部线程提交
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> stop{false};
+        std::mutex sleepLock;
+        std::condition_variable wake;
+
+        static thread_pool *&CurrentPool() {
+            static thread_local thread_pool *pool = nullptr;
+            return pool;
+        }
+        static size_t &CurrentIndex() {
+            static thread_local size_t index = 0;
+            return index;
+        }
+        size_t MyQueue() const {
+            return CurrentPool() == this ? CurrentIndex() : workerNum;
+        }
+        bool Pop(size_t q, Task &t, bool back) {
+            std::lock_guard<std::mutex> guard(queues[q].lock);
+            if(queues[q].tasks.empty()) return false;
+            if(back){
+                t = queues[q].tasks.back();
+                queues[q].tasks.pop_back();
+            }
+            else{
+                t = queues[q].tasks.front();
+                queues[q].tasks.pop_front();
+            }
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        //先取自己队列的队尾（最近提交、缓存最热），再依次窃取其它队列的队首（最早提交、粒度最大）
+        bool TryRun(size_t self) {
+            Task t;
+            bool got = Pop(self, t, true);
+            for(size_t i = 1; !got && i <= workerNum; ++i)
+                got = Pop((self + i) % (workerNum + 1), t, false);
+            if(!got) return false;
+            if(!t.group->failed.load(std::memory_order_relaxed)){
+                try{
+                    t.fn(t.ctx, t.index);
+                }catch(...){
+                    //只保留第一个异常，同组其余尚未开始的任务直接跳过
+                    if(!t.group->failed.exchange(true))
+                        t.group->error = std::current_exception();
+                }
+            }
+            t.group->remaining.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+        void WorkerLoop(size_t id) {
+            CurrentPool() = this;
+            CurrentIndex() = id;
+            while(!stop.load(std::memory_order_acquire)){
+                if(TryRun(id)) continue;
+                std::unique_lock<std::mutex> guard(sleepLock);
+                wake.wait(guard, [this]{
+                    return stop.load(std::memory_order_acquire) || pending.load(std::memory_order_relaxed) > 0;
+                });
+            }
+        }
+        template<class F>
+        static void Invoke(void *ctx, size_t i) {
+            (*static_cast<F *>(ctx))(i);
+        }
+    public:
+        /**
+         * threads 为线程总数（含调用线程），0 表示取硬件线程数
+         */
+        explicit thread_pool(size_t threads = 0) {
+            if(!threads) threads = std::thread::hardware_concurrency();
+            if(!threads) threads = 1;
+            workerNum = threads - 1;
+            queues = new Queue[workerNum + 1];
+            workers = new std::thread[workerNum];
+            for(size_t i = 0; i < workerNum; ++i)
+                workers[i] = std::thread(&thread_pool::WorkerLoop, this, i);
+        }
+        thread_pool(const thread_pool &) = delete;
+        thread_pool &operator = (const thread_pool &) = delete;
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                stop.store(true, std::memory_order_release);
+            }
+            wake.notify_all();
+            for(size_t i = 0; i < workerNum; ++i)
+                workers[i].join();
+            delete []workers;
+            delete []queues;
+        }
+        /**
+         * 线程总数（含调用线程）
+         */
+        size_t size() const {
+            return workerNum + 1;
+        }
+        /**
+         * 并行执行 f(0) ... f(n - 1)，全部完成后返回；任务抛出的第一个异常在这里重新抛出
+         */
+        template<class F>
+        void run(size_t n, F f) {
+            if(!n) return;
+            if(n == 1 || !workerNum){
+                for(size_t i = 0; i < n; ++i) f(i);
+                return;
+            }
+            Group group(n);
+            size_t q = MyQueue();
+            {
+                std::lock_guard<std::mutex> guard(queues[q].lock);
+                //倒序入队：自己从队尾先取到 f(0)，窃取者从队首拿走编号大的任务
+                for(size_t i = n; i-- > 0; )
+                    queues[q].tasks.push_back(Task{&Invoke<F>, &f, i, &group});
+                pending.fetch_add(n, std::memory_order_relaxed);
+            }
+            {
+                std::lock_guard<std::mutex> guard(sleepLock);
+            }
+            wake.notify_all();
+            while(group.remaining.load(std::memory_order_acquire))
+                if(!TryRun(q)) std::this_thread::yield();
+            if(group.error) std::rethrow_exception(group.error);
+        }
+        /**
+         * 进程内共享的默认线程池，首次使用时按硬件线程数创建
+         */
+        static thread_pool &global() {
+            static thread_pool pool;
+            return pool;
+        }
+    };
+
+}
+
+#endif
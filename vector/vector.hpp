@@ -2,9 +2,29 @@
 #define SJTU_VECTOR_HPP
 
 #include "exceptions.hpp"
+#include "instrument.hpp"
 
 #include <climits>
 #include <cstddef>
+#include <cstdlib>
+#include <type_traits>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+//元素可平凡复制且容量不小于该字节数时，存储改用匿名 mmap 并申请透明大页，
+//扩容用 mremap 原地增长（必要时由内核搬移页表），不再逐个拷贝元素。定义为 0 可关闭。
+#ifndef SJTU_VECTOR_MMAP_THRESHOLD
+#define SJTU_VECTOR_MMAP_THRESHOLD (32u << 20)
+#endif
+
+//加固模式：vector 记录一个代数，重新分配和结构修改（insert / erase / pop_back / clear / 赋值）时加一，
+//迭代器创建时记下代数，解引用和算术运算时 O(1) 比对，过期或越界即抛 invalid_iterator。
+//默认关闭，此时迭代器只有指针，不做任何额外检查。
+#ifndef SJTU_VECTOR_HARDENED
+#define SJTU_VECTOR_HARDENED 0
+#endif
 
 namespace sjtu
 {
@@ -19,6 +39,58 @@ namespace sjtu
         size_t cap;
         size_t cur;
         T* array;
+#if SJTU_VECTOR_HARDENED
+        size_t generation = 0;
+#endif
+        void BumpGeneration() {
+#if SJTU_VECTOR_HARDENED
+            ++generation;
+#endif
+        }
+
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+        static bool Mapped(size_t c) {
+            return SJTU_VECTOR_MMAP_THRESHOLD && std::is_trivially_copyable<T>::value &&
+                   c * sizeof(T) >= (size_t) SJTU_VECTOR_MMAP_THRESHOLD;
+        }
+        static T *Allocate(size_t c) {
+            if(!c) return nullptr; //容量为 0 的 vector 不申请内存
+            if(!Mapped(c)) return (T*)malloc(c * sizeof(T));
+            void *p = mmap(nullptr, c * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(p == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            madvise(p, c * sizeof(T), MADV_HUGEPAGE);
+#endif
+            return (T*)p;
+        }
+        static void Deallocate(T *p, size_t c) {
+            if(Mapped(c)) munmap(p, c * sizeof(T));
+            else free(p);
+        }
+        //新旧容量都走 mmap 时用 mremap 增长，返回 false 表示需要重新分配并拷贝
+        bool Remap(size_t new_cap) {
+            if(!Mapped(cap) || !Mapped(new_cap)) return false;
+            void *p = mremap(array, cap * sizeof(T), new_cap * sizeof(T), MREMAP_MAYMOVE);
+            if(p == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            madvise(p, new_cap * sizeof(T), MADV_HUGEPAGE);
+#endif
+            array = (T*)p;
+            cap = new_cap;
+            return true;
+        }
+#else
+        static T *Allocate(size_t c) {
+            if(!c) return nullptr; //容量为 0 的 vector 不申请内存
+            return (T*)malloc(c * sizeof(T));
+        }
+        static void Deallocate(T *p, size_t) {
+            free(p);
+        }
+        bool Remap(size_t) {
+            return false;
+        }
+#endif
     public:
         /**
          * TODO
@@ -56,43 +128,65 @@ namespace sjtu
              */
             T* p;
             const vector* from;
+#if SJTU_VECTOR_HARDENED
+            size_t gen = 0;
+#endif
+            friend class const_iterator;
+            //加固模式下检查迭代器是否在重新分配或结构修改之前创建
+            void Validate() const {
+#if SJTU_VECTOR_HARDENED
+                if(!from || gen != from->generation) throw invalid_iterator();
+#endif
+            }
+            void ValidateAccess() const {
+#if SJTU_VECTOR_HARDENED
+                Validate();
+                if(p < from->array || p >= from->array + from->cur) throw invalid_iterator();
+#endif
+            }
 
         public:
             iterator() : p(nullptr), from(nullptr) {}
             iterator(T* tmp_p, const vector* tmp_from){
                 p = tmp_p;
                 from = tmp_from;
+#if SJTU_VECTOR_HARDENED
+                if(from) gen = from->generation;
+#endif
             }
-            iterator(const iterator& rhs){
-                p = rhs.p;
-                from = rhs.from;
-            }
+            iterator(const iterator& rhs) = default;
             /**
              * return a new iterator which pointer n-next elements
              * as well as operator-
              */
             iterator operator+(const int &n) const
             {
+                Validate();
                 return iterator(p + n, from);
             }
             iterator operator-(const int &n) const
             {
+                Validate();
                 return iterator(p - n, from);
             }
             // return the distance between two iterators,
             // if these two iterators point to different vectors, throw invaild_iterator.
             int operator-(const iterator &rhs) const
             {
+                Validate();
+                rhs.Validate();
                 if(from != rhs.from) throw invalid_iterator();
                 else return abs(p - rhs.p);
             }
             iterator& operator+=(const int &n)
             {
+                Validate();
                 p += n;
                 return *this;
             }
             iterator& operator-=(const int &n)
             {
+                Validate();
                 p -= n;
                 return *this;
             }
@@ -100,6 +194,7 @@ namespace sjtu
              * TODO iter++
              */
             iterator operator++(int) {
+                Validate();
                 iterator tmp(*this);
                 p++;
                 return tmp;
@@ -108,6 +203,7 @@ namespace sjtu
              * TODO ++iter
              */
             iterator& operator++() {
+                Validate();
                 p++;
                 return *this;
             }
@@ -115,6 +211,7 @@ namespace sjtu
              * TODO iter--
              */
             iterator operator--(int) {
+                Validate();
                 iterator tmp(*this);
                 p--;
                 return tmp;
@@ -123,6 +220,7 @@ namespace sjtu
              * TODO --iter
              */
             iterator& operator--() {
+                Validate();
                 p--;
                 return *this;
             }
@@ -130,6 +228,7 @@ namespace sjtu
              * TODO *it
              */
             T& operator*() const{
+                ValidateAccess();
                 return *p;
             }
             /**
@@ -168,48 +267,71 @@ namespace sjtu
             /*TODO*/
             const T* p;
             const vector* from;
+#if SJTU_VECTOR_HARDENED
+            size_t gen = 0;
+#endif
+            //加固模式下检查迭代器是否在重新分配或结构修改之前创建
+            void Validate() const {
+#if SJTU_VECTOR_HARDENED
+                if(!from || gen != from->generation) throw invalid_iterator();
+#endif
+            }
+            void ValidateAccess() const {
+#if SJTU_VECTOR_HARDENED
+                Validate();
+                if(p < from->array || p >= from->array + from->cur) throw invalid_iterator();
+#endif
+            }
         public:
             const_iterator() : p(nullptr), from(nullptr){}
-            const_iterator(T* tmp_p, const vector* tmp_from){
+            const_iterator(const T* tmp_p, const vector* tmp_from){
                 p = tmp_p;
                 from = tmp_from;
+#if SJTU_VECTOR_HARDENED
+                if(from) gen = from->generation;
+#endif
             }
-            const_iterator(const const_iterator& rhs){
-                p = rhs.p;
-                from = rhs.from;
-            }
+            const_iterator(const const_iterator& rhs) = default;
 
             const_iterator operator+(const int &n) const
             {
+                Validate();
                 return const_iterator(p + n, from);
             }
             const_iterator operator-(const int &n) const
             {
+                Validate();
                 return const_iterator(p - n, from);
             }
             int operator-(const iterator &rhs) const
             {
+                Validate();
+                rhs.Validate();
                 if(from != rhs.from) throw invalid_iterator();
                 else return abs(p - rhs.p);
             }
             const_iterator& operator+=(const int &n)
             {
+                Validate();
                 p += n;
                 return *this;
             }
             const_iterator& operator-=(const int &n)
             {
+                Validate();
                 p -= n;
                 return *this;
             }
 
             const_iterator operator++(int) {
+                Validate();
                 const_iterator tmp(*this);
                 p++;
                 return tmp;
             }
 
             const_iterator& operator++() {
+                Validate();
                 p++;
                 return *this;
             }
@@ -217,6 +339,7 @@ namespace sjtu
              * TODO iter--
              */
             const_iterator operator--(int) {
+                Validate();
                 const_iterator tmp(*this);
                 p--;
                 return tmp;
@@ -225,6 +348,7 @@ namespace sjtu
              * TODO --iter
              */
             const_iterator& operator--() {
+                Validate();
                 p--;
                 return *this;
             }
@@ -232,6 +356,7 @@ namespace sjtu
              * TODO *it
              */
             const T operator*() const{
+                ValidateAccess();
                 return *p;
             }
             /**
@@ -260,12 +385,12 @@ namespace sjtu
         vector(size_t num = 10) {
             cur = 0;
             cap = num;
-            array = (T*)malloc(cap * sizeof(T));
+            array = Allocate(cap);
         }
         vector(const vector &other) {
             cur = other.cur;
             cap = other.cap;
-            array = (T*)malloc(cap * sizeof(T));
+            array = Allocate(cap);
             for(size_t i = 0; i < cur; ++i){
                 new (array + i) T(other[i]);//不能直接赋值 要用拷贝构造函数
                 //array[i] = other[i];
@@ -277,7 +402,7 @@ namespace sjtu
         ~vector() {
             if(array != nullptr){
                 for(int i = 0; i < cur; ++i) array[i].~T(); //显示调用析构函数
-                free(array);
+                Deallocate(array, cap);
             }
         }
         /**
@@ -286,10 +411,11 @@ namespace sjtu
         vector &operator=(const vector &other) {
             if(&other != this){
                 for(int i = 0; i < cur; ++i) array[i].~T();
-                free(array);
+                Deallocate(array, cap);
+                BumpGeneration();
                 cur = other.cur;
                 cap = other.cap;
-                array = (T*)malloc(cap * sizeof(T));
+                array = Allocate(cap);
                 for(size_t i = 0; i < cur; ++i){
                     new (array + i) T(other[i]);
                     //array[i] = other[i];
@@ -339,6 +465,11 @@ namespace sjtu
             if(!cur) throw container_is_empty();
             return array[cur - 1];
         }
+        /**
+         * direct access to the underlying contiguous storage, [data(), data() + size()) is valid
+         */
+        T * data() { return array; }
+        const T * data() const { return array; }
         /**
          * returns an iterator to the beginning.
          */
@@ -365,32 +496,52 @@ namespace sjtu
          * returns the number of elements
          */
         size_t size() const { return cur; }
+        /**
+         * returns the number of elements that can be held without reallocation
+         * (one slot of the allocation is always left spare)
+         */
+        size_t capacity() const { return cap ? cap - 1 : 0; }
+        /**
+         * makes room for at least n elements, existing elements and size are unchanged
+         */
+        void reserve(size_t n) {
+            if(n && n + 1 > cap) Reallocate(n + 1);
+        }
         /**
          * clears the contents
          */
         void clear() {
             for(int i = 0; i < cur; ++i) array[i].~T();
             cur = 0;
+            BumpGeneration();
         }
-        /**
-         * inserts value before pos
-         * returns an iterator pointing to the inserted value.
-         */
-        void DoubleSpace(){
-            size_t new_cap = cap * 2;
-            T* NewSpace = (T*)malloc(new_cap * sizeof(T));
+        void Reallocate(size_t new_cap){
+            SJTU_INSTRUMENT_ADD(vector_reallocations, 1);
+            BumpGeneration(); //mremap 也可能搬移地址
+            if(Remap(new_cap)) return;
+            T* NewSpace = Allocate(new_cap);
+            SJTU_INSTRUMENT_ADD(vector_element_moves, cur);
             for(int i = 0; i < cur; ++i) new (NewSpace + i) T(array[i]);
             for(int i = 0; i < cur; ++i) array[i].~T();
-            free(array);
+            Deallocate(array, cap);
             array = NewSpace;
             cap = new_cap;
         }
+        void DoubleSpace(){
+            Reallocate(cap ? cap * 2 : 2);
+        }
+        /**
+         * inserts value before pos
+         * returns an iterator pointing to the inserted value.
+         */
         iterator insert(iterator pos, const T &value) {
             size_t arr_pos = pos - begin();
-            if(cur + 1 == cap) DoubleSpace();//留一个尾元素
+            if(cur + 1 >= cap) DoubleSpace();//留一个尾元素
             cur++;
+            SJTU_INSTRUMENT_ADD(vector_element_moves, cur - 1 - arr_pos);
             for(size_t i = cur - 1; i > arr_pos; --i) array[i] = array[i - 1];
             array[arr_pos] = value;
+            BumpGeneration();
             return iterator(array + arr_pos, this);
         }
         /**
@@ -401,10 +552,12 @@ namespace sjtu
          */
         iterator insert(const size_t &ind, const T &value) {
             if(ind > cur) throw index_out_of_bound();
-            if(cur + 1 == cap) DoubleSpace();
+            if(cur + 1 >= cap) DoubleSpace();
             cur++;
+            SJTU_INSTRUMENT_ADD(vector_element_moves, cur - 1 - ind);
             for(size_t i = cur - 1; i > ind; --i) array[i] = array[i - 1];
             array[ind] = value;
+            BumpGeneration();
             return iterator(array + ind, this);
         }
         /**
@@ -416,7 +569,9 @@ namespace sjtu
             size_t arr_pos = pos - begin();
             array[arr_pos].~T();
             cur--;
+            SJTU_INSTRUMENT_ADD(vector_element_moves, cur - arr_pos);
             for(size_t i = arr_pos; i < cur; ++i) array[i] = array[i + 1];
+            BumpGeneration();
             return iterator(array + arr_pos, this);
         }
         /**
@@ -428,14 +583,16 @@ namespace sjtu
             if(ind >= cur) throw index_out_of_bound();
             array[ind].~T();
             cur--;
+            SJTU_INSTRUMENT_ADD(vector_element_moves, cur - ind);
             for(size_t i = ind; i < cur; ++i) array[i] = array[i + 1];
+            BumpGeneration();
             return iterator(array + ind, this);
         }
         /**
          * adds an element to the end.
          */
         void push_back(const T &value) {
-            if(cur + 1 == cap) DoubleSpace();
+            if(cur + 1 >= cap) DoubleSpace();
             new (array + cur) T(value);
             ++cur;
         }
@@ -446,6 +603,7 @@ namespace sjtu
         void pop_back() {
             if(empty()) throw container_is_empty();
             array[--cur].~T();
+            BumpGeneration();
         }
     };
 
@@ -0,0 +1,98 @@
+////sjtu::vector 的二进制镜像：文件头之后紧跟元素数组
+////vector_image_writer 顺序追加元素，mapped_vector 以只读、零拷贝的方式打开镜像。
+#ifndef SJTU_VECTOR_IMAGE_HPP
+#define SJTU_VECTOR_IMAGE_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include "vector.hpp"
+#include "mapped_file.hpp"
+
+namespace sjtu {
+
+    template<typename T>
+    class vector_image_writer {
+        static_assert(std::is_trivially_copyable<T>::value, "vector image requires a trivially copyable element type");
+    private:
+        image_writer out;
+    public:
+        explicit vector_image_writer(const char *path) {
+            out.header.init(VECTOR_IMAGE, 0, sizeof(T), sizeof(T));
+            out.open(path);
+        }
+        void push_back(const T &value) {
+            out.write(&value, sizeof(T));
+            out.header.count++;
+        }
+        void write(const T *first, size_t n) {
+            out.write(first, n * sizeof(T));
+            out.header.count += n;
+        }
+        size_t size() const {
+            return out.header.count;
+        }
+        /**
+         * 回填文件头并关闭文件，之后镜像才能被打开；未调用 finish 就析构时文件被删除
+         */
+        void finish() {
+            out.finish();
+        }
+    };
+
+    template<typename T>
+    void write_image(const vector<T> &v, const char *path) {
+        vector_image_writer<T> w(path);
+        if(!v.empty())
+            w.write(&v[0], v.size());
+        w.finish();
+    }
+
+    /**
+     * 只读的 vector 镜像视图，元素直接引用映射的内存
+     */
+    template<typename T>
+    class mapped_vector {
+        static_assert(std::is_trivially_copyable<T>::value, "vector image requires a trivially copyable element type");
+    private:
+        mapped_file file;
+        const T *array = nullptr;
+        size_t cur = 0;
+    public:
+        typedef const T *const_iterator;
+
+        mapped_vector() {}
+        explicit mapped_vector(const char *path) {
+            open(path);
+        }
+        void open(const char *path) {
+            file.open(path);
+            const image_header &h = file.header(VECTOR_IMAGE, 0, sizeof(T), sizeof(T), alignof(T));
+            array = reinterpret_cast<const T *>(file.data() + h.data_offset);
+            cur = h.count;
+        }
+        const T & at(const size_t &pos) const {
+            if(pos >= cur) throw index_out_of_bound();
+            return array[pos];
+        }
+        const T & operator[](const size_t &pos) const {
+            if(pos >= cur) throw index_out_of_bound();
+            return array[pos];
+        }
+        const T & front() const {
+            if(!cur) throw container_is_empty();
+            return array[0];
+        }
+        const T & back() const {
+            if(!cur) throw container_is_empty();
+            return array[cur - 1];
+        }
+        const T *data() const { return array; }
+        const_iterator cbegin() const { return array; }
+        const_iterator cend() const { return array + cur; }
+        bool empty() const { return !cur; }
+        size_t size() const { return cur; }
+    };
+
+}
+
+#endif